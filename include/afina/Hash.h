@@ -0,0 +1,72 @@
+#ifndef AFINA_HASH_H
+#define AFINA_HASH_H
+
+#include <cstddef>
+#include <cstdint>
+#include <cstring>
+#include <string>
+
+#ifdef __SSE4_2__
+#include <nmmintrin.h>
+#endif
+
+namespace Afina {
+
+namespace detail {
+
+// Finalizer of MurmurHash3: spreads every input bit over the whole word, bijective
+inline uint64_t hash_mix(uint64_t h) {
+    h ^= h >> 33;
+    h *= 0xff51afd7ed558ccdULL;
+    h ^= h >> 33;
+    h *= 0xc4ceb9fe1a85ec53ULL;
+    h ^= h >> 33;
+    return h;
+}
+
+inline uint64_t hash_load(const char *data, size_t size) {
+    uint64_t word = 0;
+    std::memcpy(&word, data, size);
+    return word;
+}
+
+} // namespace detail
+
+/**
+ * # Hash of the key shared by all the layers
+ * Parser computes it once per key, commands pass it to the storage and storage uses it for shard selection,
+ * index probing and eviction policy, so key is never rehashed on its way. Every storage expects exactly this
+ * function of the key whenever it is given a hash.
+ *
+ * Key is folded by SSE4.2 CRC32C instruction where available and by multiply-xorshift rounds otherwise, both
+ * take 8 bytes per step. Result is mixed, so every bit of it depends on every bit of the key: callers are free
+ * to take any bits they need.
+ */
+inline size_t Hash(const char *data, size_t size) {
+    uint64_t h;
+#ifdef __SSE4_2__
+    uint64_t crc = 0xFFFFFFFF;
+    size_t i = 0;
+    for (; i + 8 <= size; i += 8) {
+        crc = _mm_crc32_u64(crc, detail::hash_load(data + i, 8));
+    }
+    if (i < size) {
+        crc = _mm_crc32_u64(crc, detail::hash_load(data + i, size - i));
+    }
+    // CRC has 32 bits only, so length is added to tell apart keys different in trailing zero bytes
+    h = crc | uint64_t(size) << 32;
+#else
+    h = 0x9E3779B97F4A7C15ULL ^ size;
+    for (size_t i = 0; i < size; i += 8) {
+        h = (h ^ detail::hash_load(data + i, size - i < 8 ? size - i : 8)) * 0xbf58476d1ce4e5b9ULL;
+        h ^= h >> 31;
+    }
+#endif
+    return detail::hash_mix(h);
+}
+
+inline size_t Hash(const std::string &key) { return Hash(key.data(), key.size()); }
+
+} // namespace Afina
+
+#endif // AFINA_HASH_H
@@ -1,12 +1,62 @@
 #ifndef AFINA_STORAGE_H
 #define AFINA_STORAGE_H
 
+#include <cstddef>
+#include <cstdint>
 #include <string>
+#include <utility>
+#include <vector>
+
+#include <afina/Value.h>
 
 namespace Afina {
 
 /**
- *
+ * # Storage counters reported by the stats command
+ */
+struct StorageStats {
+    // Get requests which have found the key and which have not
+    uint64_t get_hits = 0;
+    uint64_t get_misses = 0;
+
+    // Live entries removed to free memory for the new ones
+    uint64_t evictions = 0;
+
+    uint64_t curr_items = 0;
+
+    // Size of all keys and values stored and its upper bound
+    uint64_t bytes = 0;
+    uint64_t limit_maxbytes = 0;
+};
+
+/**
+ * # Outcome of the counter update
+ */
+enum class CounterStatus : uint8_t {
+    Done,
+    // Key is not present in the storage
+    NotFound,
+    // Value of the key is not a decimal unsigned 64 bit number
+    NotNumeric
+};
+
+/**
+ * # Outcome of the compare and set
+ */
+enum class CasStatus : uint8_t {
+    Stored,
+    // Value is too large to be stored
+    NotStored,
+    // Value of the key has been changed since its version was read
+    Exists,
+    // Key is not present in the storage
+    NotFound
+};
+
+/**
+ * # Key-value storage
+ * Every operation has an overload which takes hash of the key computed by Afina::Hash, so callers who already
+ * know it save storage from hashing the key again. By default these overloads just ignore the hash.
  */
 class Storage {
 public:
@@ -27,8 +77,9 @@ public:
      *
      * @param key to be associated with value
      * @param value to be assigned for the key
+     * @param expire_at absolute unix time in seconds when association expires, 0 means never
      */
-    virtual bool Put(const std::string &key, const std::string &value) = 0;
+    virtual bool Put(const std::string &key, const std::string &value, uint32_t expire_at = 0) = 0;
 
     /**
      * Stores association between given key/value pair if key isn't present in
@@ -40,8 +91,9 @@ public:
      *
      * @param key to be associated with value
      * @param value to be assigned for the key
+     * @param expire_at absolute unix time in seconds when association expires, 0 means never
      */
-    virtual bool PutIfAbsent(const std::string &key, const std::string &value) = 0;
+    virtual bool PutIfAbsent(const std::string &key, const std::string &value, uint32_t expire_at = 0) = 0;
 
     /**
      * Updates existing association between given key/value pair
@@ -53,8 +105,9 @@ public:
      *
      * @param key to be associated with value
      * @param value to be assigned for the key
+     * @param expire_at absolute unix time in seconds when association expires, 0 means never
      */
-    virtual bool Set(const std::string &key, const std::string &value) = 0;
+    virtual bool Set(const std::string &key, const std::string &value, uint32_t expire_at = 0) = 0;
 
     /**
      * Removes association for the given key
@@ -78,12 +131,194 @@ public:
      * into given output parameter (possibly extends its size) and return true
      *
      * In case if given key not found method returns false and doesn't perform
-     * any changes on the output parameter
+     * any changes on the output parameter. Expired associations are never found
      *
      * @param key to retrive1 value for
      * @param value output parameter to copy value to
      */
     virtual bool Get(const std::string &key, std::string &value) = 0;
+
+    /**
+     * Fills storage counters, implementation could leave untouched ones it doesn't track
+     *
+     * @param stats output parameter
+     */
+    virtual void GetStats(StorageStats &stats) {}
+
+    /**
+     * Offers the calling thread, which must be pinned to the given core, to serve storage requests of that core
+     * from its own event loop. Storage which keeps per core state returns descriptor to watch: thread must call
+     * Serve once it is readable and also when thread has been idle for a while, storage does its maintenance
+     * then. Requests issued by the attached thread to its own core run in place. Returns -1 if there is nothing
+     * to serve on the core, by default storage doesn't need any thread
+     *
+     * @param core thread is pinned to
+     */
+    virtual int Attach(size_t core) { return -1; }
+
+    /**
+     * Executes requests waiting for the core of the calling thread, see Attach
+     */
+    virtual void Serve() {}
+
+    /**
+     * Takes core back from the calling thread, thread must call it before it stops if Attach has succeeded
+     */
+    virtual void Detach() {}
+
+    /**
+     * Same as the ones above, hash must be Afina::Hash(key)
+     */
+    virtual bool Put(const std::string &key, size_t hash, const std::string &value, uint32_t expire_at = 0) {
+        return Put(key, value, expire_at);
+    }
+
+    virtual bool PutIfAbsent(const std::string &key, size_t hash, const std::string &value, uint32_t expire_at = 0) {
+        return PutIfAbsent(key, value, expire_at);
+    }
+
+    virtual bool Set(const std::string &key, size_t hash, const std::string &value, uint32_t expire_at = 0) {
+        return Set(key, value, expire_at);
+    }
+
+    virtual bool Delete(const std::string &key, size_t hash) { return Delete(key); }
+
+    virtual bool Get(const std::string &key, size_t hash, std::string &value) { return Get(key, value); }
+
+    /**
+     * Same as the ones above, but storage could keep the given buffer instead of copying the value. By default
+     * value is copied
+     */
+    virtual bool Put(const std::string &key, size_t hash, Value value, uint32_t expire_at = 0) {
+        return Put(key, hash, value.str(), expire_at);
+    }
+
+    virtual bool PutIfAbsent(const std::string &key, size_t hash, Value value, uint32_t expire_at = 0) {
+        return PutIfAbsent(key, hash, value.str(), expire_at);
+    }
+
+    virtual bool Set(const std::string &key, size_t hash, Value value, uint32_t expire_at = 0) {
+        return Set(key, hash, value.str(), expire_at);
+    }
+
+    /**
+     * Same as the one above, but value is returned as a shared handle, so storage could give out its own buffer
+     * without copying. By default value is copied
+     */
+    virtual bool Get(const std::string &key, size_t hash, Value &value) {
+        std::string data;
+        if (!Get(key, hash, data)) {
+            return false;
+        }
+        value = Value(std::move(data));
+        return true;
+    }
+
+    /**
+     * Adds data to the end of the value of existing key, expiration time of the key is kept. Method returns false
+     * and doesn't change anything if key is not present. Key is searched only once, so concurrent writers never
+     * lose each other's data
+     *
+     * @param key to be updated
+     * @param hash Afina::Hash of the key
+     * @param data to be added
+     */
+    virtual bool Append(const std::string &key, size_t hash, const std::string &data) = 0;
+
+    /**
+     * Same as Append, but data is added before the value
+     */
+    virtual bool Prepend(const std::string &key, size_t hash, const std::string &data) = 0;
+
+    /**
+     * Adds delta to the numeric value of existing key and returns the new value, value wraps around on overflow.
+     * Storage keeps value as native number once it has been incremented, so next update doesn't parse it, readers
+     * get the decimal text as usual. Expiration time of the key is kept
+     *
+     * @param key to be updated
+     * @param hash Afina::Hash of the key
+     * @param delta to be added
+     * @param value output parameter, the new value
+     */
+    virtual CounterStatus Increment(const std::string &key, size_t hash, uint64_t delta, uint64_t &value) = 0;
+
+    /**
+     * Same as Increment, but delta is substracted and value never goes below zero
+     */
+    virtual CounterStatus Decrement(const std::string &key, size_t hash, uint64_t delta, uint64_t &value) = 0;
+
+    /**
+     * Retrives values of several keys at once, so storage could serve the whole batch at a time. Value of
+     * keys[i] goes to values[i], value of the key which is not found is left null. Returns number of keys found
+     *
+     * @param keys to retrive values for
+     * @param hashes Afina::Hash of every key
+     * @param values output parameter, resized to the number of keys
+     */
+    virtual size_t MultiGet(const std::vector<std::string> &keys, const std::vector<size_t> &hashes,
+                            std::vector<Value> &values) {
+        values.assign(keys.size(), Value());
+        size_t found = 0;
+        for (size_t i = 0; i < keys.size(); i++) {
+            found += Get(keys[i], hashes[i], values[i]);
+        }
+        return found;
+    }
+
+    /**
+     * Same as MultiGet, but version of every value found goes to versions[i]. Version changes on every update
+     * of the key and never repeats for it, so it could be given to CompareAndSet later
+     *
+     * @param versions output parameter, resized to the number of keys
+     */
+    virtual size_t MultiGets(const std::vector<std::string> &keys, const std::vector<size_t> &hashes,
+                             std::vector<Value> &values, std::vector<uint64_t> &versions) = 0;
+
+    /**
+     * Updates existing association only if its version is still the given one, so concurrent clients could do
+     * read-modify-write without locking the key. Key is searched only once
+     *
+     * @param key to be updated
+     * @param hash Afina::Hash of the key
+     * @param value to be assigned for the key
+     * @param version of the value which client has read, see MultiGets
+     * @param expire_at absolute unix time in seconds when association expires, 0 means never
+     */
+    virtual CasStatus CompareAndSet(const std::string &key, size_t hash, Value value, uint64_t version,
+                                    uint32_t expire_at = 0) = 0;
+
+    /**
+     * Changes expiration time of existing key and counts it as accessed, value is neither read nor written, so
+     * its version is kept. Method returns false if key is not present
+     *
+     * @param key to be touched
+     * @param hash Afina::Hash of the key
+     * @param expire_at absolute unix time in seconds when association expires, 0 means never
+     */
+    virtual bool Touch(const std::string &key, size_t hash, uint32_t expire_at) = 0;
+
+    /**
+     * Same as Touch, but returns value of the key along with its version, see MultiGets
+     */
+    virtual bool GetAndTouch(const std::string &key, size_t hash, uint32_t expire_at, Value &value,
+                             uint64_t &version) = 0;
+
+    /**
+     * Invalidates all the keys at the given time, keys written after that are kept. Cost doesn't depend on number
+     * of keys: storage only remembers the flush, invalidated keys are never returned and their memory is reclaimed
+     * lazily
+     *
+     * @param at absolute unix time in seconds when keys are invalidated, 0 means right now
+     */
+    virtual void FlushAll(uint32_t at = 0) = 0;
+
+    /**
+     * Invalidates all the keys of the namespace right now, same way FlushAll does. Namespace of the key is its
+     * part before the first ':', keys without ':' don't belong to any namespace
+     *
+     * @param ns namespace to be flushed, without ':'
+     */
+    virtual void FlushNamespace(const std::string &ns) = 0;
 };
 
 } // namespace Afina
@@ -0,0 +1,106 @@
+#ifndef AFINA_VALUE_H
+#define AFINA_VALUE_H
+
+#include <atomic>
+#include <cstddef>
+#include <string>
+#include <utility>
+
+namespace Afina {
+
+/**
+ * # Immutable value shared by reference counting
+ * Handle to the buffer which is never changed once created, so it could be passed between network, commands
+ * and storage and read concurrently without copying the data. Buffer is freed once the last handle is gone.
+ *
+ * Storage could keep buffer in its own raw memory: Release takes buffer out of the handle, Share and Adopt
+ * create handles of the raw buffer with and without a new reference.
+ */
+class Value {
+public:
+    Value() : _buffer(nullptr) {}
+
+    // Takes data over without copying
+    explicit Value(std::string &&data) : _buffer(new Buffer(std::move(data))) {}
+
+    // Copies data
+    Value(const char *data, size_t size) : _buffer(new Buffer(std::string(data, size))) {}
+
+    Value(const Value &other) : _buffer(other._buffer) { _ref(_buffer); }
+    Value(Value &&other) : _buffer(other._buffer) { other._buffer = nullptr; }
+    ~Value() { _unref(_buffer); }
+
+    Value &operator=(Value other) {
+        std::swap(_buffer, other._buffer);
+        return *this;
+    }
+
+    // False for the handle which refers to no buffer at all, as opposed to the empty value
+    explicit operator bool() const { return _buffer != nullptr; }
+
+    inline const std::string &str() const { return _buffer != nullptr ? _buffer->data : _empty(); }
+    inline const char *data() const { return str().data(); }
+    inline size_t size() const { return str().size(); }
+
+    /**
+     * Takes buffer out of the handle, it must be given back by Adopt
+     */
+    inline void *Release() {
+        void *buffer = _buffer;
+        _buffer = nullptr;
+        return buffer;
+    }
+
+    /**
+     * Handle owning the reference given up by Release
+     */
+    static inline Value Adopt(void *buffer) {
+        Value result;
+        result._buffer = static_cast<Buffer *>(buffer);
+        return result;
+    }
+
+    /**
+     * New handle of the buffer released by another handle
+     */
+    static inline Value Share(void *buffer) {
+        _ref(static_cast<Buffer *>(buffer));
+        return Adopt(buffer);
+    }
+
+    /**
+     * Data of the buffer released by another handle
+     */
+    static inline const std::string &Peek(const void *buffer) { return static_cast<const Buffer *>(buffer)->data; }
+
+private:
+    struct Buffer {
+        explicit Buffer(std::string &&value) : refs(1), data(std::move(value)) {}
+
+        std::atomic<size_t> refs;
+        const std::string data;
+    };
+
+    static inline void _ref(Buffer *buffer) {
+        if (buffer != nullptr) {
+            buffer->refs.fetch_add(1, std::memory_order_relaxed);
+        }
+    }
+
+    static inline void _unref(Buffer *buffer) {
+        if (buffer != nullptr && buffer->refs.fetch_sub(1, std::memory_order_acq_rel) == 1) {
+            delete buffer;
+        }
+    }
+
+    static inline const std::string &_empty() {
+        static const std::string empty;
+        return empty;
+    }
+
+    Buffer *_buffer;
+};
+
+} // namespace Afina
+
+#endif // AFINA_VALUE_H
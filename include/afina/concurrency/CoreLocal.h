@@ -1,10 +1,95 @@
 #ifndef AFINA_CONCURRENCY_CORE_LOCAL_H
 #define AFINA_CONCURRENCY_CORE_LOCAL_H
 
+#include <cstddef>
+#include <cstdlib>
+#include <new>
+
+#include <sched.h>
+#include <unistd.h>
+
 namespace Afina {
 namespace Concurrency {
 
-template <typename T> class CoreLocal {};
+/**
+ * # Instance of T per CPU core
+ * Every core of the machine gets its own instance of T placed in separate cache lines, so threads running on
+ * different cores never share a cache line through it. Get() returns instance of the core calling thread runs
+ * on right now: thread could be migrated any moment unless it is pinned to the core, so instances must be
+ * either thread safe or used only by threads pinned to their core.
+ *
+ * Instances are allocated aligned to the cache line explicitly, operator new doesn't guarantee more than 16 bytes.
+ */
+template <typename T> class CoreLocal {
+public:
+    CoreLocal() : _size(Cores()), _cells(nullptr) {
+        void *memory = nullptr;
+        if (posix_memalign(&memory, kCacheLine, _size * sizeof(Cell)) != 0) {
+            throw std::bad_alloc();
+        }
+        _cells = static_cast<Cell *>(memory);
+
+        size_t constructed = 0;
+        try {
+            for (; constructed < _size; constructed++) {
+                new (&_cells[constructed]) Cell();
+            }
+        } catch (...) {
+            _destroy(constructed);
+            throw;
+        }
+    }
+    ~CoreLocal() { _destroy(_size); }
+
+    CoreLocal(const CoreLocal &) = delete;
+    CoreLocal &operator=(const CoreLocal &) = delete;
+
+    /**
+     * Instance of the core calling thread is running on
+     */
+    inline T &Get() { return _cells[Current() % _size].value; }
+
+    /**
+     * Instance of the given core
+     */
+    inline T &Get(size_t core) { return _cells[core].value; }
+
+    inline size_t Size() const { return _size; }
+
+    /**
+     * Number of cores configured in the system, cores are numbered from 0 to Cores() - 1
+     */
+    static size_t Cores() {
+        long n = sysconf(_SC_NPROCESSORS_CONF);
+        return n > 0 ? n : 1;
+    }
+
+    /**
+     * Core calling thread is running on
+     */
+    static inline size_t Current() {
+        int core = sched_getcpu();
+        return core > 0 ? core : 0;
+    }
+
+private:
+    static constexpr size_t kCacheLine = 64;
+
+    // Aligned to the cache line, so its size is rounded up to the multiple of cache line as well
+    struct alignas(kCacheLine) Cell {
+        T value;
+    };
+
+    void _destroy(size_t constructed) {
+        for (size_t i = 0; i < constructed; i++) {
+            _cells[i].~Cell();
+        }
+        free(_cells);
+    }
+
+    size_t _size;
+    Cell *_cells;
+};
 
 } // namespace Concurrency
 } // namespace Afina
@@ -0,0 +1,94 @@
+#ifndef AFINA_CONCURRENCY_MPSC_QUEUE_H
+#define AFINA_CONCURRENCY_MPSC_QUEUE_H
+
+#include <atomic>
+
+namespace Afina {
+namespace Concurrency {
+
+/**
+ * # Intrusive multi-producer single-consumer queue
+ * Lock-free queue of D. Vyukov: Push is a single exchange on the head, so producers never wait for each other
+ * or for the consumer, Pop touches only the tail and is allowed in one thread at a time.
+ *
+ * Queue doesn't own nodes, node must stay alive until it is popped. Pop could return nullptr while some
+ * producer is in the middle of Push even if other nodes have been pushed already, Empty() tells apart that
+ * case from the really empty queue.
+ */
+class MPSCQueue {
+public:
+    struct Node {
+        std::atomic<Node *> next;
+    };
+
+    MPSCQueue() : _head(&_stub), _tail(&_stub) { _stub.next.store(nullptr, std::memory_order_relaxed); }
+    ~MPSCQueue() {}
+
+    MPSCQueue(const MPSCQueue &) = delete;
+    MPSCQueue &operator=(const MPSCQueue &) = delete;
+
+    /**
+     * Adds node to the queue, could be called by any thread
+     */
+    void Push(Node *node) {
+        node->next.store(nullptr, std::memory_order_relaxed);
+        Node *prev = _head.exchange(node, std::memory_order_acq_rel);
+        // Until this store node is not reachable by the consumer
+        prev->next.store(node, std::memory_order_release);
+    }
+
+    /**
+     * Takes the oldest node out of the queue or returns nullptr, only consumer thread could call it
+     */
+    Node *Pop() {
+        Node *tail = _tail;
+        Node *next = tail->next.load(std::memory_order_acquire);
+        if (tail == &_stub) {
+            if (next == nullptr) {
+                return nullptr;
+            }
+            // Skip stub
+            _tail = next;
+            tail = next;
+            next = next->next.load(std::memory_order_acquire);
+        }
+
+        if (next != nullptr) {
+            _tail = next;
+            return tail;
+        }
+
+        if (tail != _head.load(std::memory_order_acquire)) {
+            // Producer is linking new node right now
+            return nullptr;
+        }
+
+        // Tail is the only node, stub takes its place so tail could be given away
+        Push(&_stub);
+        next = tail->next.load(std::memory_order_acquire);
+        if (next != nullptr) {
+            _tail = next;
+            return tail;
+        }
+        return nullptr;
+    }
+
+    /**
+     * True if nothing has been pushed since the last node was popped, only consumer thread could call it
+     */
+    bool Empty() const { return _tail == &_stub && _head.load(std::memory_order_acquire) == &_stub; }
+
+private:
+    // The newest node, producers contend on it only
+    std::atomic<Node *> _head;
+    char _pad[64 - sizeof(std::atomic<Node *>)];
+
+    // The oldest node, touched by consumer only
+    Node *_tail;
+    Node _stub;
+};
+
+} // namespace Concurrency
+} // namespace Afina
+
+#endif // AFINA_CONCURRENCY_MPSC_QUEUE_H
@@ -0,0 +1,68 @@
+#ifndef AFINA_CONCURRENCY_SHARED_MUTEX_H
+#define AFINA_CONCURRENCY_SHARED_MUTEX_H
+
+#include <stdexcept>
+
+#include <pthread.h>
+
+namespace Afina {
+namespace Concurrency {
+
+/**
+ * # Readers-writer lock
+ * Many threads could hold lock in shared mode at once, or exactly one in exclusive mode. Satisfies
+ * Lockable requirements, so could be used with std::lock_guard/std::unique_lock for exclusive mode, use
+ * SharedLock below for the shared one.
+ *
+ * Waiting writer blocks new readers, so writers do not starve under constant read load.
+ */
+class SharedMutex {
+public:
+    SharedMutex() {
+        pthread_rwlockattr_t attr;
+        pthread_rwlockattr_init(&attr);
+#ifdef __GLIBC__
+        pthread_rwlockattr_setkind_np(&attr, PTHREAD_RWLOCK_PREFER_WRITER_NONRECURSIVE_NP);
+#endif
+        int err = pthread_rwlock_init(&_lock, &attr);
+        pthread_rwlockattr_destroy(&attr);
+        if (err != 0) {
+            throw std::runtime_error("Failed to init rwlock");
+        }
+    }
+    ~SharedMutex() { pthread_rwlock_destroy(&_lock); }
+
+    SharedMutex(const SharedMutex &) = delete;
+    SharedMutex &operator=(const SharedMutex &) = delete;
+
+    inline void lock() { pthread_rwlock_wrlock(&_lock); }
+    inline bool try_lock() { return pthread_rwlock_trywrlock(&_lock) == 0; }
+    inline void unlock() { pthread_rwlock_unlock(&_lock); }
+
+    inline void lock_shared() { pthread_rwlock_rdlock(&_lock); }
+    inline bool try_lock_shared() { return pthread_rwlock_tryrdlock(&_lock) == 0; }
+    inline void unlock_shared() { pthread_rwlock_unlock(&_lock); }
+
+private:
+    pthread_rwlock_t _lock;
+};
+
+/**
+ * # Holds SharedMutex in shared mode for the scope
+ */
+class SharedLock {
+public:
+    explicit SharedLock(SharedMutex &mutex) : _mutex(mutex) { _mutex.lock_shared(); }
+    ~SharedLock() { _mutex.unlock_shared(); }
+
+    SharedLock(const SharedLock &) = delete;
+    SharedLock &operator=(const SharedLock &) = delete;
+
+private:
+    SharedMutex &_mutex;
+};
+
+} // namespace Concurrency
+} // namespace Afina
+
+#endif // AFINA_CONCURRENCY_SHARED_MUTEX_H
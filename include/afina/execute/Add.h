@@ -21,9 +21,11 @@ namespace Execute {
 class Add : public InsertCommand {
 public:
     Add(const std::string &key, uint32_t flags, int32_t expire) : InsertCommand(key, flags, expire) {}
+    Add(const std::string &key, size_t hash, uint32_t flags, int32_t expire)
+        : InsertCommand(key, hash, flags, expire) {}
     ~Add() {}
 
-    void Execute(Storage &storage, const std::string &args, std::string &out) override;
+    void Execute(Storage &storage, std::string &&args, Response &out) override;
 };
 
 } // namespace Execute
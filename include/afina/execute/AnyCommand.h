@@ -0,0 +1,123 @@
+#ifndef AFINA_EXECUTE_ANY_COMMAND_H
+#define AFINA_EXECUTE_ANY_COMMAND_H
+
+#include <cstdint>
+#include <new>
+#include <string>
+#include <type_traits>
+#include <utility>
+
+#include "Add.h"
+#include "Append.h"
+#include "Cas.h"
+#include "Command.h"
+#include "Decr.h"
+#include "FlushAll.h"
+#include "FlushNamespace.h"
+#include "Gat.h"
+#include "Gats.h"
+#include "Get.h"
+#include "Gets.h"
+#include "Incr.h"
+#include "Prepend.h"
+#include "Replace.h"
+#include "Set.h"
+#include "Stats.h"
+#include "Touch.h"
+
+namespace Afina {
+namespace Execute {
+
+namespace detail {
+
+// Position of T in the list of types Ts
+template <typename T, typename... Ts> struct IndexOf;
+
+template <typename T, typename... Ts> struct IndexOf<T, T, Ts...> : std::integral_constant<uint8_t, 0> {};
+
+template <typename T, typename U, typename... Ts>
+struct IndexOf<T, U, Ts...> : std::integral_constant<uint8_t, 1 + IndexOf<T, Ts...>::value> {};
+
+} // namespace detail
+
+/**
+ * # Any command kept in place
+ * Tagged union of all the commands: command is constructed right inside of the object, so connection could keep
+ * one of these and reuse it for every request instead of allocating command on the heap. Execute switches on the
+ * tag and calls Execute of the exact command type, so there is no virtual call either.
+ *
+ * Command could be used through Command interface as well, see get.
+ */
+class AnyCommand {
+public:
+    AnyCommand() : _kind(kNone) {}
+    ~AnyCommand() { Reset(); }
+
+    AnyCommand(const AnyCommand &) = delete;
+    AnyCommand &operator=(const AnyCommand &) = delete;
+
+    /**
+     * Constructs command of the given type in place of the current one
+     */
+    template <typename T, typename... Args> T &Emplace(Args &&... args) {
+        Reset();
+        T *command = new (&_storage) T(std::forward<Args>(args)...);
+        _kind = _kind_of<T>();
+        return *command;
+    }
+
+    /**
+     * Destroys command, if there is one
+     */
+    void Reset();
+
+    explicit operator bool() const { return _kind != kNone; }
+
+    /**
+     * Runs command, there must be one. See Command::Execute
+     */
+    void Execute(Storage &storage, std::string &&args, Response &out);
+
+    /**
+     * Command as the interface, nullptr if there is none
+     */
+    Command *get();
+
+private:
+    // Kinds follow the order of types in _kind_of
+    enum Kind : uint8_t {
+        kNone,
+        kSet,
+        kAdd,
+        kReplace,
+        kAppend,
+        kPrepend,
+        kCas,
+        kIncr,
+        kDecr,
+        kGet,
+        kGets,
+        kGat,
+        kGats,
+        kTouch,
+        kFlushAll,
+        kFlushNamespace,
+        kStats
+    };
+
+    template <typename T> static constexpr Kind _kind_of() {
+        return Kind(1 + detail::IndexOf<T, Set, Add, Replace, Append, Prepend, Cas, Incr, Decr, Get, Gets, Gat, Gats,
+                                        Touch, FlushAll, FlushNamespace, Stats>::value);
+    }
+
+    template <typename T> inline T &_as() { return *reinterpret_cast<T *>(&_storage); }
+
+    Kind _kind;
+    typename std::aligned_union<0, Set, Add, Replace, Append, Prepend, Cas, Incr, Decr, Get, Gets, Gat, Gats, Touch,
+                                FlushAll, FlushNamespace, Stats>::type _storage;
+};
+
+} // namespace Execute
+} // namespace Afina
+
+#endif // AFINA_EXECUTE_ANY_COMMAND_H
@@ -0,0 +1,43 @@
+#ifndef AFINA_EXECUTE_CAS_H
+#define AFINA_EXECUTE_CAS_H
+
+#include <cstdint>
+#include <string>
+
+#include "InsertCommand.h"
+
+namespace Afina {
+namespace Execute {
+
+/**
+ * # Check and set
+ * Store the data for the key, but only if nobody else has updated it since the client has read it by gets. Key
+ * is searched and updated at once, so concurrent clients don't need any external locking
+ *
+ * Command must write result to the output, which could be:
+ * - "STORED", to indicate success.
+ * - "EXISTS" to indicate that the item has been modified since client has read it
+ * - "NOT_FOUND" to indicate that the item did not exist or has been deleted
+ * - "NOT_STORED" to indicate the data was not stored because it is too large
+ */
+class Cas : public InsertCommand {
+public:
+    Cas(const std::string &key, uint32_t flags, int32_t expire, uint64_t version)
+        : InsertCommand(key, flags, expire), _version(version) {}
+    Cas(const std::string &key, size_t hash, uint32_t flags, int32_t expire, uint64_t version)
+        : InsertCommand(key, hash, flags, expire), _version(version) {}
+    ~Cas() {}
+
+    inline uint64_t version() const { return _version; }
+
+    void Execute(Storage &storage, std::string &&args, Response &out) override;
+
+private:
+    // <cas unique> client has got from gets
+    const uint64_t _version;
+};
+
+} // namespace Execute
+} // namespace Afina
+
+#endif // AFINA_EXECUTE_CAS_H
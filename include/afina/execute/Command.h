@@ -1,8 +1,11 @@
 #ifndef AFINA_EXECUTE_COMMAND_H
 #define AFINA_EXECUTE_COMMAND_H
 
+#include <cstdint>
 #include <string>
 
+#include "Response.h"
+
 namespace Afina {
 
 class Storage;
@@ -18,7 +21,25 @@ public:
     Command() {}
     virtual ~Command() {}
 
-    virtual void Execute(Storage &storage, const std::string &args, std::string &out) = 0;
+    /**
+     * Runs command against the storage, command is free to take argument over
+     */
+    virtual void Execute(Storage &storage, std::string &&args, Response &out) = 0;
+
+    /**
+     * Same as above, but works on copy of the argument and returns flat response
+     */
+    void Execute(Storage &storage, const std::string &args, std::string &out);
+
+    /**
+     * Absolute unix time when the item expires, as storage expects it, 0 means never. By memcached rules expire
+     * time up to 30 days is relative to now and absolute unix time otherwise, negative one means the item is
+     * expired immediately
+     */
+    static uint32_t ExpireAt(int32_t expire);
+
+protected:
+    static constexpr int32_t kMaxRelativeExpire = 60 * 60 * 24 * 30;
 };
 
 } // namespace Execute
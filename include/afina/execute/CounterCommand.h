@@ -0,0 +1,58 @@
+#ifndef AFINA_EXECUTE_COUNTER_COMMAND_H
+#define AFINA_EXECUTE_COUNTER_COMMAND_H
+
+#include <cstdint>
+#include <string>
+
+#include <afina/Hash.h>
+#include <afina/Storage.h>
+
+#include "Command.h"
+
+namespace Afina {
+namespace Execute {
+
+/**
+ * # Basic class for incr and decr commands
+ *
+ * Command must write result to the output, which could be:
+ * - new value of the counter as decimal number
+ * - "NOT_FOUND" to indicate the item with this key was not found
+ * - "CLIENT_ERROR ..." if value of the key is not a decimal unsigned 64 bit number
+ */
+class CounterCommand : public Command {
+public:
+    CounterCommand(const std::string &key, uint64_t delta) : CounterCommand(key, Hash(key), delta) {}
+    CounterCommand(const std::string &key, size_t hash, uint64_t delta) : _key(key), _hash(hash), _delta(delta) {}
+    ~CounterCommand() {}
+
+    inline const std::string &key() const { return _key; }
+    inline size_t hash() const { return _hash; }
+    inline uint64_t delta() const { return _delta; }
+
+protected:
+    // Writes outcome of the storage update
+    void _respond(CounterStatus status, uint64_t value, Response &out) const {
+        switch (status) {
+        case CounterStatus::Done:
+            out.Append(std::to_string(value));
+            break;
+        case CounterStatus::NotFound:
+            out.Append("NOT_FOUND");
+            break;
+        case CounterStatus::NotNumeric:
+            out.Append("CLIENT_ERROR cannot increment or decrement non-numeric value");
+            break;
+        }
+    }
+
+    const std::string _key;
+    // Afina::Hash of the key, computed once by whoever has created the command
+    const size_t _hash;
+    const uint64_t _delta;
+};
+
+} // namespace Execute
+} // namespace Afina
+
+#endif // AFINA_EXECUTE_COUNTER_COMMAND_H
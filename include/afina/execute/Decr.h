@@ -0,0 +1,29 @@
+#ifndef AFINA_EXECUTE_DECR_H
+#define AFINA_EXECUTE_DECR_H
+
+#include <cstdint>
+#include <string>
+
+#include "CounterCommand.h"
+
+namespace Afina {
+namespace Execute {
+
+/**
+ * # Decrement value of the key
+ * Substracts delta from the value of the existing key, value must be a decimal unsigned 64 bit number. Value never
+ * goes below zero. If key wasn't found then command does nothing
+ */
+class Decr : public CounterCommand {
+public:
+    Decr(const std::string &key, uint64_t delta) : CounterCommand(key, delta) {}
+    Decr(const std::string &key, size_t hash, uint64_t delta) : CounterCommand(key, hash, delta) {}
+    ~Decr() {}
+
+    void Execute(Storage &storage, std::string &&args, Response &out) override;
+};
+
+} // namespace Execute
+} // namespace Afina
+
+#endif // AFINA_EXECUTE_DECR_H
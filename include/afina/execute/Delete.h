@@ -20,7 +20,7 @@ public:
     Delete();
     ~Delete();
 
-    void Execute(Storage &storage, const std::string &args, std::string &out) override;
+    void Execute(Storage &storage, std::string &&args, Response &out) override;
 };
 
 } // namespace Execute
@@ -0,0 +1,35 @@
+#ifndef AFINA_EXECUTE_FLUSH_ALL_H
+#define AFINA_EXECUTE_FLUSH_ALL_H
+
+#include <cstdint>
+#include <string>
+
+#include "Command.h"
+
+namespace Afina {
+namespace Execute {
+
+/**
+ * # Invalidate all the keys
+ * Invalidates all existing keys right away or after the delay, which follows the rules of expire time. Items
+ * are not removed one by one, so command is cheap regardless of the number of keys
+ *
+ * Command must write result to the output, which is always "OK"
+ */
+class FlushAll : public Command {
+public:
+    FlushAll(int32_t delay = 0) : _delay(delay) {}
+    ~FlushAll() {}
+
+    inline const int32_t delay() const { return _delay; }
+
+    void Execute(Storage &storage, std::string &&args, Response &out) override;
+
+private:
+    const int32_t _delay;
+};
+
+} // namespace Execute
+} // namespace Afina
+
+#endif // AFINA_EXECUTE_FLUSH_ALL_H
@@ -0,0 +1,35 @@
+#ifndef AFINA_EXECUTE_FLUSH_NAMESPACE_H
+#define AFINA_EXECUTE_FLUSH_NAMESPACE_H
+
+#include <string>
+#include <vector>
+
+#include "Command.h"
+
+namespace Afina {
+namespace Execute {
+
+/**
+ * # Invalidate keys of namespaces
+ * Invalidates all existing keys of the given namespaces right away, namespace of the key is its part before the
+ * first ':'. Not a part of memcached protocol, syntax is "flush_ns <namespace>*"
+ *
+ * Command must write result to the output, which is always "OK"
+ */
+class FlushNamespace : public Command {
+public:
+    FlushNamespace(const std::vector<std::string> &namespaces) : _namespaces(namespaces) {}
+    ~FlushNamespace() {}
+
+    inline const std::vector<std::string> &namespaces() const { return _namespaces; }
+
+    void Execute(Storage &storage, std::string &&args, Response &out) override;
+
+private:
+    const std::vector<std::string> _namespaces;
+};
+
+} // namespace Execute
+} // namespace Afina
+
+#endif // AFINA_EXECUTE_FLUSH_NAMESPACE_H
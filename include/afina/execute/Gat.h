@@ -0,0 +1,39 @@
+#ifndef AFINA_EXECUTE_GAT_H
+#define AFINA_EXECUTE_GAT_H
+
+#include <cstdint>
+#include <string>
+#include <vector>
+
+#include "Get.h"
+
+namespace Afina {
+namespace Execute {
+
+/**
+ * # Retrive values for the keys and update their expiration time
+ * Same as Get, but every key found gets the new expiration time, so client could keep hot items alive without
+ * sending their values again
+ */
+class Gat : public Get {
+public:
+    Gat(const std::vector<std::string> &keys, int32_t expire) : Get(keys), _expire(expire) {}
+    Gat(const std::vector<std::string> &keys, const std::vector<size_t> &hashes, int32_t expire)
+        : Get(keys, hashes), _expire(expire) {}
+    ~Gat() {}
+
+    inline const int32_t expire() const { return _expire; }
+
+    void Execute(Storage &storage, std::string &&args, Response &out) override;
+
+protected:
+    // Touches every key and writes items found, with their versions if asked to
+    void _touch_all(Storage &storage, bool versions, Response &out) const;
+
+    const int32_t _expire;
+};
+
+} // namespace Execute
+} // namespace Afina
+
+#endif // AFINA_EXECUTE_GAT_H
@@ -0,0 +1,30 @@
+#ifndef AFINA_EXECUTE_GATS_H
+#define AFINA_EXECUTE_GATS_H
+
+#include <cstdint>
+#include <string>
+#include <vector>
+
+#include "Gat.h"
+
+namespace Afina {
+namespace Execute {
+
+/**
+ * # Retrive values for the keys along with their versions and update their expiration time
+ * Same as Gat, but items carry versions like the ones of Gets
+ */
+class Gats : public Gat {
+public:
+    Gats(const std::vector<std::string> &keys, int32_t expire) : Gat(keys, expire) {}
+    Gats(const std::vector<std::string> &keys, const std::vector<size_t> &hashes, int32_t expire)
+        : Gat(keys, hashes, expire) {}
+    ~Gats() {}
+
+    void Execute(Storage &storage, std::string &&args, Response &out) override;
+};
+
+} // namespace Execute
+} // namespace Afina
+
+#endif // AFINA_EXECUTE_GATS_H
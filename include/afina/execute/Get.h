@@ -4,6 +4,8 @@
 #include <string>
 #include <vector>
 
+#include <afina/Hash.h>
+
 #include "Command.h"
 
 namespace Afina {
@@ -34,15 +36,26 @@ namespace Execute {
  */
 class Get : public Command {
 public:
-    Get(const std::vector<std::string> &keys) : _keys(keys) {}
+    Get(const std::vector<std::string> &keys) : _keys(keys) {
+        for (auto &key : _keys) {
+            _hashes.push_back(Hash(key));
+        }
+    }
+    Get(const std::vector<std::string> &keys, const std::vector<size_t> &hashes) : _keys(keys), _hashes(hashes) {}
     ~Get() {}
 
     inline const std::vector<std::string> &keys() const { return _keys; }
+    inline const std::vector<size_t> &hashes() const { return _hashes; }
+
+    void Execute(Storage &storage, std::string &&args, Response &out) override;
 
-    void Execute(Storage &storage, const std::string &args, std::string &out) override;
+protected:
+    // Writes item of the response, version is written unless it is nullptr
+    static void _append_item(const std::string &key, Value value, const uint64_t *version, Response &out);
 
-private:
     std::vector<std::string> _keys;
+    // Afina::Hash of every key
+    std::vector<size_t> _hashes;
 };
 
 } // namespace Execute
@@ -0,0 +1,31 @@
+#ifndef AFINA_EXECUTE_GETS_H
+#define AFINA_EXECUTE_GETS_H
+
+#include <string>
+#include <vector>
+
+#include "Get.h"
+
+namespace Afina {
+namespace Execute {
+
+/**
+ * # Retrive values for the key along with their versions
+ * Same as Get, but each item sent by the server carries the version of the value, which client could give to
+ * the cas command later:
+ * VALUE <key> <flags> <bytes> <cas unique>\r\n
+ * <data>\r\n
+ */
+class Gets : public Get {
+public:
+    Gets(const std::vector<std::string> &keys) : Get(keys) {}
+    Gets(const std::vector<std::string> &keys, const std::vector<size_t> &hashes) : Get(keys, hashes) {}
+    ~Gets() {}
+
+    void Execute(Storage &storage, std::string &&args, Response &out) override;
+};
+
+} // namespace Execute
+} // namespace Afina
+
+#endif // AFINA_EXECUTE_GETS_H
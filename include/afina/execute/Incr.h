@@ -0,0 +1,29 @@
+#ifndef AFINA_EXECUTE_INCR_H
+#define AFINA_EXECUTE_INCR_H
+
+#include <cstdint>
+#include <string>
+
+#include "CounterCommand.h"
+
+namespace Afina {
+namespace Execute {
+
+/**
+ * # Increment value of the key
+ * Adds delta to the value of the existing key, value must be a decimal unsigned 64 bit number. Value wraps around
+ * on overflow. If key wasn't found then command does nothing
+ */
+class Incr : public CounterCommand {
+public:
+    Incr(const std::string &key, uint64_t delta) : CounterCommand(key, delta) {}
+    Incr(const std::string &key, size_t hash, uint64_t delta) : CounterCommand(key, hash, delta) {}
+    ~Incr() {}
+
+    void Execute(Storage &storage, std::string &&args, Response &out) override;
+};
+
+} // namespace Execute
+} // namespace Afina
+
+#endif // AFINA_EXECUTE_INCR_H
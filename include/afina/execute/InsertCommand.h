@@ -4,6 +4,8 @@
 #include <cstdint>
 #include <string>
 
+#include <afina/Hash.h>
+
 #include "Command.h"
 
 namespace Afina {
@@ -15,15 +17,24 @@ namespace Execute {
  */
 class InsertCommand : public Command {
 public:
-    InsertCommand(const std::string &key, uint32_t flags, int32_t expire) : _key(key), _flags(flags), _expire(expire) {}
+    InsertCommand(const std::string &key, uint32_t flags, int32_t expire)
+        : InsertCommand(key, Hash(key), flags, expire) {}
+    InsertCommand(const std::string &key, size_t hash, uint32_t flags, int32_t expire)
+        : _key(key), _hash(hash), _flags(flags), _expire(expire) {}
     ~InsertCommand() {}
 
     inline const std::string &key() const { return _key; }
+    inline size_t hash() const { return _hash; }
     inline const uint32_t flags() const { return _flags; }
     inline const int32_t expire() const { return _expire; }
 
+    // Absolute unix time when the item expires, see Command::ExpireAt
+    inline uint32_t expire_at() const { return ExpireAt(_expire); }
+
 protected:
     const std::string _key;
+    // Afina::Hash of the key, computed once by whoever has created the command
+    const size_t _hash;
     const uint32_t _flags;
     const int32_t _expire;
 };
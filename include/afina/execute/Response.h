@@ -0,0 +1,120 @@
+#ifndef AFINA_EXECUTE_RESPONSE_H
+#define AFINA_EXECUTE_RESPONSE_H
+
+#include <cstddef>
+#include <string>
+#include <vector>
+
+#include <sys/uio.h>
+
+#include <afina/Value.h>
+
+namespace Afina {
+namespace Execute {
+
+/**
+ * # Response of the command
+ * Sequence of text pieces and values. Text is copied into the response, values are kept by handle, so value
+ * read from the storage goes to the socket without being copied.
+ */
+class Response {
+public:
+    Response() : _size(0) {}
+
+    void Append(const char *data, size_t size) {
+        if (size == 0) {
+            return;
+        }
+        if (!_parts.empty() && !_parts.back().shared) {
+            _parts.back().size += size;
+        } else {
+            _parts.push_back(Part{_text.size(), size, Value(), false});
+        }
+        _text.append(data, size);
+        _size += size;
+    }
+
+    void Append(const std::string &text) { Append(text.data(), text.size()); }
+
+    void Append(Value value) {
+        size_t size = value.size();
+        if (size == 0) {
+            return;
+        }
+        _parts.push_back(Part{0, size, std::move(value), true});
+        _size += size;
+    }
+
+    /**
+     * Total number of bytes in the response
+     */
+    inline size_t Size() const { return _size; }
+
+    inline bool Empty() const { return _size == 0; }
+
+    /**
+     * Calls f(const char *data, size_t size) for every piece of the response in order
+     */
+    template <typename F> void ForEach(F f) const {
+        for (const Part &part : _parts) {
+            f(_data(part), part.size);
+        }
+    }
+
+    /**
+     * Fills at most n vectors with the response bytes starting from the given offset, returns number of
+     * vectors filled
+     */
+    size_t Gather(struct iovec *iov, size_t n, size_t offset) const {
+        size_t filled = 0;
+        for (auto it = _parts.begin(); it != _parts.end() && filled < n; it++) {
+            if (offset >= it->size) {
+                offset -= it->size;
+                continue;
+            }
+            iov[filled].iov_base = const_cast<char *>(_data(*it) + offset);
+            iov[filled].iov_len = it->size - offset;
+            offset = 0;
+            filled++;
+        }
+        return filled;
+    }
+
+    /**
+     * Flat copy of the response
+     */
+    std::string ToString() const {
+        std::string result;
+        result.reserve(_size);
+        ForEach([&result](const char *data, size_t size) { result.append(data, size); });
+        return result;
+    }
+
+    void Clear() {
+        _parts.clear();
+        _text.clear();
+        _size = 0;
+    }
+
+private:
+    // Either range of _text or the whole value
+    struct Part {
+        size_t offset;
+        size_t size;
+        Value value;
+        bool shared;
+    };
+
+    inline const char *_data(const Part &part) const {
+        return part.shared ? part.value.data() : _text.data() + part.offset;
+    }
+
+    std::vector<Part> _parts;
+    std::string _text;
+    size_t _size;
+};
+
+} // namespace Execute
+} // namespace Afina
+
+#endif // AFINA_EXECUTE_RESPONSE_H
@@ -22,9 +22,11 @@ namespace Execute {
 class Set : public InsertCommand {
 public:
     Set(const std::string &key, uint32_t flags, int32_t expire) : InsertCommand(key, flags, expire) {}
+    Set(const std::string &key, size_t hash, uint32_t flags, int32_t expire)
+        : InsertCommand(key, hash, flags, expire) {}
     ~Set() {}
 
-    void Execute(Storage &storage, const std::string &args, std::string &out) override;
+    void Execute(Storage &storage, std::string &&args, Response &out) override;
 };
 
 } // namespace Execute
@@ -12,7 +12,7 @@ class Stats : public Command {
 public:
     Stats() {}
     ~Stats() {}
-    void Execute(Storage &storage, const std::string &args, std::string &out) override;
+    void Execute(Storage &storage, std::string &&args, Response &out) override;
 };
 
 } // namespace Execute
@@ -0,0 +1,44 @@
+#ifndef AFINA_EXECUTE_TOUCH_H
+#define AFINA_EXECUTE_TOUCH_H
+
+#include <cstdint>
+#include <string>
+
+#include <afina/Hash.h>
+
+#include "Command.h"
+
+namespace Afina {
+namespace Execute {
+
+/**
+ * # Update expiration time of the key
+ * Sets new expiration time of the existing key without sending its value again. If key wasn't found then
+ * command does nothing
+ *
+ * Command must write result to the output, which could be:
+ * - "TOUCHED" to indicate success
+ * - "NOT_FOUND" to indicate that the item with this key was not found
+ */
+class Touch : public Command {
+public:
+    Touch(const std::string &key, int32_t expire) : Touch(key, Hash(key), expire) {}
+    Touch(const std::string &key, size_t hash, int32_t expire) : _key(key), _hash(hash), _expire(expire) {}
+    ~Touch() {}
+
+    inline const std::string &key() const { return _key; }
+    inline const int32_t expire() const { return _expire; }
+
+    void Execute(Storage &storage, std::string &&args, Response &out) override;
+
+private:
+    const std::string _key;
+    // Afina::Hash of the key, computed once by whoever has created the command
+    const size_t _hash;
+    const int32_t _expire;
+};
+
+} // namespace Execute
+} // namespace Afina
+
+#endif // AFINA_EXECUTE_TOUCH_H
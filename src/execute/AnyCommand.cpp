@@ -0,0 +1,164 @@
+#include <afina/execute/AnyCommand.h>
+
+#include <stdexcept>
+
+namespace Afina {
+namespace Execute {
+
+// See AnyCommand.h
+void AnyCommand::Reset() {
+    // Destructors are called by qualified names, so that they are resolved statically as well
+    switch (_kind) {
+    case kSet:
+        _as<Set>().Set::~Set();
+        break;
+    case kAdd:
+        _as<Add>().Add::~Add();
+        break;
+    case kReplace:
+        _as<Replace>().Replace::~Replace();
+        break;
+    case kAppend:
+        _as<Append>().Append::~Append();
+        break;
+    case kPrepend:
+        _as<Prepend>().Prepend::~Prepend();
+        break;
+    case kCas:
+        _as<Cas>().Cas::~Cas();
+        break;
+    case kIncr:
+        _as<Incr>().Incr::~Incr();
+        break;
+    case kDecr:
+        _as<Decr>().Decr::~Decr();
+        break;
+    case kGet:
+        _as<Get>().Get::~Get();
+        break;
+    case kGets:
+        _as<Gets>().Gets::~Gets();
+        break;
+    case kGat:
+        _as<Gat>().Gat::~Gat();
+        break;
+    case kGats:
+        _as<Gats>().Gats::~Gats();
+        break;
+    case kTouch:
+        _as<Touch>().Touch::~Touch();
+        break;
+    case kFlushAll:
+        _as<FlushAll>().FlushAll::~FlushAll();
+        break;
+    case kFlushNamespace:
+        _as<FlushNamespace>().FlushNamespace::~FlushNamespace();
+        break;
+    case kStats:
+        _as<Stats>().Stats::~Stats();
+        break;
+    case kNone:
+        return;
+    }
+    _kind = kNone;
+}
+
+// See AnyCommand.h
+void AnyCommand::Execute(Storage &storage, std::string &&args, Response &out) {
+    switch (_kind) {
+    case kSet:
+        _as<Set>().Set::Execute(storage, std::move(args), out);
+        break;
+    case kAdd:
+        _as<Add>().Add::Execute(storage, std::move(args), out);
+        break;
+    case kReplace:
+        _as<Replace>().Replace::Execute(storage, std::move(args), out);
+        break;
+    case kAppend:
+        _as<Append>().Append::Execute(storage, std::move(args), out);
+        break;
+    case kPrepend:
+        _as<Prepend>().Prepend::Execute(storage, std::move(args), out);
+        break;
+    case kCas:
+        _as<Cas>().Cas::Execute(storage, std::move(args), out);
+        break;
+    case kIncr:
+        _as<Incr>().Incr::Execute(storage, std::move(args), out);
+        break;
+    case kDecr:
+        _as<Decr>().Decr::Execute(storage, std::move(args), out);
+        break;
+    case kGet:
+        _as<Get>().Get::Execute(storage, std::move(args), out);
+        break;
+    case kGets:
+        _as<Gets>().Gets::Execute(storage, std::move(args), out);
+        break;
+    case kGat:
+        _as<Gat>().Gat::Execute(storage, std::move(args), out);
+        break;
+    case kGats:
+        _as<Gats>().Gats::Execute(storage, std::move(args), out);
+        break;
+    case kTouch:
+        _as<Touch>().Touch::Execute(storage, std::move(args), out);
+        break;
+    case kFlushAll:
+        _as<FlushAll>().FlushAll::Execute(storage, std::move(args), out);
+        break;
+    case kFlushNamespace:
+        _as<FlushNamespace>().FlushNamespace::Execute(storage, std::move(args), out);
+        break;
+    case kStats:
+        _as<Stats>().Stats::Execute(storage, std::move(args), out);
+        break;
+    case kNone:
+        throw std::runtime_error("There is no command to execute");
+    }
+}
+
+// See AnyCommand.h
+Command *AnyCommand::get() {
+    switch (_kind) {
+    case kSet:
+        return &_as<Set>();
+    case kAdd:
+        return &_as<Add>();
+    case kReplace:
+        return &_as<Replace>();
+    case kAppend:
+        return &_as<Append>();
+    case kPrepend:
+        return &_as<Prepend>();
+    case kCas:
+        return &_as<Cas>();
+    case kIncr:
+        return &_as<Incr>();
+    case kDecr:
+        return &_as<Decr>();
+    case kGet:
+        return &_as<Get>();
+    case kGets:
+        return &_as<Gets>();
+    case kGat:
+        return &_as<Gat>();
+    case kGats:
+        return &_as<Gats>();
+    case kTouch:
+        return &_as<Touch>();
+    case kFlushAll:
+        return &_as<FlushAll>();
+    case kFlushNamespace:
+        return &_as<FlushNamespace>();
+    case kStats:
+        return &_as<Stats>();
+    case kNone:
+        break;
+    }
+    return nullptr;
+}
+
+} // namespace Execute
+} // namespace Afina
@@ -0,0 +1,27 @@
+#include <afina/Storage.h>
+#include <afina/execute/Cas.h>
+
+namespace Afina {
+namespace Execute {
+
+// memcached protocol: "cas" is a check and set operation which means "store this data but only if no one else
+// has updated since I last fetched it."
+void Cas::Execute(Storage &storage, std::string &&args, Response &out) {
+    switch (storage.CompareAndSet(_key, _hash, Value(std::move(args)), _version, expire_at())) {
+    case CasStatus::Stored:
+        out.Append("STORED");
+        break;
+    case CasStatus::NotStored:
+        out.Append("NOT_STORED");
+        break;
+    case CasStatus::Exists:
+        out.Append("EXISTS");
+        break;
+    case CasStatus::NotFound:
+        out.Append("NOT_FOUND");
+        break;
+    }
+}
+
+} // namespace Execute
+} // namespace Afina
@@ -1 +1,30 @@
 #include <afina/execute/Command.h>
+
+#include <ctime>
+
+namespace Afina {
+namespace Execute {
+
+// See Command.h
+void Command::Execute(Storage &storage, const std::string &args, std::string &out) {
+    Response response;
+    Execute(storage, std::string(args), response);
+    out = response.ToString();
+}
+
+constexpr int32_t Command::kMaxRelativeExpire;
+
+// See Command.h
+uint32_t Command::ExpireAt(int32_t expire) {
+    if (expire == 0) {
+        return 0;
+    } else if (expire < 0) {
+        return 1;
+    } else if (expire <= kMaxRelativeExpire) {
+        return std::time(nullptr) + expire;
+    }
+    return expire;
+}
+
+} // namespace Execute
+} // namespace Afina
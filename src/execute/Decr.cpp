@@ -0,0 +1,15 @@
+#include <afina/Storage.h>
+#include <afina/execute/Decr.h>
+
+namespace Afina {
+namespace Execute {
+
+// memcached protocol: "decr" substracts delta from the 64 bit unsigned counter of an existing key, stops at 0.
+void Decr::Execute(Storage &storage, std::string &&args, Response &out) {
+    uint64_t value = 0;
+    CounterStatus status = storage.Decrement(_key, _hash, _delta, value);
+    _respond(status, value, out);
+}
+
+} // namespace Execute
+} // namespace Afina
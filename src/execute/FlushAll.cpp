@@ -0,0 +1,14 @@
+#include <afina/Storage.h>
+#include <afina/execute/FlushAll.h>
+
+namespace Afina {
+namespace Execute {
+
+// memcached protocol: "flush_all" invalidates all existing items, optionally after the delay.
+void FlushAll::Execute(Storage &storage, std::string &&args, Response &out) {
+    storage.FlushAll(ExpireAt(_delay));
+    out.Append("OK");
+}
+
+} // namespace Execute
+} // namespace Afina
@@ -0,0 +1,16 @@
+#include <afina/Storage.h>
+#include <afina/execute/FlushNamespace.h>
+
+namespace Afina {
+namespace Execute {
+
+// See FlushNamespace.h
+void FlushNamespace::Execute(Storage &storage, std::string &&args, Response &out) {
+    for (const std::string &ns : _namespaces) {
+        storage.FlushNamespace(ns);
+    }
+    out.Append("OK");
+}
+
+} // namespace Execute
+} // namespace Afina
@@ -0,0 +1,26 @@
+#include <afina/Storage.h>
+#include <afina/execute/Gat.h>
+
+namespace Afina {
+namespace Execute {
+
+// memcached protocol: "gat" is "touch" and "get" at once, items are sent back as for "get".
+void Gat::Execute(Storage &storage, std::string &&args, Response &out) {
+    _touch_all(storage, false, out);
+}
+
+// See Gat.h
+void Gat::_touch_all(Storage &storage, bool versions, Response &out) const {
+    uint32_t expire_at = ExpireAt(_expire);
+    for (size_t i = 0; i < _keys.size(); i++) {
+        Value value;
+        uint64_t version;
+        if (storage.GetAndTouch(_keys[i], _hashes[i], expire_at, value, version)) {
+            _append_item(_keys[i], std::move(value), versions ? &version : nullptr, out);
+        }
+    }
+    out.Append("END"); // networking layer should add the last \r\n
+}
+
+} // namespace Execute
+} // namespace Afina
@@ -0,0 +1,13 @@
+#include <afina/Storage.h>
+#include <afina/execute/Gats.h>
+
+namespace Afina {
+namespace Execute {
+
+// memcached protocol: "gats" is "gat" which sends the cas unique of every item like "gets" does.
+void Gats::Execute(Storage &storage, std::string &&args, Response &out) {
+    _touch_all(storage, true, out);
+}
+
+} // namespace Execute
+} // namespace Afina
@@ -3,10 +3,6 @@
 
 #include <unistd.h>
 
-#include <iostream>
-#include <iterator>
-#include <sstream>
-
 namespace Afina {
 namespace Execute {
 
@@ -23,24 +19,29 @@ to indicate the end of response.
 
 */
 
-void Get::Execute(Storage &storage, const std::string &args, std::string &out) {
-    std::stringstream keyStream;
-    copy(_keys.begin(), _keys.end(), std::ostream_iterator<std::string>(keyStream, " "));
-    std::cout << "Get(" << keyStream.str() << ")" << std::endl;
-
-    std::stringstream outStream;
-
-    std::string value;
-    for (auto &key : _keys) {
-        if (!storage.Get(key, value))
+void Get::Execute(Storage &storage, std::string &&args, Response &out) {
+    // Whole batch goes to the storage at once, values are not copied, response keeps them by handle
+    std::vector<Value> values;
+    storage.MultiGet(_keys, _hashes, values);
+    for (size_t i = 0; i < _keys.size(); i++) {
+        if (!values[i])
             continue;
-        outStream << "VALUE " << key << " 0 " << value.size() << "\r\n";
-        outStream << value << "\r\n";
+        _append_item(_keys[i], std::move(values[i]), nullptr, out);
     }
 //    usleep(1e7); // for shutdown test
-    outStream << "END"; // networking layer should add the last \r\n
+    out.Append("END"); // networking layer should add the last \r\n
+}
 
-    out = outStream.str();
+// See Get.h
+void Get::_append_item(const std::string &key, Value value, const uint64_t *version, Response &out) {
+    std::string header = "VALUE " + key + " 0 " + std::to_string(value.size());
+    if (version != nullptr) {
+        header += " " + std::to_string(*version);
+    }
+    header += "\r\n";
+    out.Append(header);
+    out.Append(std::move(value));
+    out.Append("\r\n", 2);
 }
 
 } // namespace Execute
@@ -0,0 +1,22 @@
+#include <afina/Storage.h>
+#include <afina/execute/Gets.h>
+
+namespace Afina {
+namespace Execute {
+
+// memcached protocol: "gets" is "get" which sends the cas unique of every item after its size.
+void Gets::Execute(Storage &storage, std::string &&args, Response &out) {
+
+    std::vector<Value> values;
+    std::vector<uint64_t> versions;
+    storage.MultiGets(_keys, _hashes, values, versions);
+    for (size_t i = 0; i < _keys.size(); i++) {
+        if (!values[i])
+            continue;
+        _append_item(_keys[i], std::move(values[i]), &versions[i], out);
+    }
+    out.Append("END"); // networking layer should add the last \r\n
+}
+
+} // namespace Execute
+} // namespace Afina
@@ -0,0 +1,15 @@
+#include <afina/Storage.h>
+#include <afina/execute/Incr.h>
+
+namespace Afina {
+namespace Execute {
+
+// memcached protocol: "incr" adds delta to the 64 bit unsigned counter of an existing key.
+void Incr::Execute(Storage &storage, std::string &&args, Response &out) {
+    uint64_t value = 0;
+    CounterStatus status = storage.Increment(_key, _hash, _delta, value);
+    _respond(status, value, out);
+}
+
+} // namespace Execute
+} // namespace Afina
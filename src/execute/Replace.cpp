@@ -1,22 +1,17 @@
 #include <afina/Storage.h>
 #include <afina/execute/Replace.h>
 
-#include <iostream>
-
 namespace Afina {
 namespace Execute {
 
 // memcached protocol:  "replace" means "store this data, but only if the server *does*
 // already hold data for this key".
 
-void Replace::Execute(Storage &storage, const std::string &args, std::string &out) {
-    std::cout << "Replace(" << _key << "): " << args << std::endl;
-    std::string value;
-    if (storage.Get(_key, value)) {
-        storage.Set(_key, args);
-        out = "STORED";
+void Replace::Execute(Storage &storage, std::string &&args, Response &out) {
+    if (storage.Set(_key, _hash, Value(std::move(args)), expire_at())) {
+        out.Append("STORED");
     } else {
-        out = "NOT_STORED";
+        out.Append("NOT_STORED");
     }
 }
 
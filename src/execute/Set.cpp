@@ -1,16 +1,13 @@
 #include <afina/Storage.h>
 #include <afina/execute/Set.h>
 
-#include <iostream>
-
 namespace Afina {
 namespace Execute {
 
 // memcached protocol: "set" means "store this data".
-void Set::Execute(Storage &storage, const std::string &args, std::string &out) {
-    std::cout << "Set(" << _key << "): " << args << std::endl;
-    storage.Put(_key, args);
-    out = "STORED";
+void Set::Execute(Storage &storage, std::string &&args, Response &out) {
+    storage.Put(_key, _hash, Value(std::move(args)), expire_at());
+    out.Append("STORED");
 }
 
 } // namespace Execute
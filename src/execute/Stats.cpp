@@ -1,6 +1,7 @@
 #include <afina/Storage.h>
 #include <afina/execute/Stats.h>
 
+#include <iomanip>
 #include <iostream>
 #include <iterator>
 #include <sstream>
@@ -8,7 +9,25 @@
 namespace Afina {
 namespace Execute {
 
-void Stats::Execute(Storage &storage, const std::string &args, std::string &out) { out.assign("END"); }
+void Stats::Execute(Storage &storage, std::string &&args, Response &out) {
+    StorageStats stats;
+    storage.GetStats(stats);
+
+    uint64_t gets = stats.get_hits + stats.get_misses;
+    double hit_ratio = gets > 0 ? double(stats.get_hits) / gets : 0.0;
+
+    std::stringstream outStream;
+    outStream << "STAT get_hits " << stats.get_hits << "\r\n";
+    outStream << "STAT get_misses " << stats.get_misses << "\r\n";
+    outStream << "STAT hit_ratio " << std::fixed << std::setprecision(4) << hit_ratio << "\r\n";
+    outStream << "STAT evictions " << stats.evictions << "\r\n";
+    outStream << "STAT curr_items " << stats.curr_items << "\r\n";
+    outStream << "STAT bytes " << stats.bytes << "\r\n";
+    outStream << "STAT limit_maxbytes " << stats.limit_maxbytes << "\r\n";
+    outStream << "END"; // networking layer should add the last \r\n
+
+    out.Append(outStream.str());
+}
 
 } // namespace Execute
 } // namespace Afina
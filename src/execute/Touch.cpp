@@ -0,0 +1,13 @@
+#include <afina/Storage.h>
+#include <afina/execute/Touch.h>
+
+namespace Afina {
+namespace Execute {
+
+// memcached protocol: "touch" is used to update the expiration time of an existing item without fetching it.
+void Touch::Execute(Storage &storage, std::string &&args, Response &out) {
+    out.Append(storage.Touch(_key, _hash, ExpireAt(_expire)) ? "TOUCHED" : "NOT_FOUND");
+}
+
+} // namespace Execute
+} // namespace Afina
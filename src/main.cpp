@@ -21,8 +21,14 @@
 #include "network/st_coroutine/ServerImpl.h"
 #include "network/st_nonblocking/ServerImpl.h"
 
+#include "storage/ClockLRU.h"
+#include "storage/GlobalLock.h"
+#include "storage/OptimisticCuckoo.h"
+#include "storage/PerCoreStorage.h"
 #include "storage/SimpleLRU.h"
 #include "storage/ThreadSafeSimpleLRU.h"
+#include "storage/TinyLFU.h"
+#include "storage/TwoQueue.h"
 #include "storage/StripedLockLRU.h"
 
 using namespace Afina;
@@ -58,6 +64,19 @@ public:
             storage = std::make_shared<Afina::Backend::ThreadSafeSimplLRU>();
         } else if (storage_type == "mt_stl_lru") {
             storage.reset(Afina::Backend::StripedLockLRU::create_striped_lock_lru(1024, 4));
+        } else if (storage_type == "mt_clock") {
+            storage = std::make_shared<Afina::Backend::ClockLRU>();
+        } else if (storage_type == "mt_cuckoo") {
+            storage = std::make_shared<Afina::Backend::OptimisticCuckoo>();
+        } else if (storage_type == "st_tinylfu") {
+            storage = std::make_shared<Afina::Backend::TinyLFU>();
+        } else if (storage_type == "mt_tinylfu") {
+            storage = std::make_shared<Afina::Backend::GlobalLock<Afina::Backend::TinyLFU>>();
+        } else if (storage_type == "mt_percore") {
+            storage = std::make_shared<Afina::Backend::PerCoreStorage>();
+        } else if (storage_type == "mt_2q") {
+            storage.reset(Afina::Backend::StripedLockLRU::create_striped_lock_lru(
+                1024, 4, [](size_t size) { return new Afina::Backend::GlobalLock<Afina::Backend::TwoQueue>(size); }));
         } else {
             throw std::runtime_error("Unknown storage type");
         }
@@ -76,6 +95,8 @@ public:
             server = std::make_shared<Afina::Network::STnonblock::ServerImpl>(storage, logService);
         } else if (network_type == "mt_nonblock") {
             server = std::make_shared<Afina::Network::MTnonblock::ServerImpl>(storage, logService);
+        } else if (network_type == "mt_reuseport") {
+            server = std::make_shared<Afina::Network::MTnonblock::ServerImpl>(storage, logService, true);
         } else if (network_type == "st_coroutine") {
             server = std::make_shared<Afina::Network::STcoroutine::ServerImpl>(storage, logService);
         } else {
@@ -0,0 +1,62 @@
+#include "InputBuffer.h"
+
+#include <algorithm>
+#include <cstring>
+
+#include <unistd.h>
+
+namespace Afina {
+namespace Network {
+
+constexpr size_t InputBuffer::kMaxRead;
+
+// See InputBuffer.h
+InputBuffer::InputBuffer(size_t initial_size)
+    : _initial_size(initial_size), _data(new char[initial_size]), _capacity(initial_size), _begin(0), _end(0) {}
+
+// See InputBuffer.h
+char *InputBuffer::Reserve(size_t n) {
+    if (_capacity - _end >= n) {
+        return _data.get() + _end;
+    }
+
+    size_t size = Size();
+    if (_capacity - size >= n) {
+        std::memmove(_data.get(), _data.get() + _begin, size);
+    } else {
+        size_t capacity = std::max(_capacity * 2, size + n);
+        std::unique_ptr<char[]> data(new char[capacity]);
+        std::memcpy(data.get(), _data.get() + _begin, size);
+        _data.swap(data);
+        _capacity = capacity;
+    }
+    _begin = 0;
+    _end = size;
+    return _data.get() + _end;
+}
+
+// See InputBuffer.h
+ssize_t InputBuffer::ReadFrom(int socket, size_t want) {
+    // Don't read by tiny pieces even if there is a little left to read, it is cheaper to get next command as well
+    size_t room = std::max(std::min(want, kMaxRead), _initial_size / 2);
+    char *to = Reserve(room);
+
+    ssize_t readed = read(socket, to, _capacity - _end);
+    if (readed > 0) {
+        Commit(readed);
+    }
+    return readed;
+}
+
+// See InputBuffer.h
+void InputBuffer::Shrink() {
+    if (!Empty() || _capacity <= _initial_size) {
+        return;
+    }
+    _data.reset(new char[_initial_size]);
+    _capacity = _initial_size;
+    _begin = _end = 0;
+}
+
+} // namespace Network
+} // namespace Afina
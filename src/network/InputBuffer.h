@@ -0,0 +1,97 @@
+#ifndef AFINA_NETWORK_INPUT_BUFFER_H
+#define AFINA_NETWORK_INPUT_BUFFER_H
+
+#include <cstddef>
+#include <memory>
+
+#include <sys/types.h>
+
+namespace Afina {
+namespace Network {
+
+/**
+ * # Connection input buffer
+ * Bytes read from the socket but not processed yet. Read cursor moves forward as bytes are consumed and write cursor
+ * as bytes are read in, so consuming bytes costs nothing. Unread bytes are moved to the front only when there is no
+ * room left after them, that is at most once per buffer fill, and cursors jump back to the front for free as soon
+ * as everything has been consumed.
+ *
+ * Buffer grows when caller asks for more room than it has, e.g. to receive large value in one go, and goes back to
+ * the initial size on Shrink once there is nothing left to process.
+ *
+ * Unread bytes are always contiguous, so parser could run over them directly.
+ *
+ * That is NOT thread safe implementation!!
+ */
+class InputBuffer {
+public:
+    InputBuffer(size_t initial_size = 4096);
+    ~InputBuffer() {}
+
+    InputBuffer(const InputBuffer &) = delete;
+    InputBuffer &operator=(const InputBuffer &) = delete;
+
+    /**
+     * Unread bytes
+     */
+    inline const char *Data() const { return _data.get() + _begin; }
+
+    inline size_t Size() const { return _end - _begin; }
+
+    inline bool Empty() const { return _begin == _end; }
+
+    inline size_t Capacity() const { return _capacity; }
+
+    /**
+     * Marks first n unread bytes as processed
+     */
+    inline void Consume(size_t n) {
+        _begin += n;
+        if (_begin == _end) {
+            _begin = _end = 0;
+        }
+    }
+
+    /**
+     * Drops all unread bytes
+     */
+    inline void Clear() { _begin = _end = 0; }
+
+    /**
+     * Makes room for at least n more bytes after unread ones and returns where to put them, see Commit
+     */
+    char *Reserve(size_t n);
+
+    /**
+     * Appends n bytes written into the room given by Reserve
+     */
+    inline void Commit(size_t n) { _end += n; }
+
+    /**
+     * Reads from the socket as much as fits, making room for at least want bytes first. Returns result of read
+     */
+    ssize_t ReadFrom(int socket, size_t want = 0);
+
+    /**
+     * Returns memory taken by growth back to the system if there is nothing left to process
+     */
+    void Shrink();
+
+private:
+    // Largest room made in advance by ReadFrom, larger values come by several reads
+    static constexpr size_t kMaxRead = 1 << 20;
+
+    const size_t _initial_size;
+
+    std::unique_ptr<char[]> _data;
+    size_t _capacity;
+
+    // Unread bytes are [_begin, _end)
+    size_t _begin;
+    size_t _end;
+};
+
+} // namespace Network
+} // namespace Afina
+
+#endif // AFINA_NETWORK_INPUT_BUFFER_H
@@ -0,0 +1,78 @@
+#include "Transfer.h"
+
+#include <algorithm>
+#include <cerrno>
+#include <climits>
+#include <cstring>
+#include <stdexcept>
+
+#include <sys/uio.h>
+#include <unistd.h>
+
+namespace Afina {
+namespace Network {
+
+// See Transfer.h
+void receive_argument(int socket, std::string &argument, size_t size) {
+    while (size > 0) {
+        size_t chunk = std::min(size, kReceiveChunk);
+        size_t offset = argument.size();
+        argument.resize(offset + chunk);
+        for (size_t filled = 0; filled < chunk;) {
+            ssize_t readed = read(socket, &argument[offset + filled], chunk - filled);
+            if (readed <= 0) {
+                throw std::runtime_error("Failed to receive command argument");
+            }
+            filled += readed;
+        }
+        size -= chunk;
+    }
+}
+
+// See Transfer.h
+ssize_t receive_argument_part(int socket, std::string &argument, size_t &filled, size_t &remains) {
+    if (argument.size() == filled) {
+        argument.resize(filled + std::min(remains, kReceiveChunk));
+    }
+
+    ssize_t readed = read(socket, &argument[filled], argument.size() - filled);
+    if (readed > 0) {
+        filled += readed;
+        remains -= readed;
+    }
+    return readed;
+}
+
+// See Transfer.h
+void send_response(int socket, const Execute::Response &response) {
+    struct iovec iov[IOV_MAX];
+    size_t sent = 0;
+    while (sent < response.Size()) {
+        size_t n = response.Gather(iov, IOV_MAX, sent);
+        ssize_t written = writev(socket, iov, n);
+        if (written <= 0) {
+            throw std::runtime_error("Failed to send response");
+        }
+        sent += written;
+    }
+}
+
+// See Transfer.h
+bool send_response_part(int socket, const Execute::Response &response, size_t &sent) {
+    struct iovec iov[IOV_MAX];
+    while (sent < response.Size()) {
+        size_t n = response.Gather(iov, IOV_MAX, sent);
+        ssize_t written = writev(socket, iov, n);
+        if (written > 0) {
+            sent += written;
+        } else if (written < 0 && (errno == EAGAIN || errno == EWOULDBLOCK)) {
+            return false;
+        } else if (written == 0 || errno != EINTR) {
+            throw std::runtime_error("Failed to send response: " + std::string(strerror(errno)));
+        }
+    }
+    return true;
+}
+
+} // namespace Network
+} // namespace Afina
@@ -0,0 +1,53 @@
+#ifndef AFINA_NETWORK_TRANSFER_H
+#define AFINA_NETWORK_TRANSFER_H
+
+#include <cstddef>
+#include <string>
+
+#include <sys/types.h>
+
+#include <afina/execute/Response.h>
+
+namespace Afina {
+namespace Network {
+
+// Rest of the command argument larger than that is received right into the argument, bypassing connection input
+constexpr size_t kDirectReceive = 16 * 1024;
+
+// Argument is received by chunks of that size at most
+constexpr size_t kReceiveChunk = 1 << 20;
+
+// Argument buffer reserved up front is not larger than that, larger value grows as it arrives
+constexpr size_t kMaxReserve = 64 << 20;
+
+/**
+ * Receives size bytes from the blocking socket appending them to the argument, which storage takes over as is, see
+ * Afina::Value. Each byte is written just once, the buffer is reallocated only if it hasn't been reserved. Throws
+ * if socket fails or gets closed before the whole argument arrives
+ */
+void receive_argument(int socket, std::string &argument, size_t size);
+
+/**
+ * Same as receive_argument, but does a single read from the non blocking socket. First filled bytes of the argument
+ * have arrived already, remains bytes are yet to come: both are updated by what has been read. Room past the filled
+ * bytes is made by chunks and zero filled once, so it could take several calls to fill it. Returns result of read
+ */
+ssize_t receive_argument_part(int socket, std::string &argument, size_t &filled, size_t &remains);
+
+/**
+ * Writes the whole response into the blocking socket, values go to the socket right from their buffers. Response
+ * usually fits into a single writev call. Throws if socket fails
+ */
+void send_response(int socket, const Execute::Response &response);
+
+/**
+ * Same as send_response, but writes into the non blocking socket as much as it accepts. First sent bytes of the
+ * response are in the socket already, counter is updated by what has been written. Returns true once the whole
+ * response is written and false if socket doesn't accept any more bytes for now
+ */
+bool send_response_part(int socket, const Execute::Response &response, size_t &sent);
+
+} // namespace Network
+} // namespace Afina
+
+#endif // AFINA_NETWORK_TRANSFER_H
@@ -1,25 +1,190 @@
 #include "Connection.h"
 
-#include <iostream>
+#include <algorithm>
+#include <cerrno>
+#include <stdexcept>
+
+#include <sys/socket.h>
+#include <unistd.h>
+
+#include <spdlog/logger.h>
+
+#include <afina/Storage.h>
+
+#include "network/Transfer.h"
 
 namespace Afina {
 namespace Network {
 namespace MTnonblock {
 
+// Connection stops reading commands once that many bytes of responses are waiting for the client to take them
+static constexpr size_t kMaxQueued = 4 << 20;
+
 // See Connection.h
-void Connection::Start() { std::cout << "Start" << std::endl; }
+void Connection::Start(int epoll_fd) {
+    _epoll_fd = epoll_fd;
+    _event.events = EPOLLIN | EPOLLRDHUP | EPOLLET;
+    _alive = true;
+}
 
 // See Connection.h
-void Connection::OnError() { std::cout << "OnError" << std::endl; }
+void Connection::OnError() {
+    _logger->debug("Connection on descriptor {} failed", _socket);
+    _alive = false;
+}
 
 // See Connection.h
-void Connection::OnClose() { std::cout << "OnClose" << std::endl; }
+void Connection::OnClose() {
+    _logger->debug("Connection on descriptor {} closed", _socket);
+    _alive = false;
+}
 
 // See Connection.h
-void Connection::DoRead() { std::cout << "DoRead" << std::endl; }
+void Connection::DoRead() {
+    // Socket is left alone while client doesn't take responses, DoWrite resumes reading once they are written.
+    // Once client has closed its side there is nothing left to read
+    if (_read_paused || _input_ended) {
+        return;
+    }
+
+    try {
+        for (;;) {
+            // Once the input is used up, large value comes right into its buffer until it is complete
+            ssize_t readed;
+            if (_command && _input.Empty() && (_arg_remains > kDirectReceive || _argument.size() > _arg_filled)) {
+                readed = _receive_argument();
+            } else {
+                readed = _input.ReadFrom(_socket, _command ? _arg_remains : 0);
+            }
+
+            if (readed > 0) {
+                _logger->debug("Got {} bytes from socket", readed);
+                _process();
+
+                // Responses to the commands of the batch go in one go, commands are not read any further while
+                // client doesn't take them
+                if (!_send() && _output.Size() - _written > kMaxQueued) {
+                    _read_paused = true;
+                    break;
+                }
+            } else if (readed == 0) {
+                // Client could close its side and still wait for responses, connection is closed only once
+                // they are written, otherwise DoWrite does that
+                _input_ended = true;
+                if (_send()) {
+                    OnClose();
+                }
+                return;
+            } else if (errno == EAGAIN || errno == EWOULDBLOCK) {
+                break;
+            } else if (errno != EINTR) {
+                throw std::runtime_error(std::string(strerror(errno)));
+            }
+        }
+
+        // Memory taken by large value is not needed anymore once everything is processed
+        _input.Shrink();
+    } catch (std::runtime_error &ex) {
+        _logger->error("Failed to process connection on descriptor {}: {}", _socket, ex.what());
+        OnError();
+    }
+}
 
 // See Connection.h
-void Connection::DoWrite() { std::cout << "DoWrite" << std::endl; }
+void Connection::DoWrite() {
+    bool sent = false;
+    try {
+        sent = _send();
+    } catch (std::runtime_error &ex) {
+        _logger->error("Failed to write to connection on descriptor {}: {}", _socket, ex.what());
+        OnError();
+        return;
+    }
+
+    if (sent && _input_ended) {
+        OnClose();
+    } else if (sent && _read_paused) {
+        _read_paused = false;
+        DoRead();
+    }
+}
+
+void Connection::_process() {
+    for (;;) {
+        // There is no command yet
+        if (!_command) {
+            std::size_t parsed = 0;
+            if (_input.Empty()) {
+                return;
+            }
+            if (_parser.Parse(_input.Data(), _input.Size(), parsed)) {
+                _logger->debug("Found new command: {} in {} bytes", _parser.Name(), parsed);
+                _parser.Build(_command, _arg_remains);
+                if (_arg_remains > 0) {
+                    _arg_remains += 2;
+                    // Size of the value is known, so its buffer is allocated just once
+                    _argument.reserve(std::min(_arg_remains, kMaxReserve));
+                }
+            }
+
+            if (parsed == 0) {
+                return;
+            }
+            _input.Consume(parsed);
+        }
+
+        // There is command, but we still wait for argument to arrive...
+        if (_command && _arg_remains > 0) {
+            std::size_t to_read = std::min(_arg_remains, _input.Size());
+            _argument.append(_input.Data(), to_read);
+            _input.Consume(to_read);
+            _arg_filled += to_read;
+            _arg_remains -= to_read;
+            if (_arg_remains > 0) {
+                return;
+            }
+        }
+
+        // There is command & argument - RUN!
+        if (_command) {
+            _argument.resize(_arg_filled > 0 ? _arg_filled - 2 : 0);
+            _command.Execute(*_pStorage, std::move(_argument), _output);
+            _output.Append("\r\n", 2);
+
+            // Prepare for the next command
+            _command.Reset();
+            _argument.resize(0);
+            _arg_filled = 0;
+            _parser.Reset();
+        }
+    }
+}
+
+ssize_t Connection::_receive_argument() { return receive_argument_part(_socket, _argument, _arg_filled, _arg_remains); }
+
+bool Connection::_send() {
+    if (!send_response_part(_socket, _output, _written)) {
+        _watch_output(true);
+        return false;
+    }
+
+    _output.Clear();
+    _written = 0;
+    _watch_output(false);
+    return true;
+}
+
+void Connection::_watch_output(bool on) {
+    uint32_t events = on ? (_event.events | EPOLLOUT) : (_event.events & ~uint32_t(EPOLLOUT));
+    if (events == _event.events) {
+        return;
+    }
+
+    _event.events = events;
+    if (epoll_ctl(_epoll_fd, EPOLL_CTL_MOD, _socket, &_event)) {
+        throw std::runtime_error("Failed to change connection events: " + std::string(strerror(errno)));
+    }
+}
 
 } // namespace MTnonblock
 } // namespace Network
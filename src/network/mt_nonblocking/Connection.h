@@ -2,23 +2,54 @@
 #define AFINA_NETWORK_MT_NONBLOCKING_CONNECTION_H
 
 #include <cstring>
+#include <memory>
+#include <string>
 
 #include <sys/epoll.h>
+#include <sys/types.h>
+
+#include <afina/execute/AnyCommand.h>
+#include <afina/execute/Response.h>
+
+#include "network/InputBuffer.h"
+#include "protocol/Parser.h"
+
+namespace spdlog {
+class logger;
+}
 
 namespace Afina {
+
+// Forward declaration, see afina/Storage.h
+class Storage;
+
 namespace Network {
 namespace MTnonblock {
 
+/**
+ * # Client connection
+ * Socket is watched by the epoll of a single worker in edge triggered mode, so connection is only ever touched by
+ * the thread of that worker and needs no locking. Each readiness event is handled completely: socket is read until
+ * EAGAIN, every complete command is executed and responses are written out by one writev per read. Responses the
+ * socket doesn't accept right away are queued and EPOLLOUT is watched for only while queue is not empty. Reading
+ * pauses while too much output is queued and resumes once it is written. Client closing its side doesn't drop
+ * responses queued for it, connection is closed once they are written.
+ */
 class Connection {
 public:
-    Connection(int s) : _socket(s) {
+    Connection(int s, std::shared_ptr<Afina::Storage> ps, std::shared_ptr<spdlog::logger> pl)
+        : _socket(s), _epoll_fd(-1), _alive(false), _read_paused(false), _input_ended(false), _pStorage(ps),
+          _logger(pl), _arg_remains(0), _arg_filled(0), _written(0) {
         std::memset(&_event, 0, sizeof(struct epoll_event));
         _event.data.ptr = this;
     }
 
-    inline bool isAlive() const { return true; }
+    inline bool isAlive() const { return _alive; }
 
-    void Start();
+    /**
+     * Prepares connection to be watched by the given epoll instance
+     */
+    void Start(int epoll_fd);
 
 protected:
     void OnError();
@@ -30,8 +61,49 @@ private:
     friend class Worker;
     friend class ServerImpl;
 
+    // Executes all complete commands of the input, responses are appended to the output
+    void _process();
+
+    // Reads rest of the large argument from the socket right into its buffer, returns result of read
+    ssize_t _receive_argument();
+
+    // Writes as much of the output as socket accepts, returns true if nothing is left
+    bool _send();
+
+    // Turns watching for EPOLLOUT on or off
+    void _watch_output(bool on);
+
     int _socket;
+    int _epoll_fd;
     struct epoll_event _event;
+
+    bool _alive;
+
+    // Socket is not read since too much output is queued
+    bool _read_paused;
+
+    // Client has closed its side, connection is closed once output is written
+    bool _input_ended;
+
+    std::shared_ptr<Afina::Storage> _pStorage;
+    std::shared_ptr<spdlog::logger> _logger;
+
+    // Parse state of the stream and the last command parsed out of it
+    Protocol::Parser _parser;
+    Execute::AnyCommand _command;
+
+    // Argument of the command: buffer and how many bytes are yet to arrive. Buffer could be larger than what has
+    // arrived so far, the rest is the room for the next bytes, see _receive_argument
+    std::string _argument;
+    size_t _arg_remains;
+    size_t _arg_filled;
+
+    // Bytes read from the socket but not processed yet
+    InputBuffer _input;
+
+    // Responses not written yet, first _written bytes of them are already in the socket
+    Execute::Response _output;
+    size_t _written;
 };
 
 } // namespace MTnonblock
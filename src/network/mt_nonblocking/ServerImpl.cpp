@@ -9,6 +9,7 @@
 #include <arpa/inet.h>
 #include <netdb.h>
 #include <netinet/in.h>
+#include <sched.h>
 #include <signal.h>
 #include <sys/epoll.h>
 #include <sys/eventfd.h>
@@ -21,7 +22,6 @@
 #include <afina/Storage.h>
 #include <afina/logging/Service.h>
 
-#include "Connection.h"
 #include "Utils.h"
 #include "Worker.h"
 
@@ -30,7 +30,8 @@ namespace Network {
 namespace MTnonblock {
 
 // See Server.h
-ServerImpl::ServerImpl(std::shared_ptr<Afina::Storage> ps, std::shared_ptr<Logging::Service> pl) : Server(ps, pl) {}
+ServerImpl::ServerImpl(std::shared_ptr<Afina::Storage> ps, std::shared_ptr<Logging::Service> pl, bool reuse_port)
+    : Server(ps, pl), _reuse_port(reuse_port), _server_socket(-1) {}
 
 // See Server.h
 ServerImpl::~ServerImpl() {}
@@ -47,57 +48,43 @@ void ServerImpl::Start(uint16_t port, uint32_t n_acceptors, uint32_t n_workers)
         throw std::runtime_error("Unable to mask SIGPIPE");
     }
 
-    // Create server socket
-    struct sockaddr_in server_addr;
-    std::memset(&server_addr, 0, sizeof(server_addr));
-    server_addr.sin_family = AF_INET;         // IPv4
-    server_addr.sin_port = htons(port);       // TCP port number
-    server_addr.sin_addr.s_addr = INADDR_ANY; // Bind to any address
-
-    _server_socket = socket(PF_INET, SOCK_STREAM, IPPROTO_TCP);
-    if (_server_socket == -1) {
-        throw std::runtime_error("Failed to open socket: " + std::string(strerror(errno)));
-    }
-
-    int opts = 1;
-    if (setsockopt(_server_socket, SOL_SOCKET, (SO_KEEPALIVE), &opts, sizeof(opts)) == -1) {
-        close(_server_socket);
-        throw std::runtime_error("Socket setsockopt() failed: " + std::string(strerror(errno)));
-    }
-
-    if (bind(_server_socket, (struct sockaddr *)&server_addr, sizeof(server_addr)) == -1) {
-        close(_server_socket);
-        throw std::runtime_error("Socket bind() failed: " + std::string(strerror(errno)));
-    }
-
-    make_socket_non_blocking(_server_socket);
-    if (listen(_server_socket, 5) == -1) {
-        close(_server_socket);
-        throw std::runtime_error("Socket listen() failed: " + std::string(strerror(errno)));
-    }
-
-    // Start IO workers
-    _data_epoll_fd = epoll_create1(0);
-    if (_data_epoll_fd == -1) {
-        throw std::runtime_error("Failed to create epoll file descriptor: " + std::string(strerror(errno)));
-    }
-
+    // Start IO workers, each one has own epoll instance
     _event_fd = eventfd(0, EFD_NONBLOCK);
     if (_event_fd == -1) {
         throw std::runtime_error("Failed to create epoll file descriptor: " + std::string(strerror(errno)));
     }
 
-    struct epoll_event event;
-    event.events = EPOLLIN;
-    event.data.ptr = nullptr;
-    if (epoll_ctl(_data_epoll_fd, EPOLL_CTL_ADD, _event_fd, &event)) {
-        throw std::runtime_error("Failed to add eventfd descriptor to epoll");
+    // In reuse port mode every worker listens on its own socket and accepts connections itself, so connection
+    // never leaves thread that has accepted it and there are no acceptors at all
+    //
+    // There is one worker per core process is allowed to run on, pinned to it, so storage which keeps data per
+    // core could let worker serve that data right in its thread, see Storage::Attach
+    if (_reuse_port) {
+        cpu_set_t allowed;
+        CPU_ZERO(&allowed);
+        if (sched_getaffinity(0, sizeof(allowed), &allowed) != 0) {
+            throw std::runtime_error("Failed to get cores allowed: " + std::string(strerror(errno)));
+        }
+
+        _logger->info("Workers listen on port {} with SO_REUSEPORT, one per core", port);
+        _server_socket = -1;
+        _workers.reserve(CPU_COUNT(&allowed));
+        for (int core = 0; core < CPU_SETSIZE; core++) {
+            if (CPU_ISSET(core, &allowed)) {
+                _workers.emplace_back(pStorage, pLogging);
+                _workers.back().Start(_event_fd, listen_socket(port, true), core);
+            }
+        }
+        return;
     }
 
+    _server_socket = listen_socket(port, false);
+
+    _next_worker = 0;
     _workers.reserve(n_workers);
     for (int i = 0; i < n_workers; i++) {
         _workers.emplace_back(pStorage, pLogging);
-        _workers.back().Start(_data_epoll_fd);
+        _workers.back().Start(_event_fd);
     }
 
     // Start acceptors
@@ -130,6 +117,11 @@ void ServerImpl::Join() {
     for (auto &w : _workers) {
         w.Join();
     }
+
+    if (_server_socket != -1) {
+        close(_server_socket);
+    }
+    close(_event_fd);
 }
 
 // See ServerImpl.h
@@ -192,23 +184,8 @@ void ServerImpl::OnRun() {
                     _logger->info("Accepted connection on descriptor {} (host={}, port={})\n", infd, hbuf, sbuf);
                 }
 
-                // Register the new FD to be monitored by epoll.
-                Connection *pc = new Connection(infd);
-                if (pc == nullptr) {
-                    throw std::runtime_error("Failed to allocate connection");
-                }
-
-                // Register connection in worker's epoll
-                pc->Start();
-                if (pc->isAlive()) {
-                    pc->_event.events |= EPOLLONESHOT;
-                    int epoll_ctl_retval;
-                    if ((epoll_ctl_retval = epoll_ctl(_data_epoll_fd, EPOLL_CTL_ADD, pc->_socket, &pc->_event))) {
-                        _logger->debug("epoll_ctl failed during connection register in workers'epoll: error {}", epoll_ctl_retval);
-                        pc->OnError();
-                        delete pc;
-                    }
-                }
+                // Connections are spread over workers round robin
+                _workers[_next_worker.fetch_add(1, std::memory_order_relaxed) % _workers.size()].Accept(infd);
             }
         }
     }
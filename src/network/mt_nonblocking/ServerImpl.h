@@ -1,6 +1,7 @@
 #ifndef AFINA_NETWORK_MT_NONBLOCKING_SERVER_H
 #define AFINA_NETWORK_MT_NONBLOCKING_SERVER_H
 
+#include <atomic>
 #include <thread>
 #include <vector>
 
@@ -19,11 +20,16 @@ class Worker;
 
 /**
  * # Network resource manager implementation
- * Epoll based server
+ * Epoll based server: acceptors take connections from the shared server socket and give them to workers.
+ *
+ * In reuse port mode there are no acceptors, every worker has own listening socket bound to the same port with
+ * SO_REUSEPORT, so kernel spreads connections among workers and nothing is shared between them at all. Workers
+ * are started one per core and pinned to it regardless of the number asked, so they could serve storage requests
+ * of their cores as well.
  */
 class ServerImpl : public Server {
 public:
-    ServerImpl(std::shared_ptr<Afina::Storage> ps, std::shared_ptr<Logging::Service> pl);
+    ServerImpl(std::shared_ptr<Afina::Storage> ps, std::shared_ptr<Logging::Service> pl, bool reuse_port = false);
     ~ServerImpl();
 
     // See Server.h
@@ -43,26 +49,29 @@ private:
     // logger to use
     std::shared_ptr<spdlog::logger> _logger;
 
+    // Every worker listens on its own socket, see above
+    const bool _reuse_port;
+
     // Port to listen for new connections, permits access only from
     // inside of accept_thread
     // Read-only
     uint16_t listen_port;
 
-    // Socket to accept new connection on, shared between acceptors
+    // Socket to accept new connection on, shared between acceptors, -1 in reuse port mode
     int _server_socket;
 
     // Threads that accepts new connections, each has private epoll instance
     // but share global server socket
     std::vector<std::thread> _acceptors;
 
-    // EPOLL instance shared between workers
-    int _data_epoll_fd;
-
     // Curstom event "device" used to wakeup workers
     int _event_fd;
 
-    // threads serving read/write requests
+    // threads serving read/write requests, each one has own epoll instance
     std::vector<Worker> _workers;
+
+    // Worker to give the next accepted connection to
+    std::atomic<size_t> _next_worker;
 };
 
 } // namespace MTnonblock
@@ -1,12 +1,20 @@
 #ifndef AFINA_NETWORK_MT_NONBLOCKING_UTILS_H
 #define AFINA_NETWORK_MT_NONBLOCKING_UTILS_H
 
+#include <cstdint>
+
 namespace Afina {
 namespace Network {
 namespace MTnonblock {
 
 void make_socket_non_blocking(int sfd);
 
+/**
+ * Opens non blocking socket listening on the given port of any address. Sockets opened with reuse_port could
+ * listen on the same port together, kernel spreads incoming connections among them
+ */
+int listen_socket(uint16_t port, bool reuse_port);
+
 } // namespace MTnonblock
 } // namespace Network
 } // namespace Afina
@@ -1,16 +1,23 @@
 #include "Worker.h"
 
+#include <array>
 #include <cassert>
+#include <cstring>
 #include <functional>
 #include <iostream>
+#include <stdexcept>
 
 #include <netdb.h>
+#include <pthread.h>
+#include <sched.h>
 #include <sys/epoll.h>
 #include <sys/socket.h>
 #include <sys/types.h>
+#include <unistd.h>
 
 #include <spdlog/logger.h>
 
+#include <afina/Storage.h>
 #include <afina/logging/Service.h>
 
 #include "Connection.h"
@@ -20,15 +27,24 @@ namespace Afina {
 namespace Network {
 namespace MTnonblock {
 
+// How long worker serving storage requests waits for events before storage gets its maintenance
+static constexpr int kIdleTimeoutMs = 100;
+
 // See Worker.h
 Worker::Worker(std::shared_ptr<Afina::Storage> ps, std::shared_ptr<Afina::Logging::Service> pl)
-    : _pStorage(ps), _pLogging(pl), isRunning(false), _epoll_fd(-1) {
+    : _pStorage(ps), _pLogging(pl), isRunning(false), _epoll_fd(-1), _server_socket(-1), _core(-1),
+      _storage_fd(-1) {
     // TODO: implementation here
 }
 
 // See Worker.h
 Worker::~Worker() {
-    // TODO: implementation here
+    if (_epoll_fd != -1) {
+        close(_epoll_fd);
+    }
+    if (_server_socket != -1) {
+        close(_server_socket);
+    }
 }
 
 // See Worker.h
@@ -41,21 +57,72 @@ Worker &Worker::operator=(Worker &&other) {
     _logger = std::move(other._logger);
     _thread = std::move(other._thread);
     _epoll_fd = other._epoll_fd;
+    _server_socket = other._server_socket;
+    _core = other._core;
+    _storage_fd = other._storage_fd;
+    _connections = std::move(other._connections);
 
     other._epoll_fd = -1;
+    other._server_socket = -1;
     return *this;
 }
 
 // See Worker.h
-void Worker::Start(int epoll_fd) {
+void Worker::Start(int wakeup_fd, int server_socket, int core) {
     if (isRunning.exchange(true) == false) {
         assert(_epoll_fd == -1);
-        _epoll_fd = epoll_fd;
+        _epoll_fd = epoll_create1(0);
+        if (_epoll_fd == -1) {
+            throw std::runtime_error("Failed to create epoll file descriptor: " + std::string(strerror(errno)));
+        }
+
+        // nullptr marks wakeup event, see OnRun
+        struct epoll_event event;
+        event.events = EPOLLIN;
+        event.data.ptr = nullptr;
+        if (epoll_ctl(_epoll_fd, EPOLL_CTL_ADD, wakeup_fd, &event)) {
+            throw std::runtime_error("Failed to add wakeup descriptor to epoll");
+        }
+
+        // Own server socket is marked by pointer to it
+        _server_socket = server_socket;
+        if (_server_socket != -1) {
+            event.events = EPOLLIN;
+            event.data.ptr = &_server_socket;
+            if (epoll_ctl(_epoll_fd, EPOLL_CTL_ADD, _server_socket, &event)) {
+                throw std::runtime_error("Failed to add server socket to epoll");
+            }
+        }
+
+        _core = core;
         _logger = _pLogging->select("network.worker");
         _thread = std::thread(&Worker::OnRun, this);
     }
 }
 
+// See Worker.h
+void Worker::Accept(int client_socket) {
+    Connection *pconn = new Connection(client_socket, _pStorage, _logger);
+    pconn->Start(_epoll_fd);
+
+    std::lock_guard<std::mutex> lock(_connections_mutex);
+    if (!isRunning) {
+        // Worker has stopped or is about to, it won't see this connection anymore
+        close(client_socket);
+        delete pconn;
+        return;
+    }
+
+    // Connection is watched once and for all, it belongs to the worker thread as soon as it is registered
+    _connections.insert(pconn);
+    if (epoll_ctl(_epoll_fd, EPOLL_CTL_ADD, client_socket, &pconn->_event)) {
+        _logger->error("Failed to register connection on descriptor {}: {}", client_socket, strerror(errno));
+        _connections.erase(pconn);
+        close(client_socket);
+        delete pconn;
+    }
+}
+
 // See Worker.h
 void Worker::Stop() { isRunning = false; }
 
@@ -70,15 +137,27 @@ void Worker::OnRun() {
     assert(_epoll_fd >= 0);
     _logger->trace("OnRun");
 
+    // Worker pinned to the core serves storage requests of that core, so requests of its own clients to the
+    // data of the core run right in this thread. Storage does its maintenance when worker is idle
+    int timeout = -1;
+    if (_core != -1) {
+        _attach();
+        if (_storage_fd != -1) {
+            timeout = kIdleTimeoutMs;
+        }
+    }
+
     // Process connection events
     //
-    // Do not forget to use EPOLLEXCLUSIVE flag when register socket
-    // for events to avoid thundering herd type behavior.
-    int timeout = -1;
+    // Connections are watched in edge triggered mode: each event is handled completely, so there is nothing
+    // to rearm afterwards
     std::array<struct epoll_event, 64> mod_list;
     while (isRunning) {
         int nmod = epoll_wait(_epoll_fd, &mod_list[0], mod_list.size(), timeout);
         _logger->debug("Worker wokeup: {} events", nmod);
+        if (nmod == 0 && _storage_fd != -1) {
+            _pStorage->Serve();
+        }
 
         for (int i = 0; i < nmod; i++) {
             struct epoll_event &current_event = mod_list[i];
@@ -90,49 +169,127 @@ void Worker::OnRun() {
                 continue;
             }
 
+            // New connections on the own server socket
+            if (current_event.data.ptr == &_server_socket) {
+                _accept();
+                continue;
+            }
+
+            // Other threads wait for the storage requests given to this core
+            if (current_event.data.ptr == &_storage_fd) {
+                _pStorage->Serve();
+                continue;
+            }
+
             // Some connection gets new data
             Connection *pconn = static_cast<Connection *>(current_event.data.ptr);
             if ((current_event.events & EPOLLERR) || (current_event.events & EPOLLHUP)) {
                 _logger->debug("Got EPOLLERR or EPOLLHUP, value of returned events: {}", current_event.events);
                 pconn->OnError();
-            } else if (current_event.events & EPOLLRDHUP) {
-                _logger->debug("Got EPOLLRDHUP, value of returned events: {}", current_event.events);
-                pconn->OnClose();
             } else {
-                // Depends on what connection wants...
-                if (current_event.events & EPOLLIN) {
+                // Client could send commands and close its side right away, so EPOLLRDHUP means there is
+                // something to read as well: commands are executed and then read gets end of stream
+                if (current_event.events & (EPOLLIN | EPOLLRDHUP)) {
                     _logger->trace("Got EPOLLIN");
                     pconn->DoRead();
                 }
-                if (current_event.events & EPOLLOUT) {
+                if (pconn->isAlive() && (current_event.events & EPOLLOUT)) {
                     _logger->trace("Got EPOLLOUT");
                     pconn->DoWrite();
                 }
             }
 
-            // Rearm connection
-            if (pconn->isAlive()) {
-                pconn->_event.events |= EPOLLONESHOT;
-                int epoll_ctl_retval;
-                if ((epoll_ctl_retval = epoll_ctl(_epoll_fd, EPOLL_CTL_MOD, pconn->_socket, &pconn->_event))) {
-                    _logger->debug("epoll_ctl failed during connection rearm: error {}", epoll_ctl_retval);
-                    pconn->OnError();
-                    delete pconn;
-                }
-            }
-            // Or delete closed one
-            else {
-                if (epoll_ctl(_epoll_fd, EPOLL_CTL_DEL, pconn->_socket, &pconn->_event)) {
-                    std::cerr << "Failed to delete connection!" << std::endl;
-                }
-                delete pconn;
+            if (!pconn->isAlive()) {
+                _close(pconn);
             }
         }
-        // TODO: Select timeout...
     }
+
+    // Core goes back to the storage, requests of the other workers are served without this one from now on
+    if (_storage_fd != -1) {
+        epoll_ctl(_epoll_fd, EPOLL_CTL_DEL, _storage_fd, nullptr);
+        _pStorage->Detach();
+        _storage_fd = -1;
+    }
+
+    // No more connections are accepted. Kernel doesn't hand connections queued on the own socket to the other
+    // listeners, they are reset once it is closed. Server stops all the workers together, so nobody is left to
+    // serve them anyway
+    if (_server_socket != -1) {
+        close(_server_socket);
+        _server_socket = -1;
+    }
+
+    // Connections still open are closed, all the commands read from them have been executed and responses
+    // written, unless client doesn't take them
+    std::lock_guard<std::mutex> lock(_connections_mutex);
+    for (Connection *pconn : _connections) {
+        close(pconn->_socket);
+        delete pconn;
+    }
+    _connections.clear();
+
     _logger->warn("Worker stopped");
 }
 
+// See Worker.h
+void Worker::_attach() {
+    cpu_set_t cpus;
+    CPU_ZERO(&cpus);
+    CPU_SET(_core, &cpus);
+    if (pthread_setaffinity_np(pthread_self(), sizeof(cpus), &cpus) != 0) {
+        _logger->error("Failed to pin worker to core {}", _core);
+        return;
+    }
+
+    _storage_fd = _pStorage->Attach(_core);
+    if (_storage_fd == -1) {
+        return;
+    }
+
+    // Storage descriptor is marked by pointer to it
+    struct epoll_event event;
+    event.events = EPOLLIN;
+    event.data.ptr = &_storage_fd;
+    if (epoll_ctl(_epoll_fd, EPOLL_CTL_ADD, _storage_fd, &event)) {
+        _logger->error("Failed to add storage descriptor to epoll: {}", strerror(errno));
+        _pStorage->Detach();
+        _storage_fd = -1;
+        return;
+    }
+    _logger->info("Worker serves storage requests of core {}", _core);
+}
+
+// See Worker.h
+void Worker::_accept() {
+    for (;;) {
+        struct sockaddr in_addr;
+        socklen_t in_len = sizeof in_addr;
+        int infd = accept4(_server_socket, &in_addr, &in_len, SOCK_NONBLOCK | SOCK_CLOEXEC);
+        if (infd == -1) {
+            if ((errno != EAGAIN) && (errno != EWOULDBLOCK)) {
+                _logger->error("Failed to accept socket: {}", strerror(errno));
+            }
+            break;
+        }
+
+        _logger->debug("Accepted connection on descriptor {}", infd);
+        Accept(infd);
+    }
+}
+
+// See Worker.h
+void Worker::_close(Connection *pconn) {
+    {
+        std::lock_guard<std::mutex> lock(_connections_mutex);
+        _connections.erase(pconn);
+    }
+
+    // Socket is removed from epoll once it is closed
+    close(pconn->_socket);
+    delete pconn;
+}
+
 } // namespace MTnonblock
 } // namespace Network
 } // namespace Afina
@@ -3,7 +3,9 @@
 
 #include <atomic>
 #include <memory>
+#include <mutex>
 #include <thread>
+#include <unordered_set>
 
 namespace spdlog {
 class logger;
@@ -20,10 +22,14 @@ class Service;
 namespace Network {
 namespace MTnonblock {
 
+// Forward declaration, see Connection.h
+class Connection;
+
 /**
  * # Thread running epoll
- * On Start spaws background thread that is doing epoll on the given server
- * socket and process incoming connections and its data
+ * On Start spaws background thread that is doing epoll on its own epoll instance and process data of the
+ * connections given to it. Each connection is served by one worker only for all its life, so it is never touched
+ * by two threads at once and could be watched in edge triggered mode without rearming it after every event
  */
 class Worker {
 public:
@@ -34,11 +40,22 @@ public:
     Worker &operator=(Worker &&);
 
     /**
-     * Spaws new background thread that is doing epoll on the given server
-     * socket. Once connection accepted it must be registered and being processed
-     * on this thread
+     * Spaws new background thread that is doing epoll on its own epoll instance. Given
+     * descriptor is watched as well, so server could wake worker up by it.
+     *
+     * If server socket is given worker takes it over and accepts connections from it by
+     * itself, otherwise connections come by Accept
+     *
+     * If core is given worker thread is pinned to it and serves storage requests of that
+     * core as well, see Storage::Attach
      */
-    void Start(int epoll_fd);
+    void Start(int wakeup_fd, int server_socket = -1, int core = -1);
+
+    /**
+     * Takes accepted connection over, it is processed on the thread of this worker
+     * from now on. Could be called from any thread
+     */
+    void Accept(int client_socket);
 
     /**
      * Signal background thread to stop. After that signal thread must stop to
@@ -61,6 +78,15 @@ protected:
     void OnRun();
 
 private:
+    // Pins thread to the core and takes storage requests of the core over if storage wants it to
+    void _attach();
+
+    // Accepts all pending connections of the own server socket
+    void _accept();
+
+    // Closes connection and forgets about it
+    void _close(Connection *pconn);
+
     Worker(Worker &) = delete;
     Worker &operator=(Worker &) = delete;
 
@@ -81,6 +107,18 @@ private:
 
     // EPOLL descriptor using for events processing
     int _epoll_fd;
+
+    // Own listening socket of the worker, -1 if connections are accepted by the server
+    int _server_socket;
+
+    // Core worker is pinned to and descriptor storage wakes worker up by, -1 if there are none
+    int _core;
+    int _storage_fd;
+
+    // Connections served by this worker, guarded by the mutex since connections are added by acceptors. It is
+    // only taken when connection comes and goes
+    std::mutex _connections_mutex;
+    std::unordered_set<Connection *> _connections;
 };
 
 } // namespace MTnonblock
@@ -18,9 +18,11 @@
 #include <spdlog/logger.h>
 
 #include <afina/Storage.h>
-#include <afina/execute/Command.h>
+#include <afina/execute/AnyCommand.h>
 #include <afina/logging/Service.h>
 
+#include "network/InputBuffer.h"
+#include "network/Transfer.h"
 #include "protocol/Parser.h"
 
 namespace Afina {
@@ -125,10 +127,14 @@ void ServerImpl::OnRun() {
     // - command_to_execute: last command parsed out of stream
     // - arg_remains: how many bytes to read from stream to get command argument
     // - argument_for_command: buffer stores argument
+    // - input: bytes read from the socket but not processed yet
+    // - output: responses of the commands executed so far, not sent yet
     std::size_t arg_remains;
     Protocol::Parser parser;
     std::string argument_for_command;
-    std::unique_ptr<Execute::Command> command_to_execute;
+    InputBuffer input;
+    Execute::Response output;
+    Execute::AnyCommand command_to_execute;
     while (running.load()) {
         _logger->debug("waiting for connection...");
 
@@ -166,27 +172,28 @@ void ServerImpl::OnRun() {
         // - execute each command
         // - send response
         try {
-            int readed_bytes = -1;
-            char client_buffer[4096];
-            while ((readed_bytes = read(client_socket, client_buffer, sizeof(client_buffer))) > 0) {
+            ssize_t readed_bytes = -1;
+            while ((readed_bytes = input.ReadFrom(client_socket, command_to_execute ? arg_remains : 0)) > 0) {
                 _logger->debug("Got {} bytes from socket", readed_bytes);
 
                 // Single block of data readed from the socket could trigger inside actions a multiple times,
                 // for example:
                 // - read#0: [<command1 start>]
                 // - read#1: [<command1 end> <argument> <command2> <argument for command 2> <command3> ... ]
-                while (readed_bytes > 0) {
-                    _logger->debug("Process {} bytes", readed_bytes);
+                while (!input.Empty()) {
+                    _logger->debug("Process {} bytes", input.Size());
                     // There is no command yet
                     if (!command_to_execute) {
                         std::size_t parsed = 0;
-                        if (parser.Parse(client_buffer, readed_bytes, parsed)) {
+                        if (parser.Parse(input.Data(), input.Size(), parsed)) {
                             // There is no command to be launched, continue to parse input stream
                             // Here we are, current chunk finished some command, process it
                             _logger->debug("Found new command: {} in {} bytes", parser.Name(), parsed);
-                            command_to_execute = parser.Build(arg_remains);
+                            parser.Build(command_to_execute, arg_remains);
                             if (arg_remains > 0) {
                                 arg_remains += 2;
+                                // Size of the value is known, so its buffer is allocated just once
+                                argument_for_command.reserve(std::min(arg_remains, kMaxReserve));
                             }
                         }
 
@@ -195,45 +202,52 @@ void ServerImpl::OnRun() {
                         if (parsed == 0) {
                             break;
                         } else {
-                            std::memmove(client_buffer, client_buffer + parsed, readed_bytes - parsed);
-                            readed_bytes -= parsed;
+                            input.Consume(parsed);
                         }
                     }
 
                     // There is command, but we still wait for argument to arrive...
                     if (command_to_execute && arg_remains > 0) {
-                        _logger->debug("Fill argument: {} bytes of {}", readed_bytes, arg_remains);
+                        _logger->debug("Fill argument: {} bytes of {}", input.Size(), arg_remains);
                         // There is some parsed command, and now we are reading argument
-                        std::size_t to_read = std::min(arg_remains, std::size_t(readed_bytes));
-                        argument_for_command.append(client_buffer, to_read);
-
-                        std::memmove(client_buffer, client_buffer + to_read, readed_bytes - to_read);
+                        std::size_t to_read = std::min(arg_remains, input.Size());
+                        argument_for_command.append(input.Data(), to_read);
+                        input.Consume(to_read);
                         arg_remains -= to_read;
-                        readed_bytes -= to_read;
+
+                        // Input is empty by now, rest of the large value goes from the socket right into its buffer
+                        if (arg_remains > kDirectReceive) {
+                            _logger->debug("Receive argument: {} bytes", arg_remains);
+                            receive_argument(client_socket, argument_for_command, arg_remains);
+                            arg_remains = 0;
+                        }
                     }
 
                     // Thre is command & argument - RUN!
                     if (command_to_execute && arg_remains == 0) {
                         _logger->debug("Start command execution");
 
-                        std::string result;
                         if (argument_for_command.size()) {
                             argument_for_command.resize(argument_for_command.size() - 2);
                         }
-                        command_to_execute->Execute(*pStorage, argument_for_command, result);
-
-                        // Send response
-                        result += "\r\n";
-                        if (send(client_socket, result.data(), result.size(), 0) <= 0) {
-                            throw std::runtime_error("Failed to send response");
-                        }
+                        command_to_execute.Execute(*pStorage, std::move(argument_for_command), output);
+                        output.Append("\r\n", 2);
 
                         // Prepare for the next command
-                        command_to_execute.reset();
+                        command_to_execute.Reset();
                         argument_for_command.resize(0);
                         parser.Reset();
                     }
                 } // while (readed_bytes)
+
+                // Responses to all the commands of the batch go in one go, in the order commands came
+                if (!output.Empty()) {
+                    send_response(client_socket, output);
+                    output.Clear();
+                }
+
+                // Memory taken by large value is not needed anymore once everything is processed
+                input.Shrink();
             }
 
             if (readed_bytes == 0) {
@@ -249,8 +263,11 @@ void ServerImpl::OnRun() {
         close(client_socket);
 
         // Prepare for the next command: just in case if connection was closed in the middle of executing something
-        command_to_execute.reset();
+        command_to_execute.Reset();
         argument_for_command.resize(0);
+        output.Clear();
+        input.Clear();
+        input.Shrink();
         parser.Reset();
     }
 
@@ -1,22 +1,150 @@
 #include "Parser.h"
 
+#include <climits>
+#include <cstring>
 #include <iostream>
 #include <sstream>
 #include <stdexcept>
 
+#if defined(__AVX2__)
+#include <immintrin.h>
+#elif defined(__SSE2__)
+#include <emmintrin.h>
+#endif
+
+#include <afina/Hash.h>
 #include <afina/execute/Add.h>
+#include <afina/execute/AnyCommand.h>
 #include <afina/execute/Append.h>
+#include <afina/execute/Cas.h>
 #include <afina/execute/Command.h>
+#include <afina/execute/Decr.h>
 #include <afina/execute/Delete.h>
+#include <afina/execute/FlushAll.h>
+#include <afina/execute/FlushNamespace.h>
+#include <afina/execute/Gat.h>
+#include <afina/execute/Gats.h>
 #include <afina/execute/Get.h>
+#include <afina/execute/Gets.h>
+#include <afina/execute/Incr.h>
+#include <afina/execute/Prepend.h>
+#include <afina/execute/Replace.h>
 #include <afina/execute/Set.h>
 #include <afina/execute/Stats.h>
+#include <afina/execute/Touch.h>
 
 namespace Afina {
 namespace Protocol {
 
+// Returns position of the first byte equal to c in [begin, end) or end if there is none
+static const char *find_byte(const char *begin, const char *end, char c) {
+#if defined(__AVX2__)
+    const __m256i pattern = _mm256_set1_epi8(c);
+    for (; end - begin >= 32; begin += 32) {
+        __m256i block = _mm256_loadu_si256(reinterpret_cast<const __m256i *>(begin));
+        uint32_t mask = _mm256_movemask_epi8(_mm256_cmpeq_epi8(block, pattern));
+        if (mask != 0) {
+            return begin + __builtin_ctz(mask);
+        }
+    }
+#endif
+#if defined(__SSE2__)
+    const __m128i pattern16 = _mm_set1_epi8(c);
+    for (; end - begin >= 16; begin += 16) {
+        __m128i block = _mm_loadu_si128(reinterpret_cast<const __m128i *>(begin));
+        uint32_t mask = _mm_movemask_epi8(_mm_cmpeq_epi8(block, pattern16));
+        if (mask != 0) {
+            return begin + __builtin_ctz(mask);
+        }
+    }
+#endif
+    while (begin < end && *begin != c) {
+        begin++;
+    }
+    return begin;
+}
+
+// Cuts the next token out of [pos, end), tokens are separated by single spaces and pos moves past the separator.
+// Returns false if line is over or token is empty
+static bool next_token(const char *&pos, const char *end, const char *&token, size_t &token_size) {
+    if (pos > end) {
+        return false;
+    }
+    const char *space = find_byte(pos, end, ' ');
+    token = pos;
+    token_size = space - pos;
+    pos = space + 1;
+    return token_size != 0;
+}
+
+// Parses decimal number not greater than limit. Digits are checked all at once at the end, so there is no branch
+// per digit. Returns false if token is not a number or number is too large
+static bool parse_number(const char *token, size_t size, uint64_t limit, uint64_t &value) {
+    if (size == 0 || size > 20) {
+        return false;
+    }
+
+    // 19 digits always fit into 64 bits, only the last one could overflow
+    uint64_t result = 0;
+    uint32_t invalid = 0;
+    for (size_t i = 0; i + 1 < size; i++) {
+        uint32_t digit = uint8_t(token[i]) - '0';
+        invalid |= digit > 9;
+        result = result * 10 + digit;
+    }
+    uint32_t digit = uint8_t(token[size - 1]) - '0';
+    invalid |= digit > 9;
+    if (invalid || (size == 20 && result > (limit - digit) / 10) || result * 10 + digit > limit) {
+        return false;
+    }
+    value = result * 10 + digit;
+    return true;
+}
+
+static bool next_number(const char *&pos, const char *end, uint64_t limit, uint64_t &value) {
+    const char *token;
+    size_t size;
+    return next_token(pos, end, token, size) && parse_number(token, size, limit, value);
+}
+
+// Parses expire time, which could be negative
+static bool next_expire(const char *&pos, const char *end, int32_t &value) {
+    const char *token;
+    size_t size;
+    if (!next_token(pos, end, token, size)) {
+        return false;
+    }
+
+    uint64_t number;
+    if (token[0] == '-') {
+        if (!parse_number(token + 1, size - 1, uint64_t(INT32_MAX) + 1, number)) {
+            return false;
+        }
+        value = int32_t(-int64_t(number));
+    } else {
+        if (!parse_number(token, size, INT32_MAX, number)) {
+            return false;
+        }
+        value = int32_t(number);
+    }
+    return true;
+}
+
+// Names of the commands by id, see Parser::CommandId
+static const std::string command_names[] = {"",    "set",  "add",       "replace",  "append", "prepend",
+                                            "cas", "get",  "gets",      "incr",     "decr",   "touch",
+                                            "gat", "gats", "flush_all", "flush_ns", "stats"};
+
 // See Parse.h
 bool Parser::Parse(const char *input, const size_t size, size_t &parsed) {
+    if (state == State::sName && name_size == 0) {
+        if (_parse_line(input, size, parsed)) {
+            return true;
+        }
+        // State machine starts over, so that whatever fast path has done doesn't matter
+        Reset();
+    }
+
     size_t pos;
     parsed = 0;
 
@@ -27,19 +155,56 @@ bool Parser::Parse(const char *input, const size_t size, size_t &parsed) {
         switch (state) {
         case State::sName: {
             if (c == ' ' || c == '\r') {
-                // std::cout << "parser debug: name='" << name << "'" << std::endl;
-                if (name == "set" || name == "add" || name == "append" || name == "prepend") {
+                command = _command_of(name, name_size);
+                switch (command) {
+                case cSet:
+                case cAdd:
+                case cReplace:
+                case cAppend:
+                case cPrepend:
+                case cCas:
                     state = State::spKey;
-                } else if (name == "get" || name == "gets") {
+                    break;
+                case cGet:
+                case cGets:
                     state = State::sgKey;
-                } else if (name == "stats") {
+                    break;
+                case cFlushNs:
+                    if (c == '\r') {
+                        throw std::runtime_error("Client provides no namespace to flush");
+                    }
+                    state = State::sgKey;
+                    break;
+                case cIncr:
+                case cDecr:
+                    state = State::saKey;
+                    break;
+                case cTouch:
+                    state = State::stKey;
+                    break;
+                case cGat:
+                case cGats:
+                    negative = false;
+                    state = State::spExprTimeStart;
+                    break;
+                case cFlushAll:
+                    if (c == ' ') {
+                        negative = false;
+                        state = State::spExprTimeStart;
+                        break;
+                    }
                     state = State::sLF;
-                    continue;
-                } else {
-                    throw std::runtime_error("Unknown command name: " + name);
+                    break;
+                case cStats:
+                    state = State::sLF;
+                    break;
+                default:
+                    throw std::runtime_error("Unknown command name: " + std::string(name, name_size));
                 }
+            } else if (name_size < sizeof(name)) {
+                name[name_size++] = c;
             } else {
-                name.push_back(c);
+                throw std::runtime_error("Unknown command name: " + std::string(name, name_size) + "...");
             }
             break;
         }
@@ -47,32 +212,78 @@ bool Parser::Parse(const char *input, const size_t size, size_t &parsed) {
         case State::spKey: {
             if (c == ' ') {
                 state = State::spFlags;
-                keys.push_back(curKey);
-                // std::cout << "parser debug: key[" << keys.size() - 1 << "]='" << curKey << "'" << std::endl;
+                _push_owned_key();
             } else {
-                curKey.push_back(c);
+                owned.push_back(c);
             }
             break;
         }
 
         case State::sgKey: {
             if (c == '\r') {
-                keys.push_back(curKey);
-                // std::cout << "parser debug: total '" << keys.size() << " keys" << std::endl;
+                _push_owned_key();
+                state = State::sLF;
+            } else if (c == ' ') {
+                state = State::sgKey;
+                _push_owned_key();
+            } else {
+                owned.push_back(c);
+            }
+            break;
+        }
 
-                if (keys.size() == 0) {
-                    throw std::runtime_error("Client provides no key to retrive");
+        case State::spCas: {
+            if (c == '\r') {
+                state = State::sLF;
+            } else if (c >= '0' && c <= '9') {
+                uint64_t digit = c - '0';
+                if (cas > (UINT64_MAX - digit) / 10) {
+                    throw std::runtime_error("Cas unique field overflow");
                 }
+                cas = cas * 10 + digit;
+            }
+            break;
+        }
 
-                curKey.clear();
+        case State::stKey: {
+            if (c == ' ') {
+                negative = false;
+                state = State::spExprTimeStart;
+                _push_owned_key();
+            } else if (c == '\r') {
+                throw std::runtime_error("Client provides no expire time");
+            } else {
+                owned.push_back(c);
+            }
+            break;
+        }
+
+        case State::saKey: {
+            if (c == ' ') {
+                state = State::saDelta;
+                _push_owned_key();
+            } else if (c == '\r') {
+                throw std::runtime_error("Client provides no delta");
+            } else {
+                owned.push_back(c);
+            }
+            break;
+        }
+        case State::saDelta: {
+            if (c == '\r') {
+                if (!has_delta) {
+                    throw std::runtime_error("Client provides no delta");
+                }
                 state = State::sLF;
-            } else if (c == ' ') {
-                // std::cout << "parser debug: key[" << keys.size() << "]='" << curKey << "'" << std::endl;
-                state = State::sgKey;
-                keys.push_back(curKey);
-                curKey.clear();
+            } else if (c >= '0' && c <= '9') {
+                uint64_t digit = c - '0';
+                if (delta > (UINT64_MAX - digit) / 10) {
+                    throw std::runtime_error("Delta field overflow");
+                }
+                delta = delta * 10 + digit;
+                has_delta = true;
             } else {
-                curKey.push_back(c);
+                throw std::runtime_error("Invalid numeric delta");
             }
             break;
         }
@@ -105,31 +316,39 @@ bool Parser::Parse(const char *input, const size_t size, size_t &parsed) {
         }
 
         case State::spExprTime: {
-            if (c == ' ') {
+            if (c == ' ' && (command == cGat || command == cGats)) {
+                state = State::sgKey;
+            } else if (c == '\r' && (command == cTouch || command == cFlushAll)) {
+                state = State::sLF;
+            } else if (c == ' ') {
                 state = State::spBytes;
                 // std::cout << "parser debug: ExprTime='" << exprtime << "'" << std::endl;
             } else if (c >= '0' && c <= '9') {
-                int32_t et = exprtime;
+                int32_t digit = c - '0';
                 if (negative) {
-                    et -= (c - '0');
-                    if (et > exprtime) {
+                    if (exprtime < (INT32_MIN + digit) / 10) {
                         throw std::runtime_error("Expire time field overflow");
                     }
+                    exprtime = exprtime * 10 - digit;
                 } else {
-                    et += (c - '0');
-                    if (et < exprtime) {
+                    if (exprtime > (INT32_MAX - digit) / 10) {
                         throw std::runtime_error("Expire time field overflow");
                     }
+                    exprtime = exprtime * 10 + digit;
                 }
-                exprtime = et;
             }
             break;
         }
 
         case State::spBytes: {
             if (c == '\r') {
+                if (command == cCas) {
+                    throw std::runtime_error("Client provides no cas unique");
+                }
                 state = State::sLF;
                 // std::cout << "parser debug: bytes='" << bytes << "'" << std::endl;
+            } else if (c == ' ' && command == cCas) {
+                state = State::spCas;
             } else if (c >= '0' && c <= '9') {
                 uint32_t b = (bytes * 10) + (c - '0');
                 if (b < bytes) {
@@ -161,6 +380,226 @@ bool Parser::Parse(const char *input, const size_t size, size_t &parsed) {
     return parse_complete;
 }
 
+// See Parse.h
+bool Parser::_parse_line(const char *input, const size_t size, size_t &parsed) {
+    const char *end = find_byte(input, input + size, '\r');
+    if (size - (end - input) < 2 || end[1] != '\n') {
+        // Line is split across reads
+        return false;
+    }
+
+    base = input;
+    const char *pos = input;
+    const char *token;
+    size_t token_size;
+    if (!next_token(pos, end, token, token_size)) {
+        return false;
+    }
+    command = _command_of(token, token_size);
+
+    uint64_t number;
+    switch (command) {
+    case cSet:
+    case cAdd:
+    case cReplace:
+    case cAppend:
+    case cPrepend:
+    case cCas:
+        // <key> <flags> <exptime> <bytes> [<cas unique>]
+        if (!_next_key(pos, end) || !next_number(pos, end, UINT32_MAX, number)) {
+            return false;
+        }
+        flags = number;
+        if (!next_expire(pos, end, exprtime) || !next_number(pos, end, UINT32_MAX, number)) {
+            return false;
+        }
+        bytes = number;
+        if (command == cCas && !next_number(pos, end, UINT64_MAX, cas)) {
+            return false;
+        }
+        break;
+    case cGet:
+    case cGets:
+    case cFlushNs:
+        // <key>*
+        do {
+            if (!_next_key(pos, end)) {
+                return false;
+            }
+        } while (pos <= end);
+        break;
+    case cIncr:
+    case cDecr:
+        // <key> <value>
+        if (!_next_key(pos, end) || !next_number(pos, end, UINT64_MAX, delta)) {
+            return false;
+        }
+        has_delta = true;
+        break;
+    case cTouch:
+        // <key> <exptime>
+        if (!_next_key(pos, end) || !next_expire(pos, end, exprtime)) {
+            return false;
+        }
+        break;
+    case cGat:
+    case cGats:
+        // <exptime> <key>*
+        if (!next_expire(pos, end, exprtime)) {
+            return false;
+        }
+        do {
+            if (!_next_key(pos, end)) {
+                return false;
+            }
+        } while (pos <= end);
+        break;
+    case cFlushAll:
+        // [<delay>]
+        if (pos <= end && !next_expire(pos, end, exprtime)) {
+            return false;
+        }
+        break;
+    case cStats:
+        break;
+    default:
+        return false;
+    }
+
+    if (pos <= end) {
+        // Something is left in the line
+        return false;
+    }
+
+    state = State::sLF;
+    parse_complete = true;
+    parsed = end - input + 2;
+    return true;
+}
+
+// See Parse.h
+bool Parser::_next_key(const char *&pos, const char *end) {
+    const char *token;
+    size_t token_size;
+    if (!next_token(pos, end, token, token_size)) {
+        return false;
+    }
+    keys.push_back(KeySpan{size_t(token - base), token_size});
+    hashes.push_back(Hash(token, token_size));
+    return true;
+}
+
+// See Parse.h
+void Parser::_push_owned_key() {
+    size_t size = owned.size() - key_start;
+    keys.push_back(KeySpan{key_start, size});
+    hashes.push_back(Hash(owned.data() + key_start, size));
+    key_start = owned.size();
+}
+
+// See Parse.h
+void Parser::_own_keys() {
+    if (base == nullptr) {
+        return;
+    }
+    for (KeySpan &key : keys) {
+        size_t offset = owned.size();
+        owned.append(base + key.offset, key.size);
+        key.offset = offset;
+    }
+    key_start = owned.size();
+    base = nullptr;
+}
+
+// See Parse.h
+Parser::CommandId Parser::_command_of(const char *name, size_t size) {
+    // Length and a letter or two narrow it down to a single candidate
+    CommandId candidate = cUnknown;
+    switch (size) {
+    case 3:
+        switch (name[0]) {
+        case 's':
+            candidate = cSet;
+            break;
+        case 'a':
+            candidate = cAdd;
+            break;
+        case 'c':
+            candidate = cCas;
+            break;
+        case 'g':
+            candidate = name[1] == 'e' ? cGet : cGat;
+            break;
+        }
+        break;
+    case 4:
+        switch (name[0]) {
+        case 'i':
+            candidate = cIncr;
+            break;
+        case 'd':
+            candidate = cDecr;
+            break;
+        case 'g':
+            candidate = name[1] == 'e' ? cGets : cGats;
+            break;
+        }
+        break;
+    case 5:
+        candidate = name[0] == 't' ? cTouch : cStats;
+        break;
+    case 6:
+        candidate = cAppend;
+        break;
+    case 7:
+        candidate = name[0] == 'r' ? cReplace : cPrepend;
+        break;
+    case 8:
+        candidate = cFlushNs;
+        break;
+    case 9:
+        candidate = cFlushAll;
+        break;
+    }
+
+    const std::string &expected = command_names[candidate];
+    if (candidate != cUnknown && std::memcmp(expected.data(), name, size) == 0) {
+        return candidate;
+    }
+    return cUnknown;
+}
+
+// See Parse.h
+std::vector<std::string> Parser::_key_strings() const {
+    std::vector<std::string> result;
+    result.reserve(keys.size());
+    for (size_t i = 0; i < keys.size(); i++) {
+        result.emplace_back(Key(i).str());
+    }
+    return result;
+}
+
+// See Parse.h
+const std::string &Parser::Name() const { return command_names[parse_complete ? command : cUnknown]; }
+
+// Sink of Parser::_build which creates command on the heap
+struct HeapCommand {
+    template <typename T, typename... Args> void Make(Args &&... args) {
+        command.reset(new T(std::forward<Args>(args)...));
+    }
+
+    std::unique_ptr<Execute::Command> command;
+};
+
+// Sink of Parser::_build which creates command in place
+struct InPlaceCommand {
+    template <typename T, typename... Args> void Make(Args &&... args) {
+        command.Emplace<T>(std::forward<Args>(args)...);
+    }
+
+    Execute::AnyCommand &command;
+};
+
 // See Parse.h
 std::unique_ptr<Execute::Command> Parser::Build(size_t &body_size) const {
     if (state != State::sLF) {
@@ -168,17 +607,74 @@ std::unique_ptr<Execute::Command> Parser::Build(size_t &body_size) const {
     }
 
     body_size = bytes;
-    if (name == "set") {
-        return std::unique_ptr<Execute::Command>(new Execute::Set(keys[0], flags, exprtime));
-    } else if (name == "add") {
-        return std::unique_ptr<Execute::Command>(new Execute::Add(keys[0], flags, exprtime));
-    } else if (name == "append") {
-        return std::unique_ptr<Execute::Command>(new Execute::Append(keys[0], flags, exprtime));
-    } else if (name == "get") {
-        return std::unique_ptr<Execute::Command>(new Execute::Get(keys));
-    } else if (name == "stats") {
-        return std::unique_ptr<Execute::Command>(new Execute::Stats());
-    } else {
+    HeapCommand sink;
+    _build(sink);
+    return std::move(sink.command);
+}
+
+// See Parse.h
+bool Parser::Build(Execute::AnyCommand &command, size_t &body_size) const {
+    if (state != State::sLF) {
+        return false;
+    }
+
+    body_size = bytes;
+    InPlaceCommand sink{command};
+    _build(sink);
+    return true;
+}
+
+template <typename Sink> void Parser::_build(Sink &sink) const {
+    switch (command) {
+    case cSet:
+        sink.template Make<Execute::Set>(Key(0).str(), hashes[0], flags, exprtime);
+        break;
+    case cAdd:
+        sink.template Make<Execute::Add>(Key(0).str(), hashes[0], flags, exprtime);
+        break;
+    case cReplace:
+        sink.template Make<Execute::Replace>(Key(0).str(), hashes[0], flags, exprtime);
+        break;
+    case cAppend:
+        sink.template Make<Execute::Append>(Key(0).str(), hashes[0], flags, exprtime);
+        break;
+    case cPrepend:
+        sink.template Make<Execute::Prepend>(Key(0).str(), hashes[0], flags, exprtime);
+        break;
+    case cCas:
+        sink.template Make<Execute::Cas>(Key(0).str(), hashes[0], flags, exprtime, cas);
+        break;
+    case cIncr:
+        sink.template Make<Execute::Incr>(Key(0).str(), hashes[0], delta);
+        break;
+    case cDecr:
+        sink.template Make<Execute::Decr>(Key(0).str(), hashes[0], delta);
+        break;
+    case cGet:
+        sink.template Make<Execute::Get>(_key_strings(), hashes);
+        break;
+    case cGets:
+        sink.template Make<Execute::Gets>(_key_strings(), hashes);
+        break;
+    case cGat:
+        sink.template Make<Execute::Gat>(_key_strings(), hashes, exprtime);
+        break;
+    case cGats:
+        sink.template Make<Execute::Gats>(_key_strings(), hashes, exprtime);
+        break;
+    case cTouch:
+        sink.template Make<Execute::Touch>(Key(0).str(), hashes[0], exprtime);
+        break;
+    case cFlushAll:
+        sink.template Make<Execute::FlushAll>(exprtime);
+        break;
+    case cFlushNs:
+        sink.template Make<Execute::FlushNamespace>(_key_strings());
+        break;
+    case cStats:
+        sink.template Make<Execute::Stats>();
+        break;
+    default:
         throw std::runtime_error("Unsupported command");
     }
 }
@@ -186,13 +682,21 @@ std::unique_ptr<Execute::Command> Parser::Build(size_t &body_size) const {
 // See Parse.h
 void Parser::Reset() {
     state = State::sName;
-    name.clear();
+    command = cUnknown;
+    name_size = 0;
     keys.clear();
-    curKey.clear();
+    hashes.clear();
+    base = nullptr;
+    owned.clear();
+    key_start = 0;
     parse_complete = false;
     flags = 0;
     bytes = 0;
     exprtime = 0;
+    negative = false;
+    cas = 0;
+    delta = 0;
+    has_delta = false;
 }
 
 } // namespace Protocol
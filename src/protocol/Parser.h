@@ -10,6 +10,7 @@
 
 namespace Afina {
 namespace Execute {
+class AnyCommand;
 class Command;
 } // namespace Execute
 namespace Protocol {
@@ -17,6 +18,16 @@ namespace Protocol {
 /**
  * # Memcached protocol parser
  * Parser supports subset of memcached protocol
+ *
+ * Command line which is entirely in the input is parsed by the fast path: delimiters are searched by SIMD
+ * instructions 16 or 32 bytes at a time and fields are cut out of the input as a whole. Byte by byte state machine
+ * parses commands split across reads and anything the fast path doesn't recognize, so errors are reported the same
+ * way regardless of the path.
+ *
+ * Parser doesn't allocate memory on its own in the steady state: keys of the line parsed by the fast path are
+ * views right into the input and only keys of commands split across reads are copied into the buffer of the
+ * parser, whose capacity is kept from one command to another. Command name is turned into the id once it is
+ * parsed out, all the following decisions switch on the id.
  */
 class Parser {
 public:
@@ -29,7 +40,12 @@ public:
      * @param parsed output parameter tells how many bytes was consumed from the string
      * @return true if command has been parsed out
      */
-    bool Parse(const std::string &input, size_t &parsed) { return Parse(&input[0], input.size(), parsed); }
+    bool Parse(const std::string &input, size_t &parsed) {
+        // String could be temporary, so keys can't point into it
+        bool result = Parse(&input[0], input.size(), parsed);
+        _own_keys();
+        return result;
+    }
 
     /**
      * Push given string into parser input. Method returns true if it was a command parsed out
@@ -44,32 +60,143 @@ public:
 
     /**
      * Builds new command from parsed input. In case if it wasn't enough input to prse command out
-     * method return nullptr
+     * method return nullptr. Keys could point into the input of the last Parse call, so command must be built
+     * before that input is changed
      */
     std::unique_ptr<Execute::Command> Build(size_t &body_size) const;
 
+    /**
+     * Same as above, but command is constructed in place of the given one, so nothing is allocated for the
+     * command itself. Method returns false if there is no command parsed out
+     */
+    bool Build(Execute::AnyCommand &command, size_t &body_size) const;
+
     /**
      * Reset parse so that it could be used to parse out new command
      */
     void Reset();
 
-    inline const std::string &Name() const { return name; }
+    /**
+     * Non-owning view of the bytes parsed out
+     */
+    struct View {
+        const char *data;
+        size_t size;
+
+        inline std::string str() const { return std::string(data, size); }
+    };
+
+    /**
+     * Name of the command parsed out, empty if command isn't complete yet
+     */
+    const std::string &Name() const;
+
+    /**
+     * Keys of the command parsed out, valid under the same conditions as Build is
+     */
+    inline size_t KeysCount() const { return keys.size(); }
+    inline View Key(size_t i) const { return View{_keys_base() + keys[i].offset, keys[i].size}; }
 
 private:
+    // Commands known to the parser
+    enum CommandId : uint8_t {
+        cUnknown,
+        cSet,
+        cAdd,
+        cReplace,
+        cAppend,
+        cPrepend,
+        cCas,
+        cGet,
+        cGets,
+        cIncr,
+        cDecr,
+        cTouch,
+        cGat,
+        cGats,
+        cFlushAll,
+        cFlushNs,
+        cStats
+    };
+
+    // Key bytes at offset from the base, see below
+    struct KeySpan {
+        size_t offset;
+        size_t size;
+    };
+
+    static CommandId _command_of(const char *name, size_t size);
+
+    inline const char *_keys_base() const { return base != nullptr ? base : owned.data(); }
+
+    // Key being parsed byte by byte is over, it is at key_start of the owned buffer
+    void _push_owned_key();
+
+    // Copies keys pointing into the input into the owned buffer
+    void _own_keys();
+
+    // All keys as strings for the command to keep
+    std::vector<std::string> _key_strings() const;
+
+    // Creates parsed command by sink.Make<T>(args...), see Build
+    template <typename Sink> void _build(Sink &sink) const;
+
+    /**
+     * Fast path: parses out the whole command line if it is in the input and well formed. Returns false
+     * otherwise, parser must be Reset then as some fields could be filled already
+     */
+    bool _parse_line(const char *input, const size_t size, size_t &parsed);
+
+    // Cuts the next token out of the line as a key, returns false if there is no non-empty token
+    bool _next_key(const char *&pos, const char *end);
+
     /**
      * State of the command parser. Prefixes are:
      * - s: state for PUT and GET commands
      * - sp: for PUT commands only
-     * - sg: for GET commands only
+     * - sg: for GET commands only, FLUSH_NS parses namespaces like keys
+     * - sa: for INCR and DECR commands only
+     * - st: for TOUCH command only, GAT and GATS parse expire time like PUT and keys like GET, FLUSH_ALL parses
+     *   its delay like expire time
      */
-    enum State : uint16_t { sCR, sLF, sName, spKey, spFlags, spExprTimeStart, spExprTime, spBytes, sgKey };
+    enum State : uint16_t {
+        sCR,
+        sLF,
+        sName,
+        spKey,
+        spFlags,
+        spExprTimeStart,
+        spExprTime,
+        spBytes,
+        spCas,
+        sgKey,
+        saKey,
+        saDelta,
+        stKey
+    };
 
     // Current parser state
     State state;
 
+    // Command which is parsed, known once its name is over
+    CommandId command;
+
+    // Name of the command parsed byte by byte, none of known names is longer
+    char name[16];
+    size_t name_size;
+
     // vrious fields of the command
-    std::string name;
-    std::vector<std::string> keys;
+    std::vector<KeySpan> keys;
+    // Afina::Hash of every key, computed once the key is parsed out
+    std::vector<size_t> hashes;
+
+    // Input line which keys point into, nullptr if command has been split across reads and keys are copied into
+    // the owned buffer
+    const char *base;
+    std::string owned;
+
+    // Offset of the key being parsed byte by byte in the owned buffer
+    size_t key_start;
 
     // <flags> is an arbitrary 16-bit unsigned integer (written out in decimal) that the server stores along with
     // the data and sends back when the item is retrieved. Clients may use this as a bit field to store data-specific
@@ -88,8 +215,14 @@ private:
     // it's followed by an empty data block).
     uint32_t bytes;
 
+    // <cas unique> of cas is the version of the value client has got from gets
+    uint64_t cas;
+
+    // <value> of incr/decr is the decimal representation of a 64-bit unsigned integer to add or substract
+    uint64_t delta;
+    bool has_delta;
+
     bool negative;
-    std::string curKey;
     bool parse_complete;
 };
 
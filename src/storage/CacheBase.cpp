@@ -0,0 +1,484 @@
+#include "CacheBase.h"
+
+#include <algorithm>
+#include <cassert>
+
+namespace Afina {
+namespace Backend {
+
+constexpr size_t CacheBase::kWriteSweep;
+constexpr size_t CacheBase::kSweepSlice;
+constexpr size_t CacheBase::kBatch;
+constexpr size_t CacheBase::kExternalSize;
+
+// Pages should be large enough to amortize system allocations, but small caches must not reserve
+// megabytes of memory
+static size_t page_size_for(size_t max_size) {
+    size_t page_size = 64 * 1024;
+    while (page_size < max_size / 4 && page_size < 1024 * 1024) {
+        page_size *= 2;
+    }
+    return page_size;
+}
+
+CacheBase::CacheBase(size_t max_size)
+    : _max_size(max_size), _cur_size(0), _versions(0), _allocator(page_size_for(max_size)) {}
+
+CacheBase::~CacheBase() {
+    // Chunks go away with the allocator, but external values are owned by entries
+    _index.ForEach([](Entry *node) {
+        if (node->external) {
+            Value::Adopt(node->buffer());
+        }
+    });
+}
+
+// See MapBasedGlobalLockImpl.h
+bool CacheBase::Delete(const std::string &key, size_t hash) {
+    _expire(kWriteSweep);
+    Entry *node = _find(key, hash);
+
+    if (node != nullptr) {
+        _delete_node(*node);
+        return true;
+    }
+    return false;
+}
+
+// See MapBasedGlobalLockImpl.h
+bool CacheBase::Get(const std::string &key, size_t hash, std::string &value) {
+    Entry *node = _get(key, hash);
+    if (node != nullptr) {
+        node->copy_value(value);
+        return true;
+    }
+    return false;
+}
+
+// See MapBasedGlobalLockImpl.h
+bool CacheBase::Get(const std::string &key, size_t hash, Value &value) {
+    Entry *node = _get(key, hash);
+    if (node != nullptr) {
+        value = _share(*node);
+        return true;
+    }
+    return false;
+}
+
+// See MapBasedGlobalLockImpl.h
+size_t CacheBase::MultiGet(const std::vector<std::string> &keys, const std::vector<size_t> &hashes,
+                           std::vector<Value> &values) {
+    std::vector<size_t> at(keys.size());
+    for (size_t i = 0; i < at.size(); i++) {
+        at[i] = i;
+    }
+    values.assign(keys.size(), Value());
+    return GetMany(keys, hashes, at.data(), at.size(), values, nullptr);
+}
+
+// See MapBasedGlobalLockImpl.h
+size_t CacheBase::MultiGets(const std::vector<std::string> &keys, const std::vector<size_t> &hashes,
+                            std::vector<Value> &values, std::vector<uint64_t> &versions) {
+    std::vector<size_t> at(keys.size());
+    for (size_t i = 0; i < at.size(); i++) {
+        at[i] = i;
+    }
+    values.assign(keys.size(), Value());
+    versions.assign(keys.size(), 0);
+    return GetMany(keys, hashes, at.data(), at.size(), values, &versions);
+}
+
+// See CacheBase.h
+size_t CacheBase::GetMany(const std::vector<std::string> &keys, const std::vector<size_t> &hashes, const size_t *at,
+                          size_t n, std::vector<Value> &values, std::vector<uint64_t> *versions) {
+    size_t found = 0;
+    for (size_t begin = 0; begin < n; begin += kBatch) {
+        size_t end = std::min(n, begin + kBatch);
+        _prefetch(hashes, at + begin, end - begin);
+        for (size_t i = begin; i < end; i++) {
+            Entry *node = _get(keys[at[i]], hashes[at[i]]);
+            if (node != nullptr) {
+                if (versions != nullptr) {
+                    (*versions)[at[i]] = node->version.load(std::memory_order_acquire);
+                }
+                values[at[i]] = _share(*node);
+                found++;
+            }
+        }
+    }
+    return found;
+}
+
+// See MapBasedGlobalLockImpl.h
+bool CacheBase::GetAndTouch(const std::string &key, size_t hash, uint32_t expire_at, Value &value,
+                            uint64_t &version) {
+    Entry *node = _touch(key, hash, expire_at);
+    if (node == nullptr) {
+        _misses.Add();
+        return false;
+    }
+    version = node->version.load(std::memory_order_relaxed);
+    value = _share(*node);
+    _hits.Add();
+    return true;
+}
+
+// See MapBasedGlobalLockImpl.h
+void CacheBase::GetStats(StorageStats &stats) {
+    stats.get_hits = _hits.Load();
+    stats.get_misses = _misses.Load();
+    stats.evictions = _evictions.Load();
+    stats.curr_items = _index.Size();
+    stats.bytes = _cur_size;
+    stats.limit_maxbytes = _max_size;
+}
+
+// See CacheBase.h
+void CacheBase::_on_replace(Entry &old, Entry &fresh) {
+    fresh.prev = old.prev;
+    fresh.next = old.next;
+    fresh.prev->next = &fresh;
+    fresh.next->prev = &fresh;
+}
+
+// See CacheBase.h
+void CacheBase::_prefetch(const std::vector<size_t> &hashes, const size_t *at, size_t n) const {
+    for (size_t i = 0; i < n; i++) {
+        _index.Prefetch(hashes[at[i]]);
+    }
+    for (size_t i = 0; i < n; i++) {
+        _index.PrefetchNodes(hashes[at[i]]);
+    }
+}
+
+// See CacheBase.h
+size_t CacheBase::_expire(size_t limit) {
+    if (_timers.Size() == 0) {
+        return 0;
+    }
+
+    uint32_t now = TimingWheel::Now();
+    size_t removed = 0;
+    for (; removed < limit; removed++) {
+        Entry *node = _timers.Expired(now);
+        if (node == nullptr) {
+            break;
+        }
+        _delete_node(*node);
+    }
+    return removed;
+}
+
+bool CacheBase::_put(const std::string &key, size_t hash, const Input &value, uint32_t expire_at) {
+    size_t node_size = key.size() + value.size;
+
+    if (node_size <= _max_size) {
+        _expire(kWriteSweep);
+        Entry *node = _index.Find(key, hash);
+        if (node != nullptr) {
+            _set_node(*node, value, expire_at);
+        } else {
+            _add_node(key, hash, value, expire_at);
+        }
+        return true;
+    }
+    return false;
+}
+
+bool CacheBase::_put_if_absent(const std::string &key, size_t hash, const Input &value, uint32_t expire_at) {
+    size_t node_size = key.size() + value.size;
+
+    if (node_size <= _max_size) {
+        _expire(kWriteSweep);
+        if (_find(key, hash) == nullptr) {
+            _add_node(key, hash, value, expire_at);
+            return true;
+        }
+    }
+    return false;
+}
+
+bool CacheBase::_set(const std::string &key, size_t hash, const Input &value, uint32_t expire_at) {
+    size_t node_size = key.size() + value.size;
+
+    if (node_size <= _max_size) {
+        _expire(kWriteSweep);
+        Entry *node = _find(key, hash);
+        if (node != nullptr) {
+            _set_node(*node, value, expire_at);
+            return true;
+        }
+    }
+    return false;
+}
+
+CasStatus CacheBase::_compare_and_set(const std::string &key, size_t hash, const Input &value, uint64_t version,
+                                      uint32_t expire_at) {
+    if (key.size() + value.size > _max_size) {
+        return CasStatus::NotStored;
+    }
+
+    _expire(kWriteSweep);
+    Entry *node = _find(key, hash);
+    if (node == nullptr) {
+        return CasStatus::NotFound;
+    }
+    if (node->version.load(std::memory_order_relaxed) != version) {
+        return CasStatus::Exists;
+    }
+    _set_node(*node, value, expire_at);
+    return CasStatus::Stored;
+}
+
+Entry *CacheBase::_touch(const std::string &key, size_t hash, uint32_t expire_at) {
+    _expire(kWriteSweep);
+    Entry *node = _find(key, hash);
+    if (node == nullptr) {
+        return nullptr;
+    }
+
+    _on_access(*node);
+    if (node->expire_at != expire_at) {
+        _timers.Cancel(*node);
+        node->expire_at = expire_at;
+        if (expire_at != 0) {
+            _timers.Schedule(*node);
+        }
+    }
+    return node;
+}
+
+bool CacheBase::_concat(const std::string &key, size_t hash, const std::string &data, bool prepend) {
+    _expire(kWriteSweep);
+    Entry *node = _find(key, hash);
+    if (node != nullptr && node->numeric) {
+        // Counter turns back into the text
+        std::string text;
+        node->copy_value(text);
+        node = _set_node(*node, Input{text.data(), text.size(), nullptr}, node->expire_at);
+    }
+    if (node == nullptr || node->key_size + node->value_size + data.size() > _max_size) {
+        return false;
+    }
+
+    size_t old_size = node->key_size + node->value_size;
+    _on_access(*node);
+    if (data.size() > _max_size - _cur_size) {
+        _free_mem(data.size(), node);
+    }
+
+    if (node->external || old_size + data.size() > node->capacity) {
+        // Value moves into the chunk with headroom, so that following concatenations are done in place and
+        // cost is proportional to the data added
+        size_t value_size = node->value_size + data.size();
+        size_t capacity;
+        void *chunk = _allocator.Allocate(sizeof(Entry) + node->key_size + value_size + value_size / 2, capacity);
+        Entry *fresh = Entry::Emplace(chunk, capacity, node->key(), node->key_size, node->hash, node->value(),
+                                      node->value_size, node->expire_at);
+        fresh->generation = node->generation;
+        if (fresh->expire_at != 0) {
+            _timers.Schedule(*fresh);
+        }
+        _replace_node(*node, *fresh);
+        node = fresh;
+    }
+
+    if (prepend) {
+        node->prepend(data.data(), data.size());
+    } else {
+        node->append(data.data(), data.size());
+    }
+    _stamp(*node);
+    _on_resize(*node, old_size);
+    _cur_size += data.size();
+    return true;
+}
+
+CounterStatus CacheBase::_count(const std::string &key, size_t hash, uint64_t delta, bool decrement,
+                                uint64_t &value) {
+    _expire(kWriteSweep);
+    Entry *node = _find(key, hash);
+    if (node == nullptr) {
+        return CounterStatus::NotFound;
+    }
+
+    if (!node->numeric) {
+        // Text is parsed just once, from now on value is kept as native number
+        uint64_t current;
+        if (!Entry::parse_counter(node->value(), node->value_size, current) ||
+            node->key_size + Entry::kCounterSize > _max_size) {
+            return CounterStatus::NotNumeric;
+        }
+        node = _make_counter(*node, current);
+    }
+
+    _on_access(*node);
+    value = node->count(delta, decrement);
+    _stamp(*node);
+    return CounterStatus::Done;
+}
+
+Entry *CacheBase::_make_counter(Entry &node, uint64_t value) {
+    size_t old_size = node.key_size + node.value_size;
+    _cur_size -= node.value_size;
+    if (Entry::kCounterSize > _max_size - _cur_size) {
+        _free_mem(Entry::kCounterSize, &node);
+    }
+
+    Entry *result = &node;
+    if (!node.external && node.counter_offset() + Entry::kCounterSize <= node.capacity) {
+        node.make_counter(value);
+    } else {
+        size_t capacity;
+        void *chunk = _allocator.Allocate(sizeof(Entry) + node.counter_offset() + Entry::kCounterSize, capacity);
+        Entry *fresh = Entry::Emplace(chunk, capacity, node.key(), node.key_size, node.hash, "", 0, node.expire_at);
+        fresh->make_counter(value);
+        fresh->generation = node.generation;
+        if (fresh->expire_at != 0) {
+            _timers.Schedule(*fresh);
+        }
+        _replace_node(node, *fresh);
+        result = fresh;
+    }
+    _on_resize(*result, old_size);
+    _cur_size += Entry::kCounterSize;
+    return result;
+}
+
+Entry *CacheBase::_find(const std::string &key, size_t hash) {
+    Entry *node = _index.Find(key, hash);
+    if (node != nullptr && _dead(*node, TimingWheel::Now())) {
+        _delete_node(*node);
+        return nullptr;
+    }
+    return node;
+}
+
+Entry *CacheBase::_get(const std::string &key, size_t hash) {
+    Entry *node = _find(key, hash);
+    if (node != nullptr) {
+        _on_access(*node);
+        _hits.Add();
+    } else {
+        _misses.Add();
+    }
+    return node;
+}
+
+Entry *CacheBase::_set_node(Entry &node, const Input &value, uint32_t expire_at) {
+    size_t size_diff = value.size;
+    size_t old_size = node.key_size + node.value_size;
+
+    _on_access(node);
+    _cur_size -= node.value_size;
+
+    if (size_diff > _max_size - _cur_size) {
+        _free_mem(size_diff, &node);
+    }
+
+    Entry *result = &node;
+    bool external = value.buffer != nullptr && value.size >= kExternalSize;
+    if (!node.external && !external && node.key_size + value.size <= node.capacity) {
+        // Fits into the existing chunk, no allocation required
+        std::memcpy(node.inline_value(), value.data, value.size);
+        node.value_size = value.size;
+        node.numeric = 0;
+        node.generation = _generations.Of(node.key(), node.key_size, TimingWheel::Now());
+        if (node.expire_at != expire_at) {
+            _timers.Cancel(node);
+            node.expire_at = expire_at;
+            if (expire_at != 0) {
+                _timers.Schedule(node);
+            }
+        }
+    } else {
+        Entry *fresh = _new_entry(node.key(), node.key_size, node.hash, value, expire_at);
+        _replace_node(node, *fresh);
+        result = fresh;
+    }
+    _stamp(*result);
+    _on_resize(*result, old_size);
+    _cur_size += size_diff;
+    return result;
+}
+
+void CacheBase::_add_node(const std::string &key, size_t hash, const Input &value, uint32_t expire_at) {
+    size_t node_size = key.size() + value.size;
+
+    if (node_size > _max_size - _cur_size) {
+        _free_mem(node_size);
+    }
+
+    Entry *node = _new_entry(key.data(), key.size(), hash, value, expire_at);
+    _stamp(*node);
+    _index.Insert(node, hash);
+    _on_insert(*node);
+    _cur_size += node_size;
+}
+
+void CacheBase::_delete_node(Entry &node) {
+    _cur_size -= node.key_size + node.value_size;
+    _index.Erase(&node, node.hash);
+    _on_remove(node);
+    _timers.Cancel(node);
+    _free_entry(node);
+}
+
+void CacheBase::_replace_node(Entry &node, Entry &fresh) {
+    _index.Replace(&node, node.hash, &fresh);
+    _on_replace(node, fresh);
+    _timers.Cancel(node);
+    _free_entry(node);
+}
+
+void CacheBase::_free_entry(Entry &node) {
+    if (node.external) {
+        // Handle goes away right here and takes the entry reference with it
+        Value::Adopt(node.buffer());
+    }
+    _allocator.Free(&node);
+}
+
+void CacheBase::_free_mem(size_t size, Entry *keep) {
+    bool detached = false;
+    while (size > _max_size - _cur_size) {
+        Entry *node = _victim();
+        assert(node != nullptr);
+        if (node == keep) {
+            // Take it out of the policy, so it couldn't be chosen again. There is at least one more entry,
+            // otherwise there would be enough space already
+            _on_remove(*keep);
+            detached = true;
+            continue;
+        }
+        _on_evict(*node);
+        _delete_node(*node);
+        _evictions.Add();
+    }
+
+    if (detached) {
+        _on_insert(*keep);
+    }
+}
+
+Entry *CacheBase::_new_entry(const char *key, size_t key_size, size_t hash, const Input &value, uint32_t expire_at) {
+    size_t capacity;
+    Entry *node;
+    if (value.buffer != nullptr && value.size >= kExternalSize) {
+        // Large value given away by the caller is kept as is
+        void *chunk = _allocator.Allocate(sizeof(Entry) + key_size + sizeof(void *), capacity);
+        node = Entry::EmplaceExternal(chunk, capacity, key, key_size, hash, value.buffer->Release(), value.size,
+                                      expire_at);
+    } else {
+        void *chunk = _allocator.Allocate(sizeof(Entry) + key_size + value.size, capacity);
+        node = Entry::Emplace(chunk, capacity, key, key_size, hash, value.data, value.size, expire_at);
+    }
+    node->generation = _generations.Of(key, key_size, TimingWheel::Now());
+    if (expire_at != 0) {
+        _timers.Schedule(*node);
+    }
+    return node;
+}
+
+} // namespace Backend
+} // namespace Afina
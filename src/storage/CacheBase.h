@@ -0,0 +1,326 @@
+#ifndef AFINA_STORAGE_CACHE_BASE_H
+#define AFINA_STORAGE_CACHE_BASE_H
+
+#include <atomic>
+#include <string>
+#include <vector>
+
+#include <afina/Hash.h>
+#include <afina/Storage.h>
+#include <afina/Value.h>
+
+#include "Entry.h"
+#include "Generations.h"
+#include "SlabAllocator.h"
+#include "StatCounter.h"
+#include "SwissTable.h"
+#include "TimingWheel.h"
+
+namespace Afina {
+namespace Backend {
+
+/**
+ * # Base of the bounded caches
+ * Keeps entries in the slab memory, indexes them by key and tracks that total size of keys and values stays
+ * below _max_size. What to evict once cache is full is up to eviction policy implemented by subclass in hooks
+ * below.
+ *
+ * Expired entries are never returned, they are removed once found by lookup and actively by the timing wheel
+ * sweep: every write reclaims a small slice of expired entries, thread safe subclasses also call _expire
+ * periodically from the background. Flushed entries are treated as expired, but only lookup and eviction
+ * reclaim them, see Generations.h
+ *
+ * That is NOT thread safe implementaiton!!
+ */
+class CacheBase : public Afina::Storage {
+public:
+    CacheBase(size_t max_size);
+    ~CacheBase();
+
+    // Implements Afina::Storage interface
+    bool Put(const std::string &key, const std::string &value, uint32_t expire_at = 0) override {
+        return Put(key, _hash(key), value, expire_at);
+    }
+
+    // Implements Afina::Storage interface
+    bool PutIfAbsent(const std::string &key, const std::string &value, uint32_t expire_at = 0) override {
+        return PutIfAbsent(key, _hash(key), value, expire_at);
+    }
+
+    // Implements Afina::Storage interface
+    bool Set(const std::string &key, const std::string &value, uint32_t expire_at = 0) override {
+        return Set(key, _hash(key), value, expire_at);
+    }
+
+    // Implements Afina::Storage interface
+    bool Delete(const std::string &key) override { return Delete(key, _hash(key)); }
+
+    // Implements Afina::Storage interface
+    bool Get(const std::string &key, std::string &value) override { return Get(key, _hash(key), value); }
+
+    // Implements Afina::Storage interface
+    bool Put(const std::string &key, size_t hash, const std::string &value, uint32_t expire_at = 0) override {
+        return _put(key, hash, Input{value.data(), value.size(), nullptr}, expire_at);
+    }
+
+    // Implements Afina::Storage interface
+    bool PutIfAbsent(const std::string &key, size_t hash, const std::string &value, uint32_t expire_at = 0) override {
+        return _put_if_absent(key, hash, Input{value.data(), value.size(), nullptr}, expire_at);
+    }
+
+    // Implements Afina::Storage interface
+    bool Set(const std::string &key, size_t hash, const std::string &value, uint32_t expire_at = 0) override {
+        return _set(key, hash, Input{value.data(), value.size(), nullptr}, expire_at);
+    }
+
+    // Implements Afina::Storage interface
+    bool Delete(const std::string &key, size_t hash) override;
+
+    // Implements Afina::Storage interface
+    bool Get(const std::string &key, size_t hash, std::string &value) override;
+
+    // Implements Afina::Storage interface
+    bool Put(const std::string &key, size_t hash, Value value, uint32_t expire_at = 0) override {
+        return _put(key, hash, Input{value.data(), value.size(), &value}, expire_at);
+    }
+
+    // Implements Afina::Storage interface
+    bool PutIfAbsent(const std::string &key, size_t hash, Value value, uint32_t expire_at = 0) override {
+        return _put_if_absent(key, hash, Input{value.data(), value.size(), &value}, expire_at);
+    }
+
+    // Implements Afina::Storage interface
+    bool Set(const std::string &key, size_t hash, Value value, uint32_t expire_at = 0) override {
+        return _set(key, hash, Input{value.data(), value.size(), &value}, expire_at);
+    }
+
+    // Implements Afina::Storage interface
+    bool Get(const std::string &key, size_t hash, Value &value) override;
+
+    // Implements Afina::Storage interface
+    bool Append(const std::string &key, size_t hash, const std::string &data) override {
+        return _concat(key, hash, data, false);
+    }
+
+    // Implements Afina::Storage interface
+    bool Prepend(const std::string &key, size_t hash, const std::string &data) override {
+        return _concat(key, hash, data, true);
+    }
+
+    // Implements Afina::Storage interface
+    CounterStatus Increment(const std::string &key, size_t hash, uint64_t delta, uint64_t &value) override {
+        return _count(key, hash, delta, false, value);
+    }
+
+    // Implements Afina::Storage interface
+    CounterStatus Decrement(const std::string &key, size_t hash, uint64_t delta, uint64_t &value) override {
+        return _count(key, hash, delta, true, value);
+    }
+
+    // Implements Afina::Storage interface
+    size_t MultiGet(const std::vector<std::string> &keys, const std::vector<size_t> &hashes,
+                    std::vector<Value> &values) override;
+
+    // Implements Afina::Storage interface
+    size_t MultiGets(const std::vector<std::string> &keys, const std::vector<size_t> &hashes,
+                     std::vector<Value> &values, std::vector<uint64_t> &versions) override;
+
+    // Implements Afina::Storage interface
+    CasStatus CompareAndSet(const std::string &key, size_t hash, Value value, uint64_t version,
+                            uint32_t expire_at = 0) override {
+        return _compare_and_set(key, hash, Input{value.data(), value.size(), &value}, version, expire_at);
+    }
+
+    // Implements Afina::Storage interface
+    bool Touch(const std::string &key, size_t hash, uint32_t expire_at) override {
+        return _touch(key, hash, expire_at) != nullptr;
+    }
+
+    // Implements Afina::Storage interface
+    bool GetAndTouch(const std::string &key, size_t hash, uint32_t expire_at, Value &value,
+                     uint64_t &version) override;
+
+    // Implements Afina::Storage interface
+    void FlushAll(uint32_t at = 0) override { _generations.FlushAll(at, TimingWheel::Now()); }
+
+    // Implements Afina::Storage interface
+    void FlushNamespace(const std::string &ns) override { _generations.FlushNamespace(ns); }
+
+    // Implements Afina::Storage interface
+    void GetStats(StorageStats &stats) override;
+
+    /**
+     * Retrives values of keys[at[i]] into values[at[i]] for every i < n, values must be sized already. So the
+     * batch could be split between several caches, thread safe subclasses take their lock once for the whole
+     * subset. Versions of values go to versions[at[i]] unless versions is nullptr. Returns number of keys found
+     */
+    virtual size_t GetMany(const std::vector<std::string> &keys, const std::vector<size_t> &hashes, const size_t *at,
+                           size_t n, std::vector<Value> &values, std::vector<uint64_t> *versions);
+
+    /**
+     * Removes at most limit expired entries, returns true if there could be more of them. Thread safe
+     * subclasses take their lock here, so it could be called by the background sweep
+     */
+    virtual bool Sweep(size_t limit = kSweepSlice) { return _expire(limit) == limit; }
+
+protected:
+    /**
+     * New entry has been added into the cache
+     */
+    virtual void _on_insert(Entry &node) = 0;
+
+    /**
+     * Existing entry has been read or updated
+     */
+    virtual void _on_access(Entry &node) = 0;
+
+    /**
+     * Entry is going to be removed from the cache
+     */
+    virtual void _on_remove(Entry &node) = 0;
+
+    /**
+     * Entry is going to be moved into a new chunk, so fresh one must take the place of the old one. By default
+     * fresh entry takes old's position in the intrusive list
+     */
+    virtual void _on_replace(Entry &old, Entry &fresh);
+
+    /**
+     * Entry value has been changed, so entry has changed its size from old_size bytes of key and value
+     */
+    virtual void _on_resize(Entry &node, size_t old_size) {}
+
+    /**
+     * Entry given by _victim is going to be evicted, _on_remove follows. Not called for the entry which is
+     * being changed itself, such entry stays in the cache
+     */
+    virtual void _on_evict(Entry &node) {}
+
+    /**
+     * Returns entry that should be evicted next, there is at least one entry in the cache
+     */
+    virtual Entry *_victim() = 0;
+
+    // Searches entry without any side effects, so it is safe to call concurrently as long as
+    // nobody modifies cache
+    inline Entry *_lookup(const std::string &key, size_t hash) const { return _index.Find(key, hash); }
+
+    static inline size_t _hash(const std::string &key) { return Hash(key); }
+
+    // Handle of the entry value, external value is shared, inline one is copied
+    static inline Value _share(const Entry &node) {
+        if (node.numeric) {
+            return Value(std::to_string(node.counter().load(std::memory_order_relaxed)));
+        }
+        return node.external ? Value::Share(node.buffer()) : Value(node.value(), node.value_size);
+    }
+
+    // Gives entry the next version once its value has changed. Value must be changed before, so that reader who
+    // loads version and then value never gets new version with the old value
+    inline void _stamp(Entry &node) {
+        node.version.store(_versions.fetch_add(1, std::memory_order_relaxed) + 1, std::memory_order_release);
+    }
+
+    // Entry is either expired or flushed, so it must be treated as absent. Flushes are atomic, so it is safe to
+    // call concurrently with them
+    inline bool _dead(const Entry &node, uint32_t now) { return node.expired(now) || _generations.Stale(node, now); }
+
+    // Prefetches index groups and then matching entries of keys[at[i]] for i < n, so that lookups of the batch
+    // don't wait for memory one by one
+    void _prefetch(const std::vector<size_t> &hashes, const size_t *at, size_t n) const;
+
+    // Removes at most limit expired entries, returns number of removed ones
+    size_t _expire(size_t limit);
+
+    // Number of expired entries each write reclaims along the way
+    static constexpr size_t kWriteSweep = 4;
+
+    // Number of keys of the batched lookup prefetched at once
+    static constexpr size_t kBatch = 16;
+
+    // Number of expired entries background sweep removes under one lock acquisition
+    static constexpr size_t kSweepSlice = 64;
+
+    // Values given by buffer of at least this size are kept external instead of being copied
+    static constexpr size_t kExternalSize = 4096;
+
+    // Maximum number of bytes could be stored in this cache.
+    // i.e all (keys+values) must be less the _max_size
+    std::size_t _max_size;
+    std::size_t _cur_size;
+
+    StatCounter _hits;
+    StatCounter _misses;
+    StatCounter _evictions;
+
+    // Last version given to an entry
+    std::atomic<uint64_t> _versions;
+
+    // Generations of keys for flushes
+    Generations _generations;
+
+private:
+    // Value to be stored: bytes to copy and the buffer which could be kept instead, if caller gives it away
+    struct Input {
+        const char *data;
+        size_t size;
+        Value *buffer;
+    };
+
+    bool _put(const std::string &key, size_t hash, const Input &value, uint32_t expire_at);
+    bool _put_if_absent(const std::string &key, size_t hash, const Input &value, uint32_t expire_at);
+    bool _set(const std::string &key, size_t hash, const Input &value, uint32_t expire_at);
+
+    CasStatus _compare_and_set(const std::string &key, size_t hash, const Input &value, uint64_t version,
+                               uint32_t expire_at);
+
+    // Sets expiration time of the existing key, returns its entry
+    Entry *_touch(const std::string &key, size_t hash, uint32_t expire_at);
+
+    // Adds data after or before the value of the existing key
+    bool _concat(const std::string &key, size_t hash, const std::string &data, bool prepend);
+
+    // Adds delta to the counter of the existing key or substracts it
+    CounterStatus _count(const std::string &key, size_t hash, uint64_t delta, bool decrement, uint64_t &value);
+
+    // Turns value of the node into the counter with the given value, returns entry which holds it now
+    Entry *_make_counter(Entry &node, uint64_t value);
+
+    // Changes value of the node, returns entry which holds it now
+    Entry *_set_node(Entry &node, const Input &value, uint32_t expire_at);
+    void _add_node(const std::string &key, size_t hash, const Input &value, uint32_t expire_at);
+
+    // Searches live entry, expired one is removed on the way
+    Entry *_find(const std::string &key, size_t hash);
+
+    // Searches live entry for the reader, counts hit or miss
+    Entry *_get(const std::string &key, size_t hash);
+    void _delete_node(Entry &node);
+
+    // Puts fresh entry in place of the node in the index and the policy, node is freed
+    void _replace_node(Entry &node, Entry &fresh);
+
+    // Returns entry chunk into allocator, external value buffer is released
+    void _free_entry(Entry &node);
+
+    // Evicts entries until there is enough space to store size more bytes, keep is never evicted
+    void _free_mem(size_t size, Entry *keep = nullptr);
+
+    // Allocates new entry and fills it with given data, entry is not linked anywhere
+    Entry *_new_entry(const char *key, size_t key_size, size_t hash, const Input &value, uint32_t expire_at);
+
+    // Memory pool for entries, each entry holds key and value in a single chunk, so allocator
+    // owns all the nodes
+    SlabAllocator _allocator;
+
+    // Index of entries, allows fast random access to elements by key
+    SwissTable<Entry, EntryTraits> _index;
+
+    // Expiration schedule of entries with TTL
+    TimingWheel _timers;
+};
+
+} // namespace Backend
+} // namespace Afina
+
+#endif // AFINA_STORAGE_CACHE_BASE_H
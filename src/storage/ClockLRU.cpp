@@ -0,0 +1,237 @@
+#include "ClockLRU.h"
+
+#include <algorithm>
+#include <mutex>
+
+namespace Afina {
+namespace Backend {
+
+// See MapBasedGlobalLockImpl.h
+bool ClockLRU::Put(const std::string &key, size_t hash, const std::string &value, uint32_t expire_at) {
+    std::lock_guard<Concurrency::SharedMutex> lock(_mutex);
+    return CacheBase::Put(key, hash, value, expire_at);
+}
+
+// See MapBasedGlobalLockImpl.h
+bool ClockLRU::PutIfAbsent(const std::string &key, size_t hash, const std::string &value, uint32_t expire_at) {
+    std::lock_guard<Concurrency::SharedMutex> lock(_mutex);
+    return CacheBase::PutIfAbsent(key, hash, value, expire_at);
+}
+
+// See MapBasedGlobalLockImpl.h
+bool ClockLRU::Set(const std::string &key, size_t hash, const std::string &value, uint32_t expire_at) {
+    std::lock_guard<Concurrency::SharedMutex> lock(_mutex);
+    return CacheBase::Set(key, hash, value, expire_at);
+}
+
+// See MapBasedGlobalLockImpl.h
+bool ClockLRU::Delete(const std::string &key, size_t hash) {
+    std::lock_guard<Concurrency::SharedMutex> lock(_mutex);
+    return CacheBase::Delete(key, hash);
+}
+
+// See MapBasedGlobalLockImpl.h
+bool ClockLRU::Get(const std::string &key, size_t hash, std::string &value) {
+    Concurrency::SharedLock lock(_mutex);
+    Entry *node = _lookup(key, hash);
+    if (node == nullptr || _dead(*node, TimingWheel::Now())) {
+        _misses.Add();
+        return false;
+    }
+
+    node->copy_value(value);
+    _on_access(*node);
+    _hits.Add();
+    return true;
+}
+
+// See MapBasedGlobalLockImpl.h
+bool ClockLRU::Put(const std::string &key, size_t hash, Value value, uint32_t expire_at) {
+    std::lock_guard<Concurrency::SharedMutex> lock(_mutex);
+    return CacheBase::Put(key, hash, std::move(value), expire_at);
+}
+
+// See MapBasedGlobalLockImpl.h
+bool ClockLRU::PutIfAbsent(const std::string &key, size_t hash, Value value, uint32_t expire_at) {
+    std::lock_guard<Concurrency::SharedMutex> lock(_mutex);
+    return CacheBase::PutIfAbsent(key, hash, std::move(value), expire_at);
+}
+
+// See MapBasedGlobalLockImpl.h
+bool ClockLRU::Set(const std::string &key, size_t hash, Value value, uint32_t expire_at) {
+    std::lock_guard<Concurrency::SharedMutex> lock(_mutex);
+    return CacheBase::Set(key, hash, std::move(value), expire_at);
+}
+
+// See MapBasedGlobalLockImpl.h
+bool ClockLRU::Get(const std::string &key, size_t hash, Value &value) {
+    Concurrency::SharedLock lock(_mutex);
+    Entry *node = _lookup(key, hash);
+    if (node == nullptr || _dead(*node, TimingWheel::Now())) {
+        _misses.Add();
+        return false;
+    }
+
+    value = _share(*node);
+    _on_access(*node);
+    _hits.Add();
+    return true;
+}
+
+// See MapBasedGlobalLockImpl.h
+bool ClockLRU::Append(const std::string &key, size_t hash, const std::string &data) {
+    std::lock_guard<Concurrency::SharedMutex> lock(_mutex);
+    return CacheBase::Append(key, hash, data);
+}
+
+// See MapBasedGlobalLockImpl.h
+bool ClockLRU::Prepend(const std::string &key, size_t hash, const std::string &data) {
+    std::lock_guard<Concurrency::SharedMutex> lock(_mutex);
+    return CacheBase::Prepend(key, hash, data);
+}
+
+// See MapBasedGlobalLockImpl.h
+CounterStatus ClockLRU::Increment(const std::string &key, size_t hash, uint64_t delta, uint64_t &value) {
+    if (_shared_count(key, hash, delta, false, value)) {
+        return CounterStatus::Done;
+    }
+    std::lock_guard<Concurrency::SharedMutex> lock(_mutex);
+    return CacheBase::Increment(key, hash, delta, value);
+}
+
+// See MapBasedGlobalLockImpl.h
+CounterStatus ClockLRU::Decrement(const std::string &key, size_t hash, uint64_t delta, uint64_t &value) {
+    if (_shared_count(key, hash, delta, true, value)) {
+        return CounterStatus::Done;
+    }
+    std::lock_guard<Concurrency::SharedMutex> lock(_mutex);
+    return CacheBase::Decrement(key, hash, delta, value);
+}
+
+// See MapBasedGlobalLockImpl.h
+CasStatus ClockLRU::CompareAndSet(const std::string &key, size_t hash, Value value, uint64_t version,
+                                  uint32_t expire_at) {
+    std::lock_guard<Concurrency::SharedMutex> lock(_mutex);
+    return CacheBase::CompareAndSet(key, hash, std::move(value), version, expire_at);
+}
+
+// See MapBasedGlobalLockImpl.h
+bool ClockLRU::Touch(const std::string &key, size_t hash, uint32_t expire_at) {
+    std::lock_guard<Concurrency::SharedMutex> lock(_mutex);
+    return CacheBase::Touch(key, hash, expire_at);
+}
+
+// See MapBasedGlobalLockImpl.h
+bool ClockLRU::GetAndTouch(const std::string &key, size_t hash, uint32_t expire_at, Value &value,
+                           uint64_t &version) {
+    std::lock_guard<Concurrency::SharedMutex> lock(_mutex);
+    return CacheBase::GetAndTouch(key, hash, expire_at, value, version);
+}
+
+// See CacheBase.h
+size_t ClockLRU::GetMany(const std::vector<std::string> &keys, const std::vector<size_t> &hashes, const size_t *at,
+                         size_t n, std::vector<Value> &values, std::vector<uint64_t> *versions) {
+    Concurrency::SharedLock lock(_mutex);
+    uint32_t now = TimingWheel::Now();
+    size_t found = 0;
+    for (size_t begin = 0; begin < n; begin += kBatch) {
+        size_t end = std::min(n, begin + kBatch);
+        _prefetch(hashes, at + begin, end - begin);
+        for (size_t i = begin; i < end; i++) {
+            Entry *node = _lookup(keys[at[i]], hashes[at[i]]);
+            if (node == nullptr || _dead(*node, now)) {
+                _misses.Add();
+                continue;
+            }
+
+            if (versions != nullptr) {
+                (*versions)[at[i]] = node->version.load(std::memory_order_acquire);
+            }
+            values[at[i]] = _share(*node);
+            _on_access(*node);
+            _hits.Add();
+            found++;
+        }
+    }
+    return found;
+}
+
+// See MapBasedGlobalLockImpl.h
+void ClockLRU::GetStats(StorageStats &stats) {
+    Concurrency::SharedLock lock(_mutex);
+    CacheBase::GetStats(stats);
+}
+
+// See CacheBase.h
+bool ClockLRU::Sweep(size_t limit) {
+    std::lock_guard<Concurrency::SharedMutex> lock(_mutex);
+    return _expire(limit) == limit;
+}
+
+// See CacheBase.h
+void ClockLRU::_on_insert(Entry &node) {
+    // New entry is placed right behind the hand, so it will be checked last
+    node.referenced.store(0, std::memory_order_relaxed);
+    node.link_before(*_hand);
+}
+
+// See CacheBase.h
+void ClockLRU::_on_access(Entry &node) {
+    // Avoid write if bit is already set, so hot entries' cache lines aren't bouncing between readers
+    if (node.referenced.load(std::memory_order_relaxed) == 0) {
+        node.referenced.store(1, std::memory_order_relaxed);
+    }
+}
+
+// See CacheBase.h
+void ClockLRU::_on_remove(Entry &node) {
+    if (_hand == &node) {
+        _hand = node.next;
+    }
+    node.unlink();
+}
+
+// See CacheBase.h
+void ClockLRU::_on_replace(Entry &old, Entry &fresh) {
+    CacheBase::_on_replace(old, fresh);
+    fresh.referenced.store(old.referenced.load(std::memory_order_relaxed), std::memory_order_relaxed);
+    if (_hand == &old) {
+        _hand = &fresh;
+    }
+}
+
+// See ClockLRU.h
+bool ClockLRU::_shared_count(const std::string &key, size_t hash, uint64_t delta, bool decrement, uint64_t &value) {
+    // Numeric counter is updated by a single atomic instruction, so concurrent updates don't need exclusive lock
+    Concurrency::SharedLock lock(_mutex);
+    Entry *node = _lookup(key, hash);
+    if (node == nullptr || _dead(*node, TimingWheel::Now()) || !node->numeric) {
+        return false;
+    }
+
+    value = node->count(delta, decrement);
+    _stamp(*node);
+    _on_access(*node);
+    return true;
+}
+
+// See CacheBase.h
+Entry *ClockLRU::_victim() {
+    for (;;) {
+        if (_hand == &_clock_head) {
+            _hand = _clock_head.next;
+            continue;
+        }
+
+        if (_hand->referenced.load(std::memory_order_relaxed) == 0) {
+            return _hand;
+        }
+
+        // Second chance
+        _hand->referenced.store(0, std::memory_order_relaxed);
+        _hand = _hand->next;
+    }
+}
+
+} // namespace Backend
+} // namespace Afina
@@ -0,0 +1,155 @@
+#ifndef AFINA_STORAGE_CLOCK_LRU_H
+#define AFINA_STORAGE_CLOCK_LRU_H
+
+#include <string>
+
+#include <afina/concurrency/SharedMutex.h>
+
+#include "CacheBase.h"
+#include "Sweeper.h"
+
+namespace Afina {
+namespace Backend {
+
+/**
+ * # CLOCK approximation of LRU
+ * Entries are placed into a ring, each entry has reference bit which is set on every hit. Once cache needs space
+ * clock hand goes round the ring: entries with reference bit set get a second chance and the bit cleared, the
+ * first entry without it gets evicted.
+ *
+ * Hit doesn't modify ring, only sets a bit, so Get runs under shared lock and readers don't block each other.
+ * For the same reason Get only skips expired entry, it is removed by the background sweep or the next write.
+ * That IS thread safe implementation!!
+ */
+class ClockLRU : public CacheBase {
+public:
+    ClockLRU(size_t max_size = 1024) : CacheBase(max_size), _sweeper([this]() { return Sweep(); }) {
+        _clock_head.make_head();
+        _hand = &_clock_head;
+    }
+    ~ClockLRU() {}
+
+    // Implements Afina::Storage interface
+    void Start() override { _sweeper.Start(); }
+
+    // Implements Afina::Storage interface
+    void Stop() override { _sweeper.Stop(); }
+
+    // See CacheBase.h
+    bool Sweep(size_t limit = kSweepSlice) override;
+
+    // Implements Afina::Storage interface
+    bool Put(const std::string &key, const std::string &value, uint32_t expire_at = 0) override {
+        return Put(key, _hash(key), value, expire_at);
+    }
+
+    // Implements Afina::Storage interface
+    bool PutIfAbsent(const std::string &key, const std::string &value, uint32_t expire_at = 0) override {
+        return PutIfAbsent(key, _hash(key), value, expire_at);
+    }
+
+    // Implements Afina::Storage interface
+    bool Set(const std::string &key, const std::string &value, uint32_t expire_at = 0) override {
+        return Set(key, _hash(key), value, expire_at);
+    }
+
+    // Implements Afina::Storage interface
+    bool Delete(const std::string &key) override { return Delete(key, _hash(key)); }
+
+    // Implements Afina::Storage interface
+    bool Get(const std::string &key, std::string &value) override { return Get(key, _hash(key), value); }
+
+    // Implements Afina::Storage interface
+    bool Put(const std::string &key, size_t hash, const std::string &value, uint32_t expire_at = 0) override;
+
+    // Implements Afina::Storage interface
+    bool PutIfAbsent(const std::string &key, size_t hash, const std::string &value, uint32_t expire_at = 0) override;
+
+    // Implements Afina::Storage interface
+    bool Set(const std::string &key, size_t hash, const std::string &value, uint32_t expire_at = 0) override;
+
+    // Implements Afina::Storage interface
+    bool Delete(const std::string &key, size_t hash) override;
+
+    // Implements Afina::Storage interface
+    bool Get(const std::string &key, size_t hash, std::string &value) override;
+
+    // Implements Afina::Storage interface
+    bool Put(const std::string &key, size_t hash, Value value, uint32_t expire_at = 0) override;
+
+    // Implements Afina::Storage interface
+    bool PutIfAbsent(const std::string &key, size_t hash, Value value, uint32_t expire_at = 0) override;
+
+    // Implements Afina::Storage interface
+    bool Set(const std::string &key, size_t hash, Value value, uint32_t expire_at = 0) override;
+
+    // Implements Afina::Storage interface
+    bool Get(const std::string &key, size_t hash, Value &value) override;
+
+    // Implements Afina::Storage interface
+    bool Append(const std::string &key, size_t hash, const std::string &data) override;
+
+    // Implements Afina::Storage interface
+    bool Prepend(const std::string &key, size_t hash, const std::string &data) override;
+
+    // Implements Afina::Storage interface
+    CounterStatus Increment(const std::string &key, size_t hash, uint64_t delta, uint64_t &value) override;
+
+    // Implements Afina::Storage interface
+    CounterStatus Decrement(const std::string &key, size_t hash, uint64_t delta, uint64_t &value) override;
+
+    // Implements Afina::Storage interface
+    void GetStats(StorageStats &stats) override;
+
+    // Implements Afina::Storage interface
+    CasStatus CompareAndSet(const std::string &key, size_t hash, Value value, uint64_t version,
+                            uint32_t expire_at = 0) override;
+
+    // Implements Afina::Storage interface
+    bool Touch(const std::string &key, size_t hash, uint32_t expire_at) override;
+
+    // Implements Afina::Storage interface
+    bool GetAndTouch(const std::string &key, size_t hash, uint32_t expire_at, Value &value,
+                     uint64_t &version) override;
+
+    // See CacheBase.h
+    size_t GetMany(const std::vector<std::string> &keys, const std::vector<size_t> &hashes, const size_t *at,
+                   size_t n, std::vector<Value> &values, std::vector<uint64_t> *versions) override;
+
+protected:
+    // See CacheBase.h
+    void _on_insert(Entry &node) override;
+
+    // See CacheBase.h
+    void _on_access(Entry &node) override;
+
+    // See CacheBase.h
+    void _on_remove(Entry &node) override;
+
+    // See CacheBase.h
+    void _on_replace(Entry &old, Entry &fresh) override;
+
+    // See CacheBase.h
+    Entry *_victim() override;
+
+private:
+    // Updates counter which is already numeric under the shared lock, returns false if update needs exclusive one
+    bool _shared_count(const std::string &key, size_t hash, uint64_t delta, bool decrement, uint64_t &value);
+
+    // Readers holds it in shared mode, anybody who changes cache - in exclusive
+    Concurrency::SharedMutex _mutex;
+
+    // Ring of all entries, head itself is never evicted and skipped by the hand
+    Entry _clock_head;
+
+    // Next entry to be checked for eviction
+    Entry *_hand;
+
+    // Reclaims expired entries in background
+    Sweeper _sweeper;
+};
+
+} // namespace Backend
+} // namespace Afina
+
+#endif // AFINA_STORAGE_CLOCK_LRU_H
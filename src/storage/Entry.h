@@ -0,0 +1,232 @@
+#ifndef AFINA_STORAGE_ENTRY_H
+#define AFINA_STORAGE_ENTRY_H
+
+#include <atomic>
+#include <cstddef>
+#include <cstdint>
+#include <cstring>
+#include <new>
+#include <string>
+
+#include <afina/Value.h>
+
+namespace Afina {
+namespace Backend {
+
+/**
+ * # Cache entry
+ * Entry is a single memory chunk: header followed by key bytes and then value bytes. Header has links so entry
+ * could be placed into intrusive list without any extra allocations.
+ *
+ * Chunk could be larger than key and value together, rest of the chunk is available for the value to grow in place.
+ *
+ * Large value could be external: chunk keeps the buffer released by Afina::Value in place of the value bytes,
+ * so value is neither copied in nor out, value_size is still the size of the value itself.
+ *
+ * Value of incr/decr could be numeric: chunk keeps native 64 bit counter aligned to 8 bytes after the key, so
+ * it is updated by a single atomic instruction. Such value is turned into decimal text on read only, value_size
+ * is the size of the counter.
+ */
+struct Entry {
+    // Intrusive list links
+    Entry *prev;
+    Entry *next;
+
+    // Hash of the key, saved to avoid recalculation on index rehash
+    size_t hash;
+
+    uint32_t key_size;
+    uint32_t value_size;
+
+    // Number of bytes after header available for key and value
+    uint32_t capacity;
+
+    // Absolute unix time in seconds when entry expires, 0 means never
+    uint32_t expire_at;
+
+    // Version of the value for compare and set, stamped by the storage on every change. Counter could be updated
+    // under the shared lock, so it is atomic as well
+    std::atomic<uint64_t> version;
+
+    // Links of the timing wheel slot, see TimingWheel.h
+    Entry *timer_next;
+    Entry **timer_pprev;
+
+    // Reference bit of CLOCK like policies. It is the only field could be changed by readers, so it is atomic
+    std::atomic<uint8_t> referenced;
+
+    // List of the eviction policy which entry belongs to, for policies keeping several lists
+    uint8_t queue;
+
+    // Value is kept in the shared buffer, see above
+    uint8_t external;
+
+    // Value is kept as native counter, see above
+    uint8_t numeric;
+
+    // Generation of the key entry has been written in, see Generations.h
+    uint32_t generation;
+
+    // Number of bytes after the key which counter needs
+    static constexpr size_t kCounterSize = sizeof(uint64_t);
+
+    /**
+     * Constructs entry in the given memory chunk and fills it with key and value
+     */
+    static Entry *Emplace(void *chunk, size_t chunk_size, const char *key, size_t key_size, size_t hash,
+                          const char *value, size_t value_size, uint32_t expire_at) {
+        Entry *entry = new (chunk) Entry();
+        entry->hash = hash;
+        entry->expire_at = expire_at;
+        entry->key_size = key_size;
+        entry->value_size = value_size;
+        entry->capacity = chunk_size - sizeof(Entry);
+        std::memcpy(entry->key(), key, key_size);
+        std::memcpy(entry->inline_value(), value, value_size);
+        return entry;
+    }
+
+    /**
+     * Constructs entry in the given memory chunk, entry takes over the buffer released by Afina::Value
+     */
+    static Entry *EmplaceExternal(void *chunk, size_t chunk_size, const char *key, size_t key_size, size_t hash,
+                                  void *buffer, size_t value_size, uint32_t expire_at) {
+        Entry *entry = Emplace(chunk, chunk_size, key, key_size, hash, reinterpret_cast<const char *>(&buffer),
+                               sizeof(buffer), expire_at);
+        entry->external = 1;
+        entry->value_size = value_size;
+        return entry;
+    }
+
+    inline char *key() { return reinterpret_cast<char *>(this + 1); }
+    inline const char *key() const { return reinterpret_cast<const char *>(this + 1); }
+
+    // Value bytes kept in the chunk, entry must not be external
+    inline char *inline_value() { return key() + key_size; }
+
+    // Value bytes, entry must not be numeric
+    inline const char *value() const { return external ? Value::Peek(buffer()).data() : key() + key_size; }
+
+    // Adds bytes after the inline value, chunk must have enough capacity
+    inline void append(const char *data, size_t size) {
+        std::memcpy(inline_value() + value_size, data, size);
+        value_size += size;
+    }
+
+    // Adds bytes before the inline value, chunk must have enough capacity
+    inline void prepend(const char *data, size_t size) {
+        std::memmove(inline_value() + size, inline_value(), value_size);
+        std::memcpy(inline_value(), data, size);
+        value_size += size;
+    }
+
+    // Offset of the counter from the end of the header, as header is aligned to 8 bytes so is the counter
+    inline size_t counter_offset() const { return (key_size + 7) & ~size_t(7); }
+
+    inline std::atomic<uint64_t> &counter() {
+        return *reinterpret_cast<std::atomic<uint64_t> *>(key() + counter_offset());
+    }
+    inline const std::atomic<uint64_t> &counter() const {
+        return *reinterpret_cast<const std::atomic<uint64_t> *>(key() + counter_offset());
+    }
+
+    // Turns inline value into the counter with the given value, chunk must have enough capacity
+    inline void make_counter(uint64_t value) {
+        new (key() + counter_offset()) std::atomic<uint64_t>(value);
+        numeric = 1;
+        value_size = kCounterSize;
+    }
+
+    /**
+     * Adds delta to the counter or substracts it, counter never goes below zero. Returns the new value
+     */
+    inline uint64_t count(uint64_t delta, bool decrement) {
+        std::atomic<uint64_t> &value = counter();
+        if (!decrement) {
+            // Wraps around like memcached does
+            return value.fetch_add(delta, std::memory_order_relaxed) + delta;
+        }
+
+        uint64_t current = value.load(std::memory_order_relaxed);
+        uint64_t next;
+        do {
+            next = current > delta ? current - delta : 0;
+        } while (!value.compare_exchange_weak(current, next, std::memory_order_relaxed));
+        return next;
+    }
+
+    // Copies value out, counter is turned into the decimal text
+    inline void copy_value(std::string &out) const {
+        if (numeric) {
+            out = std::to_string(counter().load(std::memory_order_relaxed));
+        } else {
+            out.assign(value(), value_size);
+        }
+    }
+
+    /**
+     * Parses decimal unsigned 64 bit number the value of incr/decr must be, returns false if it is not a number
+     */
+    static inline bool parse_counter(const char *text, size_t size, uint64_t &value) {
+        if (size == 0 || size > 20) {
+            return false;
+        }
+        value = 0;
+        for (size_t i = 0; i < size; i++) {
+            if (text[i] < '0' || text[i] > '9') {
+                return false;
+            }
+            uint64_t digit = text[i] - '0';
+            if (value > (UINT64_MAX - digit) / 10) {
+                return false;
+            }
+            value = value * 10 + digit;
+        }
+        return true;
+    }
+
+    // Buffer of the external value
+    inline void *buffer() const {
+        void *result;
+        std::memcpy(&result, key() + key_size, sizeof(result));
+        return result;
+    }
+
+    // Makes entry an empty list head
+    inline void make_head() {
+        prev = this;
+        next = this;
+    }
+
+    // Removes entry from the list it is linked into
+    inline void unlink() {
+        prev->next = next;
+        next->prev = prev;
+    }
+
+    // Links entry into list right before the given one
+    inline void link_before(Entry &pos) {
+        prev = pos.prev;
+        next = &pos;
+        pos.prev->next = this;
+        pos.prev = this;
+    }
+
+    inline bool expired(uint32_t now) const { return expire_at != 0 && expire_at <= now; }
+
+    inline bool key_equal(const std::string &other) const {
+        return key_size == other.size() && std::memcmp(key(), other.data(), key_size) == 0;
+    }
+};
+
+// Index traits for the Entry, see SwissTable.h
+struct EntryTraits {
+    static size_t hash(const Entry *entry) { return entry->hash; }
+    static bool equal(const Entry *entry, const std::string &key) { return entry->key_equal(key); }
+    static bool equal(const Entry *entry, const Entry *other) { return entry == other; }
+};
+
+} // namespace Backend
+} // namespace Afina
+
+#endif // AFINA_STORAGE_ENTRY_H
@@ -0,0 +1,66 @@
+#include "FrequencySketch.h"
+
+namespace Afina {
+namespace Backend {
+
+constexpr size_t FrequencySketch::kRows;
+constexpr uint8_t FrequencySketch::kMaxCount;
+
+// See FrequencySketch.h
+FrequencySketch::FrequencySketch(size_t width) : _additions(0) {
+    size_t row_size = 16;
+    while (row_size < width) {
+        row_size *= 2;
+    }
+
+    _mask = row_size - 1;
+    _table.assign(kRows * row_size, 0);
+    _sample_size = 10 * row_size;
+}
+
+// See FrequencySketch.h
+void FrequencySketch::Increment(size_t hash) {
+    uint8_t *cells[kRows];
+    uint8_t min = kMaxCount;
+    for (size_t row = 0; row < kRows; row++) {
+        cells[row] = &_table[row * (_mask + 1) + _index(hash, row)];
+        if (*cells[row] < min) {
+            min = *cells[row];
+        }
+    }
+
+    if (min == kMaxCount) {
+        return;
+    }
+    for (size_t row = 0; row < kRows; row++) {
+        if (*cells[row] == min) {
+            (*cells[row])++;
+        }
+    }
+
+    if (++_additions >= _sample_size) {
+        _age();
+    }
+}
+
+// See FrequencySketch.h
+uint8_t FrequencySketch::Frequency(size_t hash) const {
+    uint8_t min = kMaxCount;
+    for (size_t row = 0; row < kRows; row++) {
+        uint8_t count = _table[row * (_mask + 1) + _index(hash, row)];
+        if (count < min) {
+            min = count;
+        }
+    }
+    return min;
+}
+
+void FrequencySketch::_age() {
+    for (uint8_t &count : _table) {
+        count >>= 1;
+    }
+    _additions /= 2;
+}
+
+} // namespace Backend
+} // namespace Afina
@@ -0,0 +1,67 @@
+#ifndef AFINA_STORAGE_FREQUENCY_SKETCH_H
+#define AFINA_STORAGE_FREQUENCY_SKETCH_H
+
+#include <cstddef>
+#include <cstdint>
+#include <vector>
+
+namespace Afina {
+namespace Backend {
+
+/**
+ * # Count-Min Sketch of key access frequency
+ * Each key is counted in one cell of every row, estimation is the minimum over its cells, so collisions could
+ * only make estimation higher. Only the smallest of key cells get incremented (conservative update), which
+ * keeps overestimation lower.
+ *
+ * Counters are saturated at 15 and all of them get halved once number of increments reaches sample size, so
+ * sketch forgets old history and recently popular keys are able to beat the ones which were popular long ago.
+ *
+ * That is NOT thread safe implementation!!
+ */
+class FrequencySketch {
+public:
+    /**
+     * @param width expected number of distinct keys in the cache
+     */
+    FrequencySketch(size_t width);
+    ~FrequencySketch() {}
+
+    /**
+     * Counts one more access to the key with the given hash
+     */
+    void Increment(size_t hash);
+
+    /**
+     * Estimated number of accesses to the key with the given hash since it was aged last time
+     */
+    uint8_t Frequency(size_t hash) const;
+
+private:
+    static constexpr size_t kRows = 4;
+    static constexpr uint8_t kMaxCount = 15;
+
+    // Index of the key cell in the given row
+    inline size_t _index(size_t hash, size_t row) const {
+        // Double hashing: rows use different multiples of the second hash
+        size_t h2 = (hash >> 17 | hash << 47) * 0x9E3779B97F4A7C15ULL | 1;
+        return (hash + row * h2) & _mask;
+    }
+
+    // Halves all counters
+    void _age();
+
+    size_t _mask;
+
+    // Counters of all rows one after another
+    std::vector<uint8_t> _table;
+
+    // Number of increments since the last aging and the limit
+    size_t _additions;
+    size_t _sample_size;
+};
+
+} // namespace Backend
+} // namespace Afina
+
+#endif // AFINA_STORAGE_FREQUENCY_SKETCH_H
@@ -0,0 +1,31 @@
+#include "Generations.h"
+
+namespace Afina {
+namespace Backend {
+
+constexpr size_t Generations::kSlots;
+
+// See Generations.h
+void Generations::FlushAll(uint32_t at, uint32_t now) {
+    if (at != 0 && at > now) {
+        _flush_at.store(at, std::memory_order_relaxed);
+        return;
+    }
+    _flush_at.store(0, std::memory_order_relaxed);
+    _global.fetch_add(1, std::memory_order_release);
+}
+
+// See Generations.h
+void Generations::FlushNamespace(const std::string &ns) {
+    _namespaces[_slot(ns.data(), ns.size())].fetch_add(1, std::memory_order_release);
+    _namespaced.store(true, std::memory_order_release);
+}
+
+void Generations::_apply(uint32_t at) {
+    if (_flush_at.compare_exchange_strong(at, 0, std::memory_order_relaxed)) {
+        _global.fetch_add(1, std::memory_order_release);
+    }
+}
+
+} // namespace Backend
+} // namespace Afina
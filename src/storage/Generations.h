@@ -0,0 +1,98 @@
+#ifndef AFINA_STORAGE_GENERATIONS_H
+#define AFINA_STORAGE_GENERATIONS_H
+
+#include <atomic>
+#include <cstddef>
+#include <cstdint>
+#include <cstring>
+#include <memory>
+#include <string>
+
+#include <afina/Hash.h>
+
+#include "Entry.h"
+
+namespace Afina {
+namespace Backend {
+
+/**
+ * # Generations of the keys
+ * Makes flush_all and namespace invalidation cost O(1): every entry remembers generation of its key at the time
+ * it was written and is dead as soon as generation of the key moves on. Nothing is removed by the flush itself,
+ * storage drops dead entry once lookup runs into it, the rest goes away by regular eviction.
+ *
+ * Generation of the key is the sum of the global generation and the generation of the key namespace, which is
+ * the part of the key before the first ':'. Both only grow, so the sum changes whenever any of them does.
+ * Namespaces are hashed into the fixed table, namespaces sharing a slot are invalidated together, that is
+ * harmless for a cache. Namespace is not even looked at until some namespace has been flushed.
+ *
+ * Global flush could be delayed, pending flush is applied by the first check made once its time has come.
+ *
+ * That IS thread safe implementation!!
+ */
+class Generations {
+public:
+    Generations() : _global(0), _flush_at(0), _namespaced(false), _namespaces(new std::atomic<uint32_t>[kSlots]()) {}
+
+    Generations(const Generations &) = delete;
+    Generations &operator=(const Generations &) = delete;
+
+    /**
+     * Current generation of the key, now is the current unix time in seconds
+     */
+    inline uint32_t Of(const char *key, size_t key_size, uint32_t now) {
+        uint32_t at = _flush_at.load(std::memory_order_relaxed);
+        if (at != 0 && at <= now) {
+            _apply(at);
+        }
+
+        uint32_t result = _global.load(std::memory_order_acquire);
+        if (_namespaced.load(std::memory_order_relaxed)) {
+            const char *end = static_cast<const char *>(std::memchr(key, ':', key_size));
+            if (end != nullptr) {
+                result += _namespaces[_slot(key, end - key)].load(std::memory_order_acquire);
+            }
+        }
+        return result;
+    }
+
+    /**
+     * Entry was written before the last flush of its key
+     */
+    inline bool Stale(const Entry &entry, uint32_t now) {
+        return entry.generation != Of(entry.key(), entry.key_size, now);
+    }
+
+    /**
+     * Moves all the keys to the next generation at the given unix time, right now if it is 0 or has passed
+     * already. Pending flush is replaced, as memcached does
+     */
+    void FlushAll(uint32_t at, uint32_t now);
+
+    /**
+     * Moves keys of the namespace to the next generation right now
+     */
+    void FlushNamespace(const std::string &ns);
+
+private:
+    static constexpr size_t kSlots = 1024;
+
+    static inline size_t _slot(const char *ns, size_t size) { return Hash(ns, size) & (kSlots - 1); }
+
+    // Applies flush pending since the given time, only one of concurrent callers does it
+    void _apply(uint32_t at);
+
+    std::atomic<uint32_t> _global;
+
+    // Unix time of the pending flush, 0 if there is none
+    std::atomic<uint32_t> _flush_at;
+
+    // Some namespace has been flushed, so namespace generations are not all zero anymore
+    std::atomic<bool> _namespaced;
+    std::unique_ptr<std::atomic<uint32_t>[]> _namespaces;
+};
+
+} // namespace Backend
+} // namespace Afina
+
+#endif // AFINA_STORAGE_GENERATIONS_H
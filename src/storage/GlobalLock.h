@@ -0,0 +1,182 @@
+#ifndef AFINA_STORAGE_GLOBAL_LOCK_H
+#define AFINA_STORAGE_GLOBAL_LOCK_H
+
+#include <cstdint>
+#include <mutex>
+#include <string>
+#include <vector>
+
+#include <afina/Hash.h>
+#include <afina/Storage.h>
+
+#include "Sweeper.h"
+
+namespace Afina {
+namespace Backend {
+
+/**
+ * # Thread safe version of any CacheBase based cache
+ * Every operation runs under a single mutex, expired entries are reclaimed by the background sweep.
+ *
+ * That IS thread safe implementation!!
+ */
+template <typename Cache> class GlobalLock : public Cache {
+public:
+    GlobalLock(size_t max_size = 1024) : Cache(max_size), _sweeper([this]() { return Sweep(); }) {}
+    ~GlobalLock() {}
+
+    // Implements Afina::Storage interface
+    void Start() override { _sweeper.Start(); }
+
+    // Implements Afina::Storage interface
+    void Stop() override { _sweeper.Stop(); }
+
+    // Implements Afina::Storage interface
+    bool Put(const std::string &key, const std::string &value, uint32_t expire_at = 0) override {
+        return Put(key, Hash(key), value, expire_at);
+    }
+
+    // Implements Afina::Storage interface
+    bool Put(const std::string &key, size_t hash, const std::string &value, uint32_t expire_at = 0) override {
+        std::lock_guard<std::mutex> lock(_mutex);
+        return Cache::Put(key, hash, value, expire_at);
+    }
+
+    // Implements Afina::Storage interface
+    bool PutIfAbsent(const std::string &key, const std::string &value, uint32_t expire_at = 0) override {
+        return PutIfAbsent(key, Hash(key), value, expire_at);
+    }
+
+    // Implements Afina::Storage interface
+    bool PutIfAbsent(const std::string &key, size_t hash, const std::string &value, uint32_t expire_at = 0) override {
+        std::lock_guard<std::mutex> lock(_mutex);
+        return Cache::PutIfAbsent(key, hash, value, expire_at);
+    }
+
+    // Implements Afina::Storage interface
+    bool Set(const std::string &key, const std::string &value, uint32_t expire_at = 0) override {
+        return Set(key, Hash(key), value, expire_at);
+    }
+
+    // Implements Afina::Storage interface
+    bool Set(const std::string &key, size_t hash, const std::string &value, uint32_t expire_at = 0) override {
+        std::lock_guard<std::mutex> lock(_mutex);
+        return Cache::Set(key, hash, value, expire_at);
+    }
+
+    // Implements Afina::Storage interface
+    bool Delete(const std::string &key) override { return Delete(key, Hash(key)); }
+
+    // Implements Afina::Storage interface
+    bool Delete(const std::string &key, size_t hash) override {
+        std::lock_guard<std::mutex> lock(_mutex);
+        return Cache::Delete(key, hash);
+    }
+
+    // Implements Afina::Storage interface
+    bool Get(const std::string &key, std::string &value) override { return Get(key, Hash(key), value); }
+
+    // Implements Afina::Storage interface
+    bool Get(const std::string &key, size_t hash, std::string &value) override {
+        std::lock_guard<std::mutex> lock(_mutex);
+        return Cache::Get(key, hash, value);
+    }
+
+    // Implements Afina::Storage interface
+    bool Put(const std::string &key, size_t hash, Value value, uint32_t expire_at = 0) override {
+        std::lock_guard<std::mutex> lock(_mutex);
+        return Cache::Put(key, hash, std::move(value), expire_at);
+    }
+
+    // Implements Afina::Storage interface
+    bool PutIfAbsent(const std::string &key, size_t hash, Value value, uint32_t expire_at = 0) override {
+        std::lock_guard<std::mutex> lock(_mutex);
+        return Cache::PutIfAbsent(key, hash, std::move(value), expire_at);
+    }
+
+    // Implements Afina::Storage interface
+    bool Set(const std::string &key, size_t hash, Value value, uint32_t expire_at = 0) override {
+        std::lock_guard<std::mutex> lock(_mutex);
+        return Cache::Set(key, hash, std::move(value), expire_at);
+    }
+
+    // Implements Afina::Storage interface
+    bool Get(const std::string &key, size_t hash, Value &value) override {
+        std::lock_guard<std::mutex> lock(_mutex);
+        return Cache::Get(key, hash, value);
+    }
+
+    // Implements Afina::Storage interface
+    bool Append(const std::string &key, size_t hash, const std::string &data) override {
+        std::lock_guard<std::mutex> lock(_mutex);
+        return Cache::Append(key, hash, data);
+    }
+
+    // Implements Afina::Storage interface
+    bool Prepend(const std::string &key, size_t hash, const std::string &data) override {
+        std::lock_guard<std::mutex> lock(_mutex);
+        return Cache::Prepend(key, hash, data);
+    }
+
+    // Implements Afina::Storage interface
+    CounterStatus Increment(const std::string &key, size_t hash, uint64_t delta, uint64_t &value) override {
+        std::lock_guard<std::mutex> lock(_mutex);
+        return Cache::Increment(key, hash, delta, value);
+    }
+
+    // Implements Afina::Storage interface
+    CounterStatus Decrement(const std::string &key, size_t hash, uint64_t delta, uint64_t &value) override {
+        std::lock_guard<std::mutex> lock(_mutex);
+        return Cache::Decrement(key, hash, delta, value);
+    }
+
+    // Implements Afina::Storage interface
+    CasStatus CompareAndSet(const std::string &key, size_t hash, Value value, uint64_t version,
+                            uint32_t expire_at = 0) override {
+        std::lock_guard<std::mutex> lock(_mutex);
+        return Cache::CompareAndSet(key, hash, std::move(value), version, expire_at);
+    }
+
+    // Implements Afina::Storage interface
+    bool Touch(const std::string &key, size_t hash, uint32_t expire_at) override {
+        std::lock_guard<std::mutex> lock(_mutex);
+        return Cache::Touch(key, hash, expire_at);
+    }
+
+    // Implements Afina::Storage interface
+    bool GetAndTouch(const std::string &key, size_t hash, uint32_t expire_at, Value &value,
+                     uint64_t &version) override {
+        std::lock_guard<std::mutex> lock(_mutex);
+        return Cache::GetAndTouch(key, hash, expire_at, value, version);
+    }
+
+    // See CacheBase.h
+    size_t GetMany(const std::vector<std::string> &keys, const std::vector<size_t> &hashes, const size_t *at,
+                   size_t n, std::vector<Value> &values, std::vector<uint64_t> *versions) override {
+        std::lock_guard<std::mutex> lock(_mutex);
+        return Cache::GetMany(keys, hashes, at, n, values, versions);
+    }
+
+    // Implements Afina::Storage interface
+    void GetStats(StorageStats &stats) override {
+        std::lock_guard<std::mutex> lock(_mutex);
+        Cache::GetStats(stats);
+    }
+
+    // See CacheBase.h
+    bool Sweep(size_t limit = Cache::kSweepSlice) override {
+        std::lock_guard<std::mutex> lock(_mutex);
+        return this->_expire(limit) == limit;
+    }
+
+private:
+    std::mutex _mutex;
+
+    // Reclaims expired entries in background
+    Sweeper _sweeper;
+};
+
+} // namespace Backend
+} // namespace Afina
+
+#endif // AFINA_STORAGE_GLOBAL_LOCK_H
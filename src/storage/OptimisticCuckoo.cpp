@@ -0,0 +1,1079 @@
+#include "OptimisticCuckoo.h"
+
+#include <algorithm>
+#include <thread>
+#include <utility>
+#include <vector>
+
+namespace Afina {
+namespace Backend {
+
+constexpr size_t OptimisticCuckoo::kSlots;
+constexpr size_t OptimisticCuckoo::kStripes;
+constexpr size_t OptimisticCuckoo::kMaxPath;
+constexpr size_t OptimisticCuckoo::kSweepSlice;
+constexpr size_t OptimisticCuckoo::kBatch;
+constexpr size_t OptimisticCuckoo::kExternalSize;
+
+// Table is sized for entries of 64 bytes on average, fully occupied buckets are fine as CLOCK keeps
+// making room there
+static size_t buckets_for(size_t max_size) {
+    size_t n = 16;
+    while (n < max_size / (64 * 4)) {
+        n *= 2;
+    }
+    return n;
+}
+
+OptimisticCuckoo::OptimisticCuckoo(size_t max_size)
+    : _max_size(max_size), _cur_size(0), _cur_items(0), _versions(0), _n_buckets(buckets_for(max_size)),
+      _buckets(new Bucket[_n_buckets]()), _stripes(new Stripe[kStripes]()),
+      _refs(new std::atomic<uint8_t>[_n_buckets]()), _hand(0),
+      _sweeper([this]() { return Sweep(); }) {}
+
+OptimisticCuckoo::~OptimisticCuckoo() {
+    // Chunks go away with the allocator, but external values are owned by entries
+    for (size_t bucket = 0; bucket < _n_buckets; bucket++) {
+        for (size_t i = 0; i < kSlots; i++) {
+            Entry *node = _buckets[bucket].slots[i].load(std::memory_order_relaxed);
+            if (node != nullptr && node->external) {
+                Value::Adopt(node->buffer());
+            }
+        }
+    }
+}
+
+// See MapBasedGlobalLockImpl.h
+bool OptimisticCuckoo::Put(const std::string &key, size_t hash, const std::string &value, uint32_t expire_at) {
+    return _store(key, hash, {value.data(), value.size(), nullptr}, expire_at, Mode::Upsert) == CasStatus::Stored;
+}
+
+// See MapBasedGlobalLockImpl.h
+bool OptimisticCuckoo::PutIfAbsent(const std::string &key, size_t hash, const std::string &value, uint32_t expire_at) {
+    return _store(key, hash, {value.data(), value.size(), nullptr}, expire_at, Mode::Insert) == CasStatus::Stored;
+}
+
+// See MapBasedGlobalLockImpl.h
+bool OptimisticCuckoo::Set(const std::string &key, size_t hash, const std::string &value, uint32_t expire_at) {
+    return _store(key, hash, {value.data(), value.size(), nullptr}, expire_at, Mode::Update) == CasStatus::Stored;
+}
+
+// See MapBasedGlobalLockImpl.h
+bool OptimisticCuckoo::Put(const std::string &key, size_t hash, Value value, uint32_t expire_at) {
+    return _store(key, hash, {value.data(), value.size(), &value}, expire_at, Mode::Upsert) == CasStatus::Stored;
+}
+
+// See MapBasedGlobalLockImpl.h
+bool OptimisticCuckoo::PutIfAbsent(const std::string &key, size_t hash, Value value, uint32_t expire_at) {
+    return _store(key, hash, {value.data(), value.size(), &value}, expire_at, Mode::Insert) == CasStatus::Stored;
+}
+
+// See MapBasedGlobalLockImpl.h
+bool OptimisticCuckoo::Set(const std::string &key, size_t hash, Value value, uint32_t expire_at) {
+    return _store(key, hash, {value.data(), value.size(), &value}, expire_at, Mode::Update) == CasStatus::Stored;
+}
+
+// See MapBasedGlobalLockImpl.h
+bool OptimisticCuckoo::Append(const std::string &key, size_t hash, const std::string &data) {
+    return _concat(key, hash, data, false);
+}
+
+// See MapBasedGlobalLockImpl.h
+bool OptimisticCuckoo::Prepend(const std::string &key, size_t hash, const std::string &data) {
+    return _concat(key, hash, data, true);
+}
+
+// See MapBasedGlobalLockImpl.h
+CounterStatus OptimisticCuckoo::Increment(const std::string &key, size_t hash, uint64_t delta, uint64_t &value) {
+    return _count(key, hash, delta, false, value);
+}
+
+// See MapBasedGlobalLockImpl.h
+CounterStatus OptimisticCuckoo::Decrement(const std::string &key, size_t hash, uint64_t delta, uint64_t &value) {
+    return _count(key, hash, delta, true, value);
+}
+
+// See MapBasedGlobalLockImpl.h
+bool OptimisticCuckoo::Delete(const std::string &key, size_t hash) {
+    Position pos = _position(hash);
+    if (!_find(key, pos, nullptr)) {
+        return false;
+    }
+
+    _lock_pair(pos.b1, pos.b2);
+    size_t bucket = pos.b1;
+    int slot = _locked_find(bucket, pos.tag, key);
+    if (slot < 0) {
+        bucket = pos.b2;
+        slot = _locked_find(bucket, pos.tag, key);
+    }
+
+    Entry *node = nullptr;
+    if (slot >= 0) {
+        node = _buckets[bucket].slots[slot].load(std::memory_order_relaxed);
+        _locked_clear(bucket, slot);
+    }
+    _unlock_pair(pos.b1, pos.b2);
+
+    if (node == nullptr) {
+        return false;
+    }
+
+    // Expired or flushed entry is removed anyway, but for the client it didn't exist
+    bool expired = _dead(node, TimingWheel::Now());
+    _cur_size.fetch_sub(node->key_size + node->value_size);
+    _cur_items.fetch_sub(1);
+    _free_entry(node);
+    return !expired;
+}
+
+// See MapBasedGlobalLockImpl.h
+bool OptimisticCuckoo::Get(const std::string &key, size_t hash, std::string &value) {
+    if (_find(key, _position(hash), &value)) {
+        _hits.Add();
+        return true;
+    }
+    _misses.Add();
+    return false;
+}
+
+// See MapBasedGlobalLockImpl.h
+bool OptimisticCuckoo::Get(const std::string &key, size_t hash, Value &value) {
+    std::string data;
+    Value shared;
+    if (_find(key, _position(hash), &data, nullptr, &shared)) {
+        value = shared ? std::move(shared) : Value(std::move(data));
+        _hits.Add();
+        return true;
+    }
+    _misses.Add();
+    return false;
+}
+
+// See MapBasedGlobalLockImpl.h
+size_t OptimisticCuckoo::MultiGet(const std::vector<std::string> &keys, const std::vector<size_t> &hashes,
+                                  std::vector<Value> &values) {
+    return _multi_get(keys, hashes, values, nullptr);
+}
+
+// See MapBasedGlobalLockImpl.h
+size_t OptimisticCuckoo::MultiGets(const std::vector<std::string> &keys, const std::vector<size_t> &hashes,
+                                   std::vector<Value> &values, std::vector<uint64_t> &versions) {
+    versions.assign(keys.size(), 0);
+    return _multi_get(keys, hashes, values, &versions);
+}
+
+size_t OptimisticCuckoo::_multi_get(const std::vector<std::string> &keys, const std::vector<size_t> &hashes,
+                                    std::vector<Value> &values, std::vector<uint64_t> *versions) {
+    values.assign(keys.size(), Value());
+
+    size_t found = 0;
+    Position pos[kBatch];
+    std::string value;
+    for (size_t begin = 0; begin < keys.size(); begin += kBatch) {
+        size_t n = std::min(keys.size() - begin, kBatch);
+
+        // Both buckets and stripes of every key are requested before the first one is searched
+        for (size_t i = 0; i < n; i++) {
+            pos[i] = _position(hashes[begin + i]);
+            __builtin_prefetch(&_buckets[pos[i].b1]);
+            __builtin_prefetch(&_buckets[pos[i].b2]);
+            __builtin_prefetch(&_stripes[_stripe_of(pos[i].b1)]);
+            __builtin_prefetch(&_stripes[_stripe_of(pos[i].b2)]);
+        }
+
+        for (size_t i = 0; i < n; i++) {
+            uint64_t *version = versions != nullptr ? &(*versions)[begin + i] : nullptr;
+            Value shared;
+            if (_find(keys[begin + i], pos[i], &value, version, &shared)) {
+                values[begin + i] = shared ? std::move(shared) : Value(std::move(value));
+                _hits.Add();
+                found++;
+            } else {
+                _misses.Add();
+            }
+        }
+    }
+    return found;
+}
+
+// See MapBasedGlobalLockImpl.h
+bool OptimisticCuckoo::GetAndTouch(const std::string &key, size_t hash, uint32_t expire_at, Value &value,
+                                   uint64_t &version) {
+    if (_touch(key, hash, expire_at, &value, &version)) {
+        _hits.Add();
+        return true;
+    }
+    _misses.Add();
+    return false;
+}
+
+// See MapBasedGlobalLockImpl.h
+void OptimisticCuckoo::GetStats(StorageStats &stats) {
+    stats.get_hits = _hits.Load();
+    stats.get_misses = _misses.Load();
+    stats.evictions = _evictions.Load();
+    stats.curr_items = _cur_items.load();
+    stats.bytes = _cur_size.load();
+    stats.limit_maxbytes = _max_size;
+}
+
+// See OptimisticCuckoo.h
+bool OptimisticCuckoo::Sweep(size_t limit) {
+    uint32_t now = TimingWheel::Now();
+    for (size_t removed = 0; removed < limit; removed++) {
+        Entry *node;
+        size_t hash;
+        {
+            // Entry can't be freed while it is in the wheel, so it is safe to read the hash
+            std::lock_guard<std::mutex> lock(_timers_mutex);
+            node = _timers.Expired(now);
+            if (node == nullptr) {
+                return false;
+            }
+            hash = node->hash;
+        }
+
+        // Entry could be removed or even replaced by another one in the same chunk once wheel is unlocked,
+        // so it is taken out of the table only if it is still there and still expired
+        Position pos = _position(hash);
+        _lock_pair(pos.b1, pos.b2);
+        bool found = false;
+        for (size_t bucket : {pos.b1, pos.b2}) {
+            for (size_t i = 0; i < kSlots && !found; i++) {
+                if (_buckets[bucket].slots[i].load(std::memory_order_relaxed) == node && node->expired(now)) {
+                    _locked_clear(bucket, i);
+                    found = true;
+                }
+            }
+        }
+        _unlock_pair(pos.b1, pos.b2);
+
+        if (!found) {
+            // Somebody else is removing it right now and will cancel the timer
+            return false;
+        }
+        _cur_size.fetch_sub(node->key_size + node->value_size);
+        _cur_items.fetch_sub(1);
+        _free_entry(node);
+    }
+    return true;
+}
+
+OptimisticCuckoo::Position OptimisticCuckoo::_position(size_t hash) const {
+    Position pos;
+    pos.hash = hash;
+
+    // Tag comes from the high bits, bucket from the low ones, so they are independent
+    pos.tag = pos.hash >> (8 * (sizeof(size_t) - 1));
+    if (pos.tag == 0) {
+        pos.tag = 1;
+    }
+    pos.b1 = pos.hash & (_n_buckets - 1);
+    pos.b2 = _alt_bucket(pos.b1, pos.tag);
+    return pos;
+}
+
+bool OptimisticCuckoo::_find(const std::string &key, const Position &pos, std::string *value, uint64_t *version,
+                             Value *handle) {
+    Stripe &s1 = _stripes[_stripe_of(pos.b1)];
+    Stripe &s2 = _stripes[_stripe_of(pos.b2)];
+    uint32_t now = TimingWheel::Now();
+
+    for (;;) {
+        uint32_t v1 = s1.version.load(std::memory_order_acquire);
+        uint32_t v2 = s2.version.load(std::memory_order_acquire);
+        if ((v1 | v2) & 1) {
+            // Writer is in the middle of the change
+            std::this_thread::yield();
+            continue;
+        }
+
+        int slot = -1;
+        bool external = false;
+        size_t bucket = pos.b1;
+        bool found = _read_bucket(bucket, pos, key, now, value, version, slot, external);
+        if (!found && pos.b2 != pos.b1) {
+            bucket = pos.b2;
+            found = _read_bucket(bucket, pos, key, now, value, version, slot, external);
+        }
+
+        std::atomic_thread_fence(std::memory_order_acquire);
+        if (s1.version.load(std::memory_order_relaxed) != v1 || s2.version.load(std::memory_order_relaxed) != v2) {
+            continue;
+        }
+
+        if (found) {
+            _set_ref(bucket, slot);
+        }
+        if (!found || !external || (value == nullptr && handle == nullptr)) {
+            return found;
+        }
+
+        // Buffer could be released right now, so it is shared under the locks. Entry could be gone meanwhile or
+        // even changed, whatever is there under the locks is the answer
+        Value shared;
+        if (!_locked_get(key, pos, shared, version)) {
+            return false;
+        }
+        if (handle != nullptr) {
+            *handle = std::move(shared);
+        } else {
+            value->assign(shared.data(), shared.size());
+        }
+        return true;
+    }
+}
+
+bool OptimisticCuckoo::_locked_get(const std::string &key, const Position &pos, Value &value, uint64_t *version) {
+    _lock_pair(pos.b1, pos.b2);
+    int slot = _locked_find(pos.b1, pos.tag, key);
+    size_t bucket = slot >= 0 ? pos.b1 : pos.b2;
+    if (slot < 0) {
+        slot = _locked_find(bucket, pos.tag, key);
+    }
+
+    Entry *node = slot >= 0 ? _buckets[bucket].slots[slot].load(std::memory_order_relaxed) : nullptr;
+    bool found = node != nullptr && !_dead(node, TimingWheel::Now());
+    if (found) {
+        value = _share(*node);
+        if (version != nullptr) {
+            *version = node->version.load(std::memory_order_relaxed);
+        }
+    }
+    _unlock_pair(pos.b1, pos.b2);
+    return found;
+}
+
+bool OptimisticCuckoo::_read_bucket(size_t bucket, const Position &pos, const std::string &key, uint32_t now,
+                                    std::string *value, uint64_t *version, int &slot, bool &external) {
+    Bucket &b = _buckets[bucket];
+    for (size_t i = 0; i < kSlots; i++) {
+        if (b.tags[i].load(std::memory_order_relaxed) != pos.tag) {
+            continue;
+        }
+
+        Entry *node = b.slots[i].load(std::memory_order_acquire);
+        if (node == nullptr) {
+            continue;
+        }
+
+        // Entry could be changed or even freed and reused right now, so sizes are checked against the chunk
+        // before touching the bytes. Whatever is read here is discarded unless versions are still the same
+        uint32_t capacity = node->capacity;
+        uint32_t key_size = node->key_size;
+        uint32_t value_size = node->value_size;
+        bool is_external = node->external;
+        size_t stored = is_external ? sizeof(void *) : value_size;
+        if (key_size > capacity || stored > capacity - key_size) {
+            continue;
+        }
+
+        if (key_size != key.size() || std::memcmp(node->key(), key.data(), key_size) != 0) {
+            continue;
+        }
+
+        // Expired one is left for the sweep and flushed one for writers, reader never modifies table
+        if (_dead(node, now)) {
+            return false;
+        }
+
+        if (version != nullptr) {
+            *version = node->version.load(std::memory_order_relaxed);
+        }
+        if (value != nullptr) {
+            if (node->numeric) {
+                // Counter is aligned after the key, see Entry.h
+                size_t offset = (key_size + 7) & ~size_t(7);
+                if (offset + Entry::kCounterSize > capacity) {
+                    continue;
+                }
+                auto counter = reinterpret_cast<const std::atomic<uint64_t> *>(node->key() + offset);
+                *value = std::to_string(counter->load(std::memory_order_relaxed));
+            } else if (!is_external) {
+                value->assign(node->key() + key_size, value_size);
+            }
+        }
+        slot = i;
+        external = is_external;
+        return true;
+    }
+    return false;
+}
+
+CasStatus OptimisticCuckoo::_store(const std::string &key, size_t hash, const Input &input, uint32_t expire_at,
+                                   Mode mode, uint64_t version) {
+    size_t node_size = key.size() + input.size;
+    if (node_size > _max_size || sizeof(Entry) + key.size() + sizeof(void *) > _allocator.MaxPooledSize()) {
+        return CasStatus::NotStored;
+    }
+
+    // Value which doesn't fit into a pool page is kept external even if caller keeps its buffer
+    Input value = input;
+    Value copy;
+    if (value.buffer == nullptr && sizeof(Entry) + node_size > _allocator.MaxPooledSize()) {
+        copy = Value(value.data, value.size);
+        value.buffer = &copy;
+    }
+    bool external = value.buffer != nullptr && value.size >= kExternalSize;
+
+    // Optimistic check first, so there is no allocation for requests that would fail anyway
+    Position pos = _position(hash);
+    if (mode != Mode::Upsert) {
+        uint64_t current = 0;
+        bool found = _find(key, pos, nullptr, &current);
+        if (mode == Mode::Insert && found) {
+            return CasStatus::NotStored;
+        } else if (mode != Mode::Insert && !found) {
+            return CasStatus::NotFound;
+        } else if (mode == Mode::Cas && current != version) {
+            return CasStatus::Exists;
+        }
+    }
+
+    uint32_t now = TimingWheel::Now();
+    Entry *fresh = nullptr;
+    Entry *old = nullptr;
+    Entry *result = nullptr;
+    CasStatus status = CasStatus::NotFound;
+    size_t added = 0, removed = 0;
+    for (;;) {
+        _lock_pair(pos.b1, pos.b2);
+
+        size_t bucket = pos.b1;
+        int slot = _locked_find(bucket, pos.tag, key);
+        if (slot < 0) {
+            bucket = pos.b2;
+            slot = _locked_find(bucket, pos.tag, key);
+        }
+
+        if (slot >= 0) {
+            Entry *node = _buckets[bucket].slots[slot].load(std::memory_order_relaxed);
+            bool expired = _dead(node, now);
+            if (mode == Mode::Insert && !expired) {
+                status = CasStatus::NotStored;
+                _unlock_pair(pos.b1, pos.b2);
+                break;
+            }
+
+            if ((mode == Mode::Update || mode == Mode::Cas) && expired) {
+                // Expired entry is as good as absent, reclaim it right away
+                _locked_clear(bucket, slot);
+                removed = node->key_size + node->value_size;
+                _cur_items.fetch_sub(1);
+                old = node;
+                _unlock_pair(pos.b1, pos.b2);
+                break;
+            }
+
+            if (mode == Mode::Cas && node->version.load(std::memory_order_relaxed) != version) {
+                status = CasStatus::Exists;
+                _unlock_pair(pos.b1, pos.b2);
+                break;
+            }
+
+            if (!node->external && !external && node->key_size + value.size <= node->capacity) {
+                // Fits into the existing chunk, readers will see versions change
+                std::memcpy(node->inline_value(), value.data, value.size);
+                node->numeric = 0;
+                node->generation = _generations.Of(key.data(), key.size(), now);
+                removed = node->value_size;
+                node->value_size = value.size;
+                added = value.size;
+                if (node->expire_at != expire_at) {
+                    std::lock_guard<std::mutex> lock(_timers_mutex);
+                    _timers.Cancel(*node);
+                    node->expire_at = expire_at;
+                    if (expire_at != 0) {
+                        _timers.Schedule(*node);
+                    }
+                }
+                result = node;
+            } else if (fresh != nullptr) {
+                _buckets[bucket].slots[slot].store(fresh, std::memory_order_release);
+                removed = node->key_size + node->value_size;
+                added = node_size;
+                old = node;
+                result = fresh;
+                fresh = nullptr;
+            } else {
+                _unlock_pair(pos.b1, pos.b2);
+                fresh = _new_entry(key, pos.hash, value, expire_at);
+                continue;
+            }
+
+            _stamp(result);
+            _set_ref(bucket, slot);
+            _unlock_pair(pos.b1, pos.b2);
+            break;
+        }
+
+        if (mode == Mode::Update || mode == Mode::Cas) {
+            _unlock_pair(pos.b1, pos.b2);
+            break;
+        }
+
+        if (fresh == nullptr) {
+            _unlock_pair(pos.b1, pos.b2);
+            fresh = _new_entry(key, pos.hash, value, expire_at);
+            continue;
+        }
+
+        _stamp(fresh);
+        if (_locked_place(pos.b1, pos.tag, fresh) || _locked_place(pos.b2, pos.tag, fresh)) {
+            added = node_size;
+            _cur_items.fetch_add(1);
+            result = fresh;
+            fresh = nullptr;
+            _unlock_pair(pos.b1, pos.b2);
+            break;
+        }
+
+        // Both buckets are full
+        _unlock_pair(pos.b1, pos.b2);
+        _cuckoo(pos);
+    }
+
+    if (fresh != nullptr) {
+        _free_entry(fresh);
+    }
+    if (old != nullptr) {
+        _free_entry(old);
+    }
+
+    if (added >= removed) {
+        _cur_size.fetch_add(added - removed);
+    } else {
+        _cur_size.fetch_sub(removed - added);
+    }
+    while (_cur_size.load(std::memory_order_relaxed) > _max_size && _evict_one(result)) {
+    }
+    return result != nullptr ? CasStatus::Stored : status;
+}
+
+bool OptimisticCuckoo::_touch(const std::string &key, size_t hash, uint32_t expire_at, Value *value,
+                              uint64_t *version) {
+    Position pos = _position(hash);
+    _lock_pair(pos.b1, pos.b2);
+
+    size_t bucket = pos.b1;
+    int slot = _locked_find(bucket, pos.tag, key);
+    if (slot < 0) {
+        bucket = pos.b2;
+        slot = _locked_find(bucket, pos.tag, key);
+    }
+
+    Entry *node = slot >= 0 ? _buckets[bucket].slots[slot].load(std::memory_order_relaxed) : nullptr;
+    if (node == nullptr || _dead(node, TimingWheel::Now())) {
+        // Dead entry is left for the sweep and writers
+        _unlock_pair(pos.b1, pos.b2);
+        return false;
+    }
+
+    if (node->expire_at != expire_at) {
+        std::lock_guard<std::mutex> lock(_timers_mutex);
+        _timers.Cancel(*node);
+        node->expire_at = expire_at;
+        if (expire_at != 0) {
+            _timers.Schedule(*node);
+        }
+    }
+    if (value != nullptr) {
+        *value = _share(*node);
+    }
+    if (version != nullptr) {
+        *version = node->version.load(std::memory_order_relaxed);
+    }
+    _set_ref(bucket, slot);
+    _unlock_pair(pos.b1, pos.b2);
+    return true;
+}
+
+bool OptimisticCuckoo::_concat(const std::string &key, size_t hash, const std::string &data, bool prepend) {
+    Position pos = _position(hash);
+    uint32_t now = TimingWheel::Now();
+
+    // Chunk for the value which outgrows its entry, allocated out of the stripe locks
+    void *chunk = nullptr;
+    size_t chunk_size = 0;
+
+    Entry *old = nullptr;
+    Entry *result = nullptr;
+    size_t added = 0, removed = 0;
+    for (;;) {
+        _lock_pair(pos.b1, pos.b2);
+
+        size_t bucket = pos.b1;
+        int slot = _locked_find(bucket, pos.tag, key);
+        if (slot < 0) {
+            bucket = pos.b2;
+            slot = _locked_find(bucket, pos.tag, key);
+        }
+
+        Entry *node = slot >= 0 ? _buckets[bucket].slots[slot].load(std::memory_order_relaxed) : nullptr;
+        if (node == nullptr || _dead(node, now)) {
+            _unlock_pair(pos.b1, pos.b2);
+            break;
+        }
+
+        // Counter gets concatenated as the decimal text it stands for
+        std::string counter;
+        if (node->numeric) {
+            counter = std::to_string(node->counter().load(std::memory_order_relaxed));
+        }
+        const char *value = node->numeric ? counter.data() : node->value();
+        size_t value_size = node->numeric ? counter.size() : node->value_size;
+
+        size_t size = node->key_size + value_size + data.size();
+        if (size > _max_size) {
+            _unlock_pair(pos.b1, pos.b2);
+            break;
+        }
+
+        // Value which outgrows pool page goes to the new external buffer, as does any change of the external one
+        bool external = node->external || sizeof(Entry) + size > _allocator.MaxPooledSize();
+        size_t need = sizeof(Entry) + (external ? node->key_size + sizeof(void *) : size);
+
+        result = node;
+        removed = node->value_size;
+        added = value_size + data.size();
+        if (external || size > node->capacity) {
+            if (need > chunk_size) {
+                // Value could change while stripes are unlocked, so check everything again once chunk is here.
+                // Chunk of the inline value has headroom, so following concatenations are done in place
+                _unlock_pair(pos.b1, pos.b2);
+                std::lock_guard<std::mutex> lock(_allocator_mutex);
+                if (chunk != nullptr) {
+                    _allocator.Free(chunk);
+                }
+                chunk = _allocator.Allocate(
+                    external ? need : std::min(need + (size - node->key_size) / 2, _allocator.MaxPooledSize()),
+                    chunk_size);
+                result = nullptr;
+                continue;
+            }
+
+            if (external) {
+                std::string joined;
+                joined.reserve(value_size + data.size());
+                if (prepend) {
+                    joined.append(data).append(value, value_size);
+                } else {
+                    joined.append(value, value_size).append(data);
+                }
+                Value buffer(std::move(joined));
+                result = Entry::EmplaceExternal(chunk, chunk_size, node->key(), node->key_size, node->hash,
+                                                buffer.Release(), value_size + data.size(), node->expire_at);
+            } else {
+                result = Entry::Emplace(chunk, chunk_size, node->key(), node->key_size, node->hash, value,
+                                        value_size, node->expire_at);
+            }
+            result->generation = node->generation;
+            chunk = nullptr;
+            if (result->expire_at != 0) {
+                std::lock_guard<std::mutex> lock(_timers_mutex);
+                _timers.Schedule(*result);
+            }
+            old = node;
+        } else if (node->numeric) {
+            std::memcpy(node->inline_value(), value, value_size);
+            node->value_size = value_size;
+            node->numeric = 0;
+        }
+
+        // Entry which is still in the table is changed, so readers will see versions change. External buffer has
+        // got the data already
+        if (!result->external) {
+            if (prepend) {
+                result->prepend(data.data(), data.size());
+            } else {
+                result->append(data.data(), data.size());
+            }
+        }
+        _stamp(result);
+        if (result != node) {
+            _buckets[bucket].slots[slot].store(result, std::memory_order_release);
+        }
+        _set_ref(bucket, slot);
+        _unlock_pair(pos.b1, pos.b2);
+        break;
+    }
+
+    if (chunk != nullptr) {
+        std::lock_guard<std::mutex> lock(_allocator_mutex);
+        _allocator.Free(chunk);
+    }
+    if (old != nullptr) {
+        _free_entry(old);
+    }
+    if (result == nullptr) {
+        return false;
+    }
+
+    if (added >= removed) {
+        _cur_size.fetch_add(added - removed);
+    } else {
+        _cur_size.fetch_sub(removed - added);
+    }
+    while (_cur_size.load(std::memory_order_relaxed) > _max_size && _evict_one(result)) {
+    }
+    return true;
+}
+
+CounterStatus OptimisticCuckoo::_count(const std::string &key, size_t hash, uint64_t delta, bool decrement,
+                                       uint64_t &value) {
+    Position pos = _position(hash);
+    uint32_t now = TimingWheel::Now();
+
+    // Chunk for the counter which doesn't fit into the entry of the text, allocated out of the stripe locks
+    void *chunk = nullptr;
+    size_t chunk_size = 0;
+
+    Entry *old = nullptr;
+    Entry *result = nullptr;
+    size_t removed = 0;
+    bool converted = false;
+    CounterStatus status = CounterStatus::NotFound;
+    for (;;) {
+        _lock_pair(pos.b1, pos.b2);
+
+        size_t bucket = pos.b1;
+        int slot = _locked_find(bucket, pos.tag, key);
+        if (slot < 0) {
+            bucket = pos.b2;
+            slot = _locked_find(bucket, pos.tag, key);
+        }
+
+        Entry *node = slot >= 0 ? _buckets[bucket].slots[slot].load(std::memory_order_relaxed) : nullptr;
+        if (node == nullptr || _dead(node, now)) {
+            _unlock_pair(pos.b1, pos.b2);
+            break;
+        }
+
+        result = node;
+        if (!node->numeric) {
+            uint64_t current;
+            size_t size = node->counter_offset() + Entry::kCounterSize;
+            if (!Entry::parse_counter(node->value(), node->value_size, current) || size > _max_size) {
+                status = CounterStatus::NotNumeric;
+                result = nullptr;
+                _unlock_pair(pos.b1, pos.b2);
+                break;
+            }
+
+            if (size > node->capacity) {
+                if (sizeof(Entry) + size > chunk_size) {
+                    _unlock_pair(pos.b1, pos.b2);
+                    std::lock_guard<std::mutex> lock(_allocator_mutex);
+                    if (chunk != nullptr) {
+                        _allocator.Free(chunk);
+                    }
+                    chunk = _allocator.Allocate(sizeof(Entry) + size, chunk_size);
+                    result = nullptr;
+                    continue;
+                }
+
+                result = Entry::Emplace(chunk, chunk_size, node->key(), node->key_size, node->hash, "", 0,
+                                        node->expire_at);
+                result->generation = node->generation;
+                chunk = nullptr;
+                if (result->expire_at != 0) {
+                    std::lock_guard<std::mutex> lock(_timers_mutex);
+                    _timers.Schedule(*result);
+                }
+                old = node;
+            }
+            removed = node->value_size;
+            converted = true;
+            result->make_counter(current);
+            if (result != node) {
+                _buckets[bucket].slots[slot].store(result, std::memory_order_release);
+            }
+        }
+
+        // Stripes stay locked, so entry can't be freed under the update
+        value = result->count(delta, decrement);
+        _stamp(result);
+        status = CounterStatus::Done;
+        _set_ref(bucket, slot);
+        _unlock_pair(pos.b1, pos.b2);
+        break;
+    }
+
+    if (chunk != nullptr) {
+        std::lock_guard<std::mutex> lock(_allocator_mutex);
+        _allocator.Free(chunk);
+    }
+    if (old != nullptr) {
+        _free_entry(old);
+    }
+    if (!converted) {
+        return status;
+    }
+
+    // Text is replaced by the counter
+    if (Entry::kCounterSize >= removed) {
+        _cur_size.fetch_add(Entry::kCounterSize - removed);
+    } else {
+        _cur_size.fetch_sub(removed - Entry::kCounterSize);
+    }
+    while (_cur_size.load(std::memory_order_relaxed) > _max_size && _evict_one(result)) {
+    }
+    return status;
+}
+
+void OptimisticCuckoo::_lock(size_t s) {
+    Stripe &stripe = _stripes[s];
+    while (stripe.locked.exchange(true, std::memory_order_acquire)) {
+        while (stripe.locked.load(std::memory_order_relaxed)) {
+            std::this_thread::yield();
+        }
+    }
+
+    // Odd version must be visible before any change of the buckets
+    stripe.version.store(stripe.version.load(std::memory_order_relaxed) + 1, std::memory_order_relaxed);
+    std::atomic_thread_fence(std::memory_order_release);
+}
+
+void OptimisticCuckoo::_unlock(size_t s) {
+    Stripe &stripe = _stripes[s];
+    stripe.version.store(stripe.version.load(std::memory_order_relaxed) + 1, std::memory_order_release);
+    stripe.locked.store(false, std::memory_order_release);
+}
+
+void OptimisticCuckoo::_lock_pair(size_t b1, size_t b2) {
+    // Stripes are always locked in ascending order to avoid deadlocks
+    size_t s1 = _stripe_of(b1), s2 = _stripe_of(b2);
+    if (s1 > s2) {
+        std::swap(s1, s2);
+    }
+    _lock(s1);
+    if (s2 != s1) {
+        _lock(s2);
+    }
+}
+
+void OptimisticCuckoo::_unlock_pair(size_t b1, size_t b2) {
+    size_t s1 = _stripe_of(b1), s2 = _stripe_of(b2);
+    _unlock(s1);
+    if (s2 != s1) {
+        _unlock(s2);
+    }
+}
+
+int OptimisticCuckoo::_locked_find(size_t bucket, uint8_t tag, const std::string &key) const {
+    const Bucket &b = _buckets[bucket];
+    for (size_t i = 0; i < kSlots; i++) {
+        if (b.tags[i].load(std::memory_order_relaxed) == tag &&
+            b.slots[i].load(std::memory_order_relaxed)->key_equal(key)) {
+            return i;
+        }
+    }
+    return -1;
+}
+
+bool OptimisticCuckoo::_locked_place(size_t bucket, uint8_t tag, Entry *entry) {
+    Bucket &b = _buckets[bucket];
+    for (size_t i = 0; i < kSlots; i++) {
+        if (b.tags[i].load(std::memory_order_relaxed) == 0) {
+            _refs[bucket].fetch_and(~uint8_t(1 << i), std::memory_order_relaxed);
+            b.slots[i].store(entry, std::memory_order_release);
+            b.tags[i].store(tag, std::memory_order_release);
+            return true;
+        }
+    }
+    return false;
+}
+
+void OptimisticCuckoo::_locked_clear(size_t bucket, int slot) {
+    Bucket &b = _buckets[bucket];
+    b.tags[slot].store(0, std::memory_order_relaxed);
+    b.slots[slot].store(nullptr, std::memory_order_relaxed);
+    _refs[bucket].fetch_and(~uint8_t(1 << slot), std::memory_order_relaxed);
+}
+
+void OptimisticCuckoo::_cuckoo(const Position &pos) {
+    std::lock_guard<std::mutex> lock(_cuckoo_mutex);
+
+    // BFS over buckets, each node means "move entry from the slot of the parent bucket into this one"
+    struct Node {
+        size_t bucket;
+        int parent;
+        int slot;
+    };
+    std::vector<Node> path;
+    path.reserve(kMaxPath + kSlots);
+    path.push_back({pos.b1, -1, -1});
+    if (pos.b2 != pos.b1) {
+        path.push_back({pos.b2, -1, -1});
+    }
+
+    for (size_t head = 0; head < path.size(); head++) {
+        const Bucket &b = _buckets[path[head].bucket];
+        for (size_t i = 0; i < kSlots; i++) {
+            uint8_t tag = b.tags[i].load(std::memory_order_relaxed);
+            if (tag == 0) {
+                // Free slot found, move entries along the path starting from the end, so there is always
+                // free slot for the next move
+                for (int n = head; path[n].parent >= 0; n = path[n].parent) {
+                    const Node &node = path[n];
+                    if (!_move(path[node.parent].bucket, node.slot, node.bucket)) {
+                        // Table has been changed concurrently, caller will retry
+                        return;
+                    }
+                }
+                return;
+            }
+
+            if (path.size() < kMaxPath) {
+                path.push_back({_alt_bucket(path[head].bucket, tag), int(head), int(i)});
+            }
+        }
+    }
+
+    // Table is too dense around these buckets
+    _evict_from(pos.b1);
+}
+
+bool OptimisticCuckoo::_move(size_t from, int slot, size_t to) {
+    _lock_pair(from, to);
+
+    Bucket &src = _buckets[from];
+    uint8_t tag = src.tags[slot].load(std::memory_order_relaxed);
+    Entry *node = src.slots[slot].load(std::memory_order_relaxed);
+    uint8_t ref = _refs[from].load(std::memory_order_relaxed) & (1 << slot);
+
+    bool moved = tag != 0 && _alt_bucket(from, tag) == to && _locked_place(to, tag, node);
+    if (moved) {
+        // Carry reference bit, so move doesn't make entry a victim
+        if (ref != 0) {
+            Bucket &dst = _buckets[to];
+            for (size_t i = 0; i < kSlots; i++) {
+                if (dst.slots[i].load(std::memory_order_relaxed) == node) {
+                    _set_ref(to, i);
+                    break;
+                }
+            }
+        }
+        _locked_clear(from, slot);
+    }
+
+    _unlock_pair(from, to);
+    return moved;
+}
+
+bool OptimisticCuckoo::_evict_one(const Entry *keep) {
+    std::lock_guard<std::mutex> lock(_clock_mutex);
+
+    // Two rounds: first one could just clear reference bits
+    size_t total = _n_buckets * kSlots;
+    for (size_t step = 0; step < 2 * total; step++) {
+        size_t bucket = _hand / kSlots;
+        int slot = _hand % kSlots;
+        _hand = (_hand + 1) & (total - 1);
+
+        Entry *node = _buckets[bucket].slots[slot].load(std::memory_order_relaxed);
+        if (node == nullptr || node == keep) {
+            continue;
+        }
+
+        // Second chance
+        uint8_t bit = 1 << slot;
+        if (_refs[bucket].load(std::memory_order_relaxed) & bit) {
+            _refs[bucket].fetch_and(~bit, std::memory_order_relaxed);
+            continue;
+        }
+
+        size_t s = _stripe_of(bucket);
+        _lock(s);
+        if (_buckets[bucket].slots[slot].load(std::memory_order_relaxed) != node) {
+            // Changed concurrently, not a victim anymore
+            _unlock(s);
+            continue;
+        }
+        _locked_clear(bucket, slot);
+        _unlock(s);
+
+        _cur_size.fetch_sub(node->key_size + node->value_size);
+        _cur_items.fetch_sub(1);
+        _evictions.Add();
+        _free_entry(node);
+        return true;
+    }
+    return false;
+}
+
+void OptimisticCuckoo::_evict_from(size_t bucket) {
+    size_t s = _stripe_of(bucket);
+    _lock(s);
+
+    // Prefer entry that wasn't accessed recently
+    uint8_t refs = _refs[bucket].load(std::memory_order_relaxed);
+    int victim = -1;
+    for (size_t i = 0; i < kSlots; i++) {
+        if (_buckets[bucket].slots[i].load(std::memory_order_relaxed) != nullptr &&
+            (victim < 0 || (refs & (1 << i)) == 0)) {
+            victim = i;
+            if ((refs & (1 << i)) == 0) {
+                break;
+            }
+        }
+    }
+
+    Entry *node = nullptr;
+    if (victim >= 0) {
+        node = _buckets[bucket].slots[victim].load(std::memory_order_relaxed);
+        _locked_clear(bucket, victim);
+    }
+    _unlock(s);
+
+    if (node != nullptr) {
+        _cur_size.fetch_sub(node->key_size + node->value_size);
+        _cur_items.fetch_sub(1);
+        _evictions.Add();
+        _free_entry(node);
+    }
+}
+
+Entry *OptimisticCuckoo::_new_entry(const std::string &key, size_t hash, const Input &value, uint32_t expire_at) {
+    bool external = value.buffer != nullptr && value.size >= kExternalSize;
+    size_t capacity;
+    void *chunk;
+    {
+        std::lock_guard<std::mutex> lock(_allocator_mutex);
+        chunk = _allocator.Allocate(sizeof(Entry) + key.size() + (external ? sizeof(void *) : value.size), capacity);
+    }
+
+    Entry *entry;
+    if (external) {
+        // Large value given away by the caller is kept as is
+        entry = Entry::EmplaceExternal(chunk, capacity, key.data(), key.size(), hash, value.buffer->Release(),
+                                       value.size, expire_at);
+    } else {
+        entry = Entry::Emplace(chunk, capacity, key.data(), key.size(), hash, value.data, value.size, expire_at);
+    }
+    entry->generation = _generations.Of(key.data(), key.size(), TimingWheel::Now());
+    if (expire_at != 0) {
+        // Scheduled before entry gets into the table, so whoever removes it from the table later could cancel it
+        std::lock_guard<std::mutex> lock(_timers_mutex);
+        _timers.Schedule(*entry);
+    }
+    return entry;
+}
+
+void OptimisticCuckoo::_free_entry(Entry *entry) {
+    if (entry->expire_at != 0) {
+        std::lock_guard<std::mutex> lock(_timers_mutex);
+        _timers.Cancel(*entry);
+    }
+    if (entry->external) {
+        // Entry is out of the table, so readers can't take new references through it anymore
+        Value::Adopt(entry->buffer());
+    }
+
+    std::lock_guard<std::mutex> lock(_allocator_mutex);
+    _allocator.Free(entry);
+}
+
+} // namespace Backend
+} // namespace Afina
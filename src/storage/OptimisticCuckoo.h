@@ -0,0 +1,351 @@
+#ifndef AFINA_STORAGE_OPTIMISTIC_CUCKOO_H
+#define AFINA_STORAGE_OPTIMISTIC_CUCKOO_H
+
+#include <atomic>
+#include <functional>
+#include <memory>
+#include <mutex>
+#include <string>
+#include <vector>
+
+#include <afina/Hash.h>
+#include <afina/Storage.h>
+
+#include "Entry.h"
+#include "Generations.h"
+#include "SlabAllocator.h"
+#include "StatCounter.h"
+#include "Sweeper.h"
+#include "TimingWheel.h"
+
+namespace Afina {
+namespace Backend {
+
+/**
+ * # Concurrent cuckoo hash storage
+ * MemC3 like storage: each key could live in one of two buckets, each bucket has 4 slots with 1 byte tag of the
+ * key hash and pointer to the entry. Second bucket is computed from the first one and tag, so entry could be
+ * moved to its alternative bucket without knowing the key.
+ *
+ * Buckets are protected by lock stripes, each stripe has a version counter which is odd while some writer changes
+ * buckets of the stripe. Get doesn't take any lock: it reads versions, searches both buckets, copies value out and
+ * then checks versions again, retrying if anything has changed in between. Writers take spin locks of the buckets
+ * they modify, so writers to different buckets don't block each other. Insert into two full buckets moves entries
+ * into their alternative buckets along the path found by BFS, such moves are serialized by a separate mutex.
+ *
+ * Entries are allocated from the slab pool and chunk memory is never returned to the system, so it is safe for a
+ * reader to look into an entry that has just been freed - version check rejects what was read.
+ *
+ * Values of 4 KB and more given by handle are kept external like in CacheBase, so are values which don't fit into
+ * a pool page. External buffer is freed as soon as its entry is gone, that could happen right after optimistic
+ * reader has found the entry, so readers never touch the buffer optimistically: once the entry found is external,
+ * reader takes stripe locks of the key buckets and shares the buffer under them. Writers remove entry from the
+ * table under the same locks before they release its buffer, so the buffer is alive while reader holds them.
+ *
+ * Eviction is CLOCK: every slot has a reference bit set by Get, hand goes over slots of the table clearing bits
+ * until it finds an entry without one.
+ *
+ * Entries with TTL are scheduled in the timing wheel under its own mutex. Get only skips expired entries, writers
+ * reclaim expired entry they run into, everything else is removed by the background sweep. Flushed entries are
+ * treated as expired, but only writers and eviction reclaim them, see Generations.h
+ *
+ * That IS thread safe implementation!!
+ */
+class OptimisticCuckoo : public Afina::Storage {
+public:
+    OptimisticCuckoo(size_t max_size = 1024);
+    ~OptimisticCuckoo();
+
+    // Implements Afina::Storage interface
+    void Start() override { _sweeper.Start(); }
+
+    // Implements Afina::Storage interface
+    void Stop() override { _sweeper.Stop(); }
+
+    /**
+     * Removes at most limit expired entries, returns true if there could be more of them
+     */
+    bool Sweep(size_t limit = kSweepSlice);
+
+    // Implements Afina::Storage interface
+    bool Put(const std::string &key, const std::string &value, uint32_t expire_at = 0) override {
+        return Put(key, _hash(key), value, expire_at);
+    }
+
+    // Implements Afina::Storage interface
+    bool PutIfAbsent(const std::string &key, const std::string &value, uint32_t expire_at = 0) override {
+        return PutIfAbsent(key, _hash(key), value, expire_at);
+    }
+
+    // Implements Afina::Storage interface
+    bool Set(const std::string &key, const std::string &value, uint32_t expire_at = 0) override {
+        return Set(key, _hash(key), value, expire_at);
+    }
+
+    // Implements Afina::Storage interface
+    bool Delete(const std::string &key) override { return Delete(key, _hash(key)); }
+
+    // Implements Afina::Storage interface
+    bool Get(const std::string &key, std::string &value) override { return Get(key, _hash(key), value); }
+
+    // Implements Afina::Storage interface
+    bool Put(const std::string &key, size_t hash, const std::string &value, uint32_t expire_at = 0) override;
+
+    // Implements Afina::Storage interface
+    bool PutIfAbsent(const std::string &key, size_t hash, const std::string &value, uint32_t expire_at = 0) override;
+
+    // Implements Afina::Storage interface
+    bool Set(const std::string &key, size_t hash, const std::string &value, uint32_t expire_at = 0) override;
+
+    // Implements Afina::Storage interface
+    bool Delete(const std::string &key, size_t hash) override;
+
+    // Implements Afina::Storage interface
+    bool Get(const std::string &key, size_t hash, std::string &value) override;
+
+    // Implements Afina::Storage interface
+    bool Put(const std::string &key, size_t hash, Value value, uint32_t expire_at = 0) override;
+
+    // Implements Afina::Storage interface
+    bool PutIfAbsent(const std::string &key, size_t hash, Value value, uint32_t expire_at = 0) override;
+
+    // Implements Afina::Storage interface
+    bool Set(const std::string &key, size_t hash, Value value, uint32_t expire_at = 0) override;
+
+    // Implements Afina::Storage interface
+    bool Get(const std::string &key, size_t hash, Value &value) override;
+
+    // Implements Afina::Storage interface
+    bool Append(const std::string &key, size_t hash, const std::string &data) override;
+
+    // Implements Afina::Storage interface
+    bool Prepend(const std::string &key, size_t hash, const std::string &data) override;
+
+    // Implements Afina::Storage interface
+    CounterStatus Increment(const std::string &key, size_t hash, uint64_t delta, uint64_t &value) override;
+
+    // Implements Afina::Storage interface
+    CounterStatus Decrement(const std::string &key, size_t hash, uint64_t delta, uint64_t &value) override;
+
+    // Implements Afina::Storage interface
+    size_t MultiGet(const std::vector<std::string> &keys, const std::vector<size_t> &hashes,
+                    std::vector<Value> &values) override;
+
+    // Implements Afina::Storage interface
+    size_t MultiGets(const std::vector<std::string> &keys, const std::vector<size_t> &hashes,
+                     std::vector<Value> &values, std::vector<uint64_t> &versions) override;
+
+    // Implements Afina::Storage interface
+    CasStatus CompareAndSet(const std::string &key, size_t hash, Value value, uint64_t version,
+                            uint32_t expire_at = 0) override {
+        return _store(key, hash, {value.data(), value.size(), &value}, expire_at, Mode::Cas, version);
+    }
+
+    // Implements Afina::Storage interface
+    bool Touch(const std::string &key, size_t hash, uint32_t expire_at) override {
+        return _touch(key, hash, expire_at, nullptr, nullptr);
+    }
+
+    // Implements Afina::Storage interface
+    bool GetAndTouch(const std::string &key, size_t hash, uint32_t expire_at, Value &value,
+                     uint64_t &version) override;
+
+    // Implements Afina::Storage interface
+    void FlushAll(uint32_t at = 0) override { _generations.FlushAll(at, TimingWheel::Now()); }
+
+    // Implements Afina::Storage interface
+    void FlushNamespace(const std::string &ns) override { _generations.FlushNamespace(ns); }
+
+    // Implements Afina::Storage interface
+    void GetStats(StorageStats &stats) override;
+
+private:
+    static constexpr size_t kSlots = 4;
+    static constexpr size_t kStripes = 2048;
+    static constexpr size_t kMaxPath = 256;
+    static constexpr size_t kSweepSlice = 64;
+
+    // Number of keys of the batched lookup prefetched at once
+    static constexpr size_t kBatch = 16;
+
+    // Values given by buffer of at least this size are kept external instead of being copied
+    static constexpr size_t kExternalSize = 4096;
+
+    struct Bucket {
+        // Tag of each slot, 0 means slot is empty
+        std::atomic<uint8_t> tags[kSlots];
+
+        std::atomic<Entry *> slots[kSlots];
+    };
+
+    // Lock and version of the buckets group, padded to own cache line to avoid false sharing
+    struct Stripe {
+        std::atomic<uint32_t> version;
+        std::atomic<bool> locked;
+        char pad[64 - sizeof(std::atomic<uint32_t>) - sizeof(std::atomic<bool>)];
+    };
+
+    // Where to put key: any of its buckets plus tag
+    struct Position {
+        size_t hash;
+        uint8_t tag;
+        size_t b1;
+        size_t b2;
+    };
+
+    // What to do with existing and absent keys, Cas is Update of the given version only
+    enum class Mode { Upsert, Insert, Update, Cas };
+
+    // Value to be stored: bytes to copy and the buffer which could be kept instead, if caller gives it away
+    struct Input {
+        const char *data;
+        size_t size;
+        Value *buffer;
+    };
+
+    Position _position(size_t hash) const;
+
+    static inline size_t _hash(const std::string &key) { return Hash(key); }
+
+    inline size_t _alt_bucket(size_t bucket, uint8_t tag) const {
+        return (bucket ^ (tag * size_t(0x5bd1e995))) & (_n_buckets - 1);
+    }
+
+    inline size_t _stripe_of(size_t bucket) const { return bucket & (kStripes - 1); }
+
+    // Optimistic lookup, copies value and its version out if they are not nullptr. External value is shared into
+    // the handle instead of being copied if handle is given, value is left untouched then
+    bool _find(const std::string &key, const Position &pos, std::string *value, uint64_t *version = nullptr,
+               Value *handle = nullptr);
+
+    // Searches the bucket for the key, must run inside of the version check. Value of the external entry is not
+    // read, external is set instead
+    bool _read_bucket(size_t bucket, const Position &pos, const std::string &key, uint32_t now, std::string *value,
+                      uint64_t *version, int &slot, bool &external);
+
+    // Lookup under the stripe locks, value is shared out if it is external and copied otherwise
+    bool _locked_get(const std::string &key, const Position &pos, Value &value, uint64_t *version);
+
+    // Handle of the entry value, stripes of the entry must be locked
+    static inline Value _share(const Entry &node) {
+        if (node.numeric) {
+            return Value(std::to_string(node.counter().load(std::memory_order_relaxed)));
+        }
+        return node.external ? Value::Share(node.buffer()) : Value(node.value(), node.value_size);
+    }
+
+    // Batched lookup, versions are retrived as well unless it is nullptr
+    size_t _multi_get(const std::vector<std::string> &keys, const std::vector<size_t> &hashes,
+                      std::vector<Value> &values, std::vector<uint64_t> *versions);
+
+    CasStatus _store(const std::string &key, size_t hash, const Input &value, uint32_t expire_at, Mode mode,
+                     uint64_t version = 0);
+
+    // Sets expiration time of the existing key, shares value and copies its version out if they are not nullptr
+    bool _touch(const std::string &key, size_t hash, uint32_t expire_at, Value *value, uint64_t *version);
+
+    // Adds data after or before the value of the existing key
+    bool _concat(const std::string &key, size_t hash, const std::string &data, bool prepend);
+
+    // Adds delta to the counter of the existing key or substracts it, text value is turned into counter first
+    CounterStatus _count(const std::string &key, size_t hash, uint64_t delta, bool decrement, uint64_t &value);
+
+    // Stripe locks, every locked stripe gets its version bumped to odd and to even back on unlock
+    void _lock(size_t s);
+    void _unlock(size_t s);
+    void _lock_pair(size_t b1, size_t b2);
+    void _unlock_pair(size_t b1, size_t b2);
+
+    // Returns slot of the key in the bucket or -1, stripe must be locked
+    int _locked_find(size_t bucket, uint8_t tag, const std::string &key) const;
+
+    // Puts entry into free slot of the bucket if there is some, stripe must be locked
+    bool _locked_place(size_t bucket, uint8_t tag, Entry *entry);
+
+    // Clears slot, stripe must be locked
+    void _locked_clear(size_t bucket, int slot);
+
+    // Tries to make free slot in one of the buckets by moving entries to their alternative buckets, evicts
+    // entry from the first bucket if there is no path to the free slot
+    void _cuckoo(const Position &pos);
+
+    // Moves entry from the slot to the free slot of its alternative bucket, fails if anything has changed
+    // since path was found
+    bool _move(size_t from, int slot, size_t to);
+
+    // Evicts one entry by CLOCK skipping keep, returns false if there is nothing to evict
+    bool _evict_one(const Entry *keep);
+
+    // Evicts some entry from the bucket, used when there is no room for displacement
+    void _evict_from(size_t bucket);
+
+    // Allocates entry and schedules its expiration, value is kept external if caller gives its buffer away and it
+    // is large enough
+    Entry *_new_entry(const std::string &key, size_t hash, const Input &value, uint32_t expire_at);
+
+    // Cancels expiration and returns entry to the pool, external value buffer is released. Entry must be already
+    // removed from the table
+    void _free_entry(Entry *entry);
+
+    // Gives entry the next version once its value has changed, stripes of the entry must be locked
+    inline void _stamp(Entry *entry) {
+        entry->version.store(_versions.fetch_add(1, std::memory_order_relaxed) + 1, std::memory_order_relaxed);
+    }
+
+    // Entry is either expired or flushed, so it must be treated as absent
+    inline bool _dead(const Entry *entry, uint32_t now) {
+        return entry->expired(now) || _generations.Stale(*entry, now);
+    }
+
+    inline void _set_ref(size_t bucket, int slot) {
+        uint8_t bit = 1 << slot;
+        if ((_refs[bucket].load(std::memory_order_relaxed) & bit) == 0) {
+            _refs[bucket].fetch_or(bit, std::memory_order_relaxed);
+        }
+    }
+
+    // Maximum number of bytes could be stored in this cache.
+    // i.e all (keys+values) must be less the _max_size
+    const std::size_t _max_size;
+    std::atomic<size_t> _cur_size;
+    std::atomic<size_t> _cur_items;
+
+    // Last version given to an entry
+    std::atomic<uint64_t> _versions;
+
+    // Generations of keys for flushes
+    Generations _generations;
+
+    StatCounter _hits;
+    StatCounter _misses;
+    StatCounter _evictions;
+
+    const size_t _n_buckets;
+    std::unique_ptr<Bucket[]> _buckets;
+    std::unique_ptr<Stripe[]> _stripes;
+
+    // CLOCK reference bits, one per slot
+    std::unique_ptr<std::atomic<uint8_t>[]> _refs;
+
+    // Serializes cuckoo displacements
+    std::mutex _cuckoo_mutex;
+
+    // CLOCK hand over all slots of the table
+    std::mutex _clock_mutex;
+    size_t _hand;
+
+    // Pool of entries
+    std::mutex _allocator_mutex;
+    SlabAllocator _allocator;
+
+    // Expiration of entries, lock order is stripe locks and then this one
+    std::mutex _timers_mutex;
+    TimingWheel _timers;
+
+    Sweeper _sweeper;
+};
+
+} // namespace Backend
+} // namespace Afina
+
+#endif // AFINA_STORAGE_OPTIMISTIC_CUCKOO_H
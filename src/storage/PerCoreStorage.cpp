@@ -0,0 +1,611 @@
+#include "PerCoreStorage.h"
+
+#include <chrono>
+#include <climits>
+#include <ctime>
+#include <stdexcept>
+
+#include <linux/futex.h>
+#include <pthread.h>
+#include <sched.h>
+#include <sys/eventfd.h>
+#include <sys/syscall.h>
+#include <unistd.h>
+
+#include "ShardBatch.h"
+#include "SimpleLRU.h"
+
+namespace Afina {
+namespace Backend {
+
+constexpr int PerCoreStorage::kPending;
+constexpr int PerCoreStorage::kWaiting;
+constexpr int PerCoreStorage::kDone;
+constexpr int PerCoreStorage::kAwake;
+constexpr int PerCoreStorage::kSleeping;
+
+// How long caller spins waiting for the owner before it goes to sleep
+static constexpr int kSpins = 2048;
+
+// How often idle owner reclaims expired entries
+static constexpr long kSweepPeriodMs = 100;
+
+// Core served by the current thread, nullptr for threads which serve none
+static thread_local void *current_core = nullptr;
+
+static void futex_wait(std::atomic<int> &word, int value, const struct timespec *timeout = nullptr) {
+    syscall(SYS_futex, reinterpret_cast<int *>(&word), FUTEX_WAIT_PRIVATE, value, timeout, nullptr, 0);
+}
+
+static void futex_wake(std::atomic<int> &word) {
+    syscall(SYS_futex, reinterpret_cast<int *>(&word), FUTEX_WAKE_PRIVATE, INT_MAX, nullptr, nullptr, 0);
+}
+
+static inline void cpu_relax() {
+#if defined(__x86_64__) || defined(__i386__)
+    __builtin_ia32_pause();
+#endif
+}
+
+PerCoreStorage::PerCoreStorage(size_t max_size)
+    : PerCoreStorage(max_size, [](size_t size) { return new SimpleLRU(size); }) {}
+
+PerCoreStorage::PerCoreStorage(size_t max_size, ShardFactory make_shard) {
+    cpu_set_t allowed;
+    CPU_ZERO(&allowed);
+    if (sched_getaffinity(0, sizeof(allowed), &allowed) == 0) {
+        for (size_t core = 0; core < _cores.Size() && core < CPU_SETSIZE; core++) {
+            if (CPU_ISSET(core, &allowed)) {
+                _active.push_back(core);
+            }
+        }
+    }
+    if (_active.empty()) {
+        _active.push_back(0);
+    }
+
+    size_t n = 1;
+    while (n < _active.size()) {
+        n *= 2;
+    }
+    _shard_mask = n - 1;
+    for (size_t i = 0; i < n; i++) {
+        size_t core = _active[i % _active.size()];
+        _shards.emplace_back(make_shard(max_size / n));
+        _owners.push_back(core);
+        _cores.Get(core).shards.push_back(i);
+    }
+
+    for (size_t core : _active) {
+        Core &c = _cores.Get(core);
+        c.id = core;
+        c.event_fd = eventfd(0, EFD_NONBLOCK | EFD_CLOEXEC);
+        if (c.event_fd == -1) {
+            throw std::runtime_error("Failed to create event descriptor of the core");
+        }
+        c.attached.store(false);
+        c.next_sweep = std::chrono::steady_clock::now() + std::chrono::milliseconds(kSweepPeriodMs);
+        c.more_expired = false;
+        c.state.store(kAwake);
+        c.running.store(true);
+        c.owner = std::thread(&PerCoreStorage::_run, this, core);
+    }
+}
+
+PerCoreStorage::~PerCoreStorage() {
+    for (size_t core : _active) {
+        Core &c = _cores.Get(core);
+        if (c.owner.joinable()) {
+            c.running.store(false);
+            c.state.store(kAwake);
+            futex_wake(c.state);
+            c.owner.join();
+        }
+        close(c.event_fd);
+    }
+}
+
+// See MapBasedGlobalLockImpl.h
+bool PerCoreStorage::Put(const std::string &key, size_t hash, const std::string &value, uint32_t expire_at) {
+    Request req;
+    req.op = Op::Put;
+    req.shard = _shard_of(hash);
+    req.key = &key;
+    req.hash = hash;
+    req.value = &value;
+    req.expire_at = expire_at;
+    return _call(req);
+}
+
+// See MapBasedGlobalLockImpl.h
+bool PerCoreStorage::PutIfAbsent(const std::string &key, size_t hash, const std::string &value, uint32_t expire_at) {
+    Request req;
+    req.op = Op::PutIfAbsent;
+    req.shard = _shard_of(hash);
+    req.key = &key;
+    req.hash = hash;
+    req.value = &value;
+    req.expire_at = expire_at;
+    return _call(req);
+}
+
+// See MapBasedGlobalLockImpl.h
+bool PerCoreStorage::Set(const std::string &key, size_t hash, const std::string &value, uint32_t expire_at) {
+    Request req;
+    req.op = Op::Set;
+    req.shard = _shard_of(hash);
+    req.key = &key;
+    req.hash = hash;
+    req.value = &value;
+    req.expire_at = expire_at;
+    return _call(req);
+}
+
+// See MapBasedGlobalLockImpl.h
+bool PerCoreStorage::Put(const std::string &key, size_t hash, Value value, uint32_t expire_at) {
+    Request req;
+    req.op = Op::Put;
+    req.shard = _shard_of(hash);
+    req.key = &key;
+    req.hash = hash;
+    req.owned = &value;
+    req.expire_at = expire_at;
+    return _call(req);
+}
+
+// See MapBasedGlobalLockImpl.h
+bool PerCoreStorage::PutIfAbsent(const std::string &key, size_t hash, Value value, uint32_t expire_at) {
+    Request req;
+    req.op = Op::PutIfAbsent;
+    req.shard = _shard_of(hash);
+    req.key = &key;
+    req.hash = hash;
+    req.owned = &value;
+    req.expire_at = expire_at;
+    return _call(req);
+}
+
+// See MapBasedGlobalLockImpl.h
+bool PerCoreStorage::Set(const std::string &key, size_t hash, Value value, uint32_t expire_at) {
+    Request req;
+    req.op = Op::Set;
+    req.shard = _shard_of(hash);
+    req.key = &key;
+    req.hash = hash;
+    req.owned = &value;
+    req.expire_at = expire_at;
+    return _call(req);
+}
+
+// See MapBasedGlobalLockImpl.h
+bool PerCoreStorage::Delete(const std::string &key, size_t hash) {
+    Request req;
+    req.op = Op::Delete;
+    req.shard = _shard_of(hash);
+    req.key = &key;
+    req.hash = hash;
+    return _call(req);
+}
+
+// See MapBasedGlobalLockImpl.h
+bool PerCoreStorage::Get(const std::string &key, size_t hash, std::string &value) {
+    Request req;
+    req.op = Op::Get;
+    req.shard = _shard_of(hash);
+    req.key = &key;
+    req.hash = hash;
+    req.out = &value;
+    return _call(req);
+}
+
+// See MapBasedGlobalLockImpl.h
+bool PerCoreStorage::Get(const std::string &key, size_t hash, Value &value) {
+    Request req;
+    req.op = Op::Get;
+    req.shard = _shard_of(hash);
+    req.key = &key;
+    req.hash = hash;
+    req.out_value = &value;
+    return _call(req);
+}
+
+// See MapBasedGlobalLockImpl.h
+bool PerCoreStorage::Append(const std::string &key, size_t hash, const std::string &data) {
+    Request req;
+    req.op = Op::Append;
+    req.shard = _shard_of(hash);
+    req.key = &key;
+    req.hash = hash;
+    req.value = &data;
+    return _call(req);
+}
+
+// See MapBasedGlobalLockImpl.h
+bool PerCoreStorage::Prepend(const std::string &key, size_t hash, const std::string &data) {
+    Request req;
+    req.op = Op::Prepend;
+    req.shard = _shard_of(hash);
+    req.key = &key;
+    req.hash = hash;
+    req.value = &data;
+    return _call(req);
+}
+
+// See MapBasedGlobalLockImpl.h
+CounterStatus PerCoreStorage::Increment(const std::string &key, size_t hash, uint64_t delta, uint64_t &value) {
+    Request req;
+    req.op = Op::Increment;
+    req.shard = _shard_of(hash);
+    req.key = &key;
+    req.hash = hash;
+    req.delta = delta;
+    _call(req);
+    value = req.counter;
+    return req.status;
+}
+
+// See MapBasedGlobalLockImpl.h
+CounterStatus PerCoreStorage::Decrement(const std::string &key, size_t hash, uint64_t delta, uint64_t &value) {
+    Request req;
+    req.op = Op::Decrement;
+    req.shard = _shard_of(hash);
+    req.key = &key;
+    req.hash = hash;
+    req.delta = delta;
+    _call(req);
+    value = req.counter;
+    return req.status;
+}
+
+// See MapBasedGlobalLockImpl.h
+CasStatus PerCoreStorage::CompareAndSet(const std::string &key, size_t hash, Value value, uint64_t version,
+                                        uint32_t expire_at) {
+    Request req;
+    req.op = Op::CompareAndSet;
+    req.shard = _shard_of(hash);
+    req.key = &key;
+    req.hash = hash;
+    req.owned = &value;
+    req.version = version;
+    req.expire_at = expire_at;
+    _call(req);
+    return req.cas;
+}
+
+// See MapBasedGlobalLockImpl.h
+bool PerCoreStorage::Touch(const std::string &key, size_t hash, uint32_t expire_at) {
+    Request req;
+    req.op = Op::Touch;
+    req.shard = _shard_of(hash);
+    req.key = &key;
+    req.hash = hash;
+    req.expire_at = expire_at;
+    return _call(req);
+}
+
+// See MapBasedGlobalLockImpl.h
+bool PerCoreStorage::GetAndTouch(const std::string &key, size_t hash, uint32_t expire_at, Value &value,
+                                 uint64_t &version) {
+    Request req;
+    req.op = Op::Touch;
+    req.shard = _shard_of(hash);
+    req.key = &key;
+    req.hash = hash;
+    req.expire_at = expire_at;
+    req.out_value = &value;
+    bool result = _call(req);
+    version = req.version;
+    return result;
+}
+
+// See MapBasedGlobalLockImpl.h
+void PerCoreStorage::FlushAll(uint32_t at) {
+    // Flush only bumps atomic generations of the shard, so it doesn't need to be handed over to the owner
+    for (auto &shard : _shards) {
+        shard->FlushAll(at);
+    }
+}
+
+// See MapBasedGlobalLockImpl.h
+void PerCoreStorage::FlushNamespace(const std::string &ns) {
+    for (auto &shard : _shards) {
+        shard->FlushNamespace(ns);
+    }
+}
+
+// See MapBasedGlobalLockImpl.h
+void PerCoreStorage::GetStats(StorageStats &stats) {
+    StorageStats total;
+    for (size_t i = 0; i < _shards.size(); i++) {
+        StorageStats shard_stats;
+        Request req;
+        req.op = Op::Stats;
+        req.shard = i;
+        req.stats = &shard_stats;
+        _call(req);
+
+        total.get_hits += shard_stats.get_hits;
+        total.get_misses += shard_stats.get_misses;
+        total.evictions += shard_stats.evictions;
+        total.curr_items += shard_stats.curr_items;
+        total.bytes += shard_stats.bytes;
+        total.limit_maxbytes += shard_stats.limit_maxbytes;
+    }
+    stats = total;
+}
+
+// See PerCoreStorage.h
+int PerCoreStorage::Attach(size_t core) {
+    if (current_core != nullptr || core >= _cores.Size() || Concurrency::CoreLocal<Core>::Current() != core) {
+        return -1;
+    }
+    Core &c = _cores.Get(core);
+    if (c.shards.empty() || c.attached.exchange(true)) {
+        // Core has nothing to serve or it is taken by other thread already
+        return -1;
+    }
+
+    // Own thread serves whatever is in the mailbox and leaves, from now on producers wake attached thread up
+    c.running.store(false);
+    c.state.store(kAwake);
+    futex_wake(c.state);
+    c.owner.join();
+
+    current_core = &c;
+    Serve();
+    return c.event_fd;
+}
+
+// See PerCoreStorage.h
+void PerCoreStorage::Serve() {
+    Core &c = *static_cast<Core *>(current_core);
+    eventfd_t count;
+    eventfd_read(c.event_fd, &count);
+
+    c.state.store(kAwake);
+    for (;;) {
+        _drain(c);
+
+        // Same as the own thread going to sleep: either producer sees kSleeping and writes to the descriptor or we
+        // see its request
+        c.state.store(kSleeping);
+        std::atomic_thread_fence(std::memory_order_seq_cst);
+        if (c.mailbox.Empty()) {
+            break;
+        }
+        c.state.store(kAwake);
+    }
+    _sweep(c);
+}
+
+// See PerCoreStorage.h
+void PerCoreStorage::Detach() {
+    if (current_core == nullptr) {
+        return;
+    }
+    Core &c = *static_cast<Core *>(current_core);
+    current_core = nullptr;
+
+    // Requests pushed from now on wake up own thread, it serves the mailbox before it goes to sleep anyway
+    c.attached.store(false);
+    c.state.store(kAwake);
+    c.running.store(true);
+    c.owner = std::thread(&PerCoreStorage::_run, this, c.id);
+}
+
+size_t PerCoreStorage::_multi_get(const std::vector<std::string> &keys, const std::vector<size_t> &hashes,
+                                  std::vector<Value> &values, std::vector<uint64_t> *versions) {
+    values.assign(keys.size(), Value());
+    ShardBatch batch(hashes, _shards.size(), [this](size_t hash) { return _shard_of(hash); });
+
+    // All shards get their part of the batch before caller starts to wait, so owners serve them in parallel
+    std::unique_ptr<Request[]> reqs(new Request[_shards.size()]);
+    for (size_t i = 0; i < _shards.size(); i++) {
+        Request &req = reqs[i];
+        req.op = Op::MultiGet;
+        req.shard = i;
+        req.keys = &keys;
+        req.hashes = &hashes;
+        req.at = batch.At(i);
+        req.count = batch.Size(i);
+        req.values = &values;
+        req.versions = versions;
+        req.found = 0;
+        if (req.count > 0) {
+            _submit(req);
+        }
+    }
+
+    size_t found = 0;
+    for (size_t i = 0; i < _shards.size(); i++) {
+        if (reqs[i].count > 0) {
+            _wait(reqs[i]);
+            found += reqs[i].found;
+        }
+    }
+    return found;
+}
+
+bool PerCoreStorage::_call(Request &req) {
+    _submit(req);
+    return _wait(req);
+}
+
+void PerCoreStorage::_submit(Request &req) {
+    Core &core = _cores.Get(_owners[req.shard]);
+    if (current_core == &core) {
+        _execute(req);
+        req.done.store(kDone, std::memory_order_relaxed);
+        return;
+    }
+
+    req.done.store(kPending, std::memory_order_relaxed);
+    core.mailbox.Push(&req);
+    // Pairs with the fence of the owner going to sleep: either owner sees request or we see it sleeping
+    std::atomic_thread_fence(std::memory_order_seq_cst);
+    if (core.state.exchange(kAwake) == kSleeping) {
+        if (core.attached.load()) {
+            eventfd_write(core.event_fd, 1);
+        } else {
+            futex_wake(core.state);
+        }
+    }
+}
+
+bool PerCoreStorage::_wait(Request &req) {
+    if (current_core != nullptr) {
+        // Thread serving the other core could be waiting for this one, so caller never sleeps and serves own
+        // mailbox meanwhile
+        Core &own = *static_cast<Core *>(current_core);
+        while (req.done.load(std::memory_order_acquire) != kDone) {
+            if (!_drain(own)) {
+                cpu_relax();
+            }
+        }
+        return req.result;
+    }
+
+    for (int i = 0; i < kSpins; i++) {
+        if (req.done.load(std::memory_order_acquire) == kDone) {
+            return req.result;
+        }
+        cpu_relax();
+    }
+
+    int expected = kPending;
+    if (req.done.compare_exchange_strong(expected, kWaiting, std::memory_order_acq_rel)) {
+        do {
+            futex_wait(req.done, kWaiting);
+        } while (req.done.load(std::memory_order_acquire) != kDone);
+    }
+    return req.result;
+}
+
+void PerCoreStorage::_execute(Request &req) {
+    CacheBase &shard = *_shards[req.shard];
+    switch (req.op) {
+    case Op::Put:
+        req.result = req.owned != nullptr ? shard.Put(*req.key, req.hash, std::move(*req.owned), req.expire_at)
+                                          : shard.Put(*req.key, req.hash, *req.value, req.expire_at);
+        break;
+    case Op::PutIfAbsent:
+        req.result = req.owned != nullptr
+                         ? shard.PutIfAbsent(*req.key, req.hash, std::move(*req.owned), req.expire_at)
+                         : shard.PutIfAbsent(*req.key, req.hash, *req.value, req.expire_at);
+        break;
+    case Op::Set:
+        req.result = req.owned != nullptr ? shard.Set(*req.key, req.hash, std::move(*req.owned), req.expire_at)
+                                          : shard.Set(*req.key, req.hash, *req.value, req.expire_at);
+        break;
+    case Op::Delete:
+        req.result = shard.Delete(*req.key, req.hash);
+        break;
+    case Op::Get:
+        req.result = req.out_value != nullptr ? shard.Get(*req.key, req.hash, *req.out_value)
+                                              : shard.Get(*req.key, req.hash, *req.out);
+        break;
+    case Op::Append:
+        req.result = shard.Append(*req.key, req.hash, *req.value);
+        break;
+    case Op::Prepend:
+        req.result = shard.Prepend(*req.key, req.hash, *req.value);
+        break;
+    case Op::Increment:
+        req.status = shard.Increment(*req.key, req.hash, req.delta, req.counter);
+        req.result = req.status == CounterStatus::Done;
+        break;
+    case Op::Decrement:
+        req.status = shard.Decrement(*req.key, req.hash, req.delta, req.counter);
+        req.result = req.status == CounterStatus::Done;
+        break;
+    case Op::CompareAndSet:
+        req.cas = shard.CompareAndSet(*req.key, req.hash, std::move(*req.owned), req.version, req.expire_at);
+        req.result = req.cas == CasStatus::Stored;
+        break;
+    case Op::Touch:
+        req.result = req.out_value != nullptr
+                         ? shard.GetAndTouch(*req.key, req.hash, req.expire_at, *req.out_value, req.version)
+                         : shard.Touch(*req.key, req.hash, req.expire_at);
+        break;
+    case Op::MultiGet:
+        req.found = shard.GetMany(*req.keys, *req.hashes, req.at, req.count, *req.values, req.versions);
+        req.result = true;
+        break;
+    case Op::Stats:
+        shard.GetStats(*req.stats);
+        req.result = true;
+        break;
+    }
+}
+
+bool PerCoreStorage::_drain(Core &c) {
+    bool any = false;
+    for (;;) {
+        Concurrency::MPSCQueue::Node *node = c.mailbox.Pop();
+        if (node != nullptr) {
+            Request &req = *static_cast<Request *>(node);
+            _execute(req);
+            // Caller could return right after the store, so request isn't touched after it
+            if (req.done.exchange(kDone, std::memory_order_acq_rel) == kWaiting) {
+                futex_wake(req.done);
+            }
+            any = true;
+            continue;
+        }
+
+        if (!c.mailbox.Empty()) {
+            // Some producer is in the middle of push
+            cpu_relax();
+            continue;
+        }
+        return any;
+    }
+}
+
+void PerCoreStorage::_sweep(Core &c) {
+    auto now = std::chrono::steady_clock::now();
+    if (c.more_expired || now >= c.next_sweep) {
+        c.more_expired = false;
+        for (size_t shard : c.shards) {
+            c.more_expired |= _shards[shard]->Sweep();
+        }
+        c.next_sweep = now + std::chrono::milliseconds(kSweepPeriodMs);
+    }
+}
+
+void PerCoreStorage::_run(size_t core) {
+    cpu_set_t cpus;
+    CPU_ZERO(&cpus);
+    CPU_SET(core, &cpus);
+    pthread_setaffinity_np(pthread_self(), sizeof(cpus), &cpus);
+
+    Core &c = _cores.Get(core);
+    current_core = &c;
+
+    struct timespec period;
+    period.tv_sec = 0;
+    period.tv_nsec = kSweepPeriodMs * 1000 * 1000;
+
+    for (;;) {
+        _drain(c);
+        if (!c.running.load()) {
+            break;
+        }
+
+        if (!c.more_expired) {
+            c.state.store(kSleeping);
+            std::atomic_thread_fence(std::memory_order_seq_cst);
+            if (c.mailbox.Empty() && c.running.load()) {
+                futex_wait(c.state, kSleeping, &period);
+            }
+            c.state.store(kAwake);
+        }
+
+        // Idle, so it is time for maintenance
+        _sweep(c);
+    }
+    current_core = nullptr;
+}
+
+} // namespace Backend
+} // namespace Afina
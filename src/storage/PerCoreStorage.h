@@ -0,0 +1,291 @@
+#ifndef AFINA_STORAGE_PER_CORE_STORAGE_H
+#define AFINA_STORAGE_PER_CORE_STORAGE_H
+
+#include <atomic>
+#include <chrono>
+#include <functional>
+#include <memory>
+#include <string>
+#include <thread>
+#include <vector>
+
+#include <afina/Hash.h>
+#include <afina/Storage.h>
+#include <afina/concurrency/CoreLocal.h>
+#include <afina/concurrency/MPSCQueue.h>
+
+#include "CacheBase.h"
+
+namespace Afina {
+namespace Backend {
+
+/**
+ * # Shared nothing storage
+ * Every core process is allowed to run on gets an owner thread pinned to it, shards are spread over the cores
+ * and each shard is touched by its owner thread only, so shards need no locks and their memory stays in the
+ * cache of a single core. Request for a shard is handed off to its owner through the lock-free mailbox of the
+ * core and caller waits for the result. Requests issued by the owner thread itself run in place.
+ *
+ * Hand off costs a round trip between cores, so thread serving clients could take the core it is pinned to
+ * over, see Attach: own thread of the core stops and the attached thread serves the mailbox from its event loop
+ * once the descriptor of the core is readable. Requests of the clients to the shards of that core run in place
+ * then, with no hand off at all. While attached thread waits for other core it keeps serving own mailbox, since
+ * thread attached to that core could be waiting for it at the same time.
+ *
+ * Owner threads also reclaim expired entries of their shards once they are idle for 100 ms. Threads live as
+ * long as the storage, so it serves requests before Start and after Stop as well. Core goes back to its own
+ * thread once attached thread detaches.
+ *
+ * Number of shards is the number of cores rounded up to the power of two, shard is selected by the mask of
+ * the key hash like in StripedLockLRU.
+ *
+ * That IS thread safe implementation!!
+ */
+class PerCoreStorage : public Afina::Storage {
+public:
+    // Creates shard which stores at most given number of bytes, shard doesn't need to be thread safe
+    using ShardFactory = std::function<CacheBase *(size_t)>;
+
+    PerCoreStorage(size_t max_size = 1024);
+    PerCoreStorage(size_t max_size, ShardFactory make_shard);
+    ~PerCoreStorage();
+
+    // Implements Afina::Storage interface
+    bool Put(const std::string &key, const std::string &value, uint32_t expire_at = 0) override {
+        return Put(key, Hash(key), value, expire_at);
+    }
+
+    // Implements Afina::Storage interface
+    bool PutIfAbsent(const std::string &key, const std::string &value, uint32_t expire_at = 0) override {
+        return PutIfAbsent(key, Hash(key), value, expire_at);
+    }
+
+    // Implements Afina::Storage interface
+    bool Set(const std::string &key, const std::string &value, uint32_t expire_at = 0) override {
+        return Set(key, Hash(key), value, expire_at);
+    }
+
+    // Implements Afina::Storage interface
+    bool Delete(const std::string &key) override { return Delete(key, Hash(key)); }
+
+    // Implements Afina::Storage interface
+    bool Get(const std::string &key, std::string &value) override { return Get(key, Hash(key), value); }
+
+    // Implements Afina::Storage interface
+    bool Put(const std::string &key, size_t hash, const std::string &value, uint32_t expire_at = 0) override;
+
+    // Implements Afina::Storage interface
+    bool PutIfAbsent(const std::string &key, size_t hash, const std::string &value, uint32_t expire_at = 0) override;
+
+    // Implements Afina::Storage interface
+    bool Set(const std::string &key, size_t hash, const std::string &value, uint32_t expire_at = 0) override;
+
+    // Implements Afina::Storage interface
+    bool Delete(const std::string &key, size_t hash) override;
+
+    // Implements Afina::Storage interface
+    bool Get(const std::string &key, size_t hash, std::string &value) override;
+
+    // Implements Afina::Storage interface
+    bool Put(const std::string &key, size_t hash, Value value, uint32_t expire_at = 0) override;
+
+    // Implements Afina::Storage interface
+    bool PutIfAbsent(const std::string &key, size_t hash, Value value, uint32_t expire_at = 0) override;
+
+    // Implements Afina::Storage interface
+    bool Set(const std::string &key, size_t hash, Value value, uint32_t expire_at = 0) override;
+
+    // Implements Afina::Storage interface
+    bool Get(const std::string &key, size_t hash, Value &value) override;
+
+    // Implements Afina::Storage interface
+    bool Append(const std::string &key, size_t hash, const std::string &data) override;
+
+    // Implements Afina::Storage interface
+    bool Prepend(const std::string &key, size_t hash, const std::string &data) override;
+
+    // Implements Afina::Storage interface
+    CounterStatus Increment(const std::string &key, size_t hash, uint64_t delta, uint64_t &value) override;
+
+    // Implements Afina::Storage interface
+    CounterStatus Decrement(const std::string &key, size_t hash, uint64_t delta, uint64_t &value) override;
+
+    // Implements Afina::Storage interface
+    size_t MultiGet(const std::vector<std::string> &keys, const std::vector<size_t> &hashes,
+                    std::vector<Value> &values) override {
+        return _multi_get(keys, hashes, values, nullptr);
+    }
+
+    // Implements Afina::Storage interface
+    size_t MultiGets(const std::vector<std::string> &keys, const std::vector<size_t> &hashes,
+                     std::vector<Value> &values, std::vector<uint64_t> &versions) override {
+        versions.assign(keys.size(), 0);
+        return _multi_get(keys, hashes, values, &versions);
+    }
+
+    // Implements Afina::Storage interface
+    CasStatus CompareAndSet(const std::string &key, size_t hash, Value value, uint64_t version,
+                            uint32_t expire_at = 0) override;
+
+    // Implements Afina::Storage interface
+    bool Touch(const std::string &key, size_t hash, uint32_t expire_at) override;
+
+    // Implements Afina::Storage interface
+    bool GetAndTouch(const std::string &key, size_t hash, uint32_t expire_at, Value &value,
+                     uint64_t &version) override;
+
+    // Implements Afina::Storage interface
+    void FlushAll(uint32_t at = 0) override;
+
+    // Implements Afina::Storage interface
+    void FlushNamespace(const std::string &ns) override;
+
+    // Implements Afina::Storage interface
+    void GetStats(StorageStats &stats) override;
+
+    // Implements Afina::Storage interface
+    int Attach(size_t core) override;
+
+    // Implements Afina::Storage interface
+    void Serve() override;
+
+    // Implements Afina::Storage interface
+    void Detach() override;
+
+private:
+    enum class Op : uint8_t {
+        Put,
+        PutIfAbsent,
+        Set,
+        Delete,
+        Get,
+        Append,
+        Prepend,
+        Increment,
+        Decrement,
+        CompareAndSet,
+        Touch,
+        MultiGet,
+        Stats
+    };
+
+    // Operation on a shard, lives on the stack of the caller until owner has done it
+    struct Request : Concurrency::MPSCQueue::Node {
+        Op op;
+        size_t shard;
+        const std::string *key;
+        size_t hash;
+        uint32_t expire_at;
+
+        // Value to write, either copied from the string or given away with the handle
+        const std::string *value = nullptr;
+        Value *owned = nullptr;
+
+        // Output of Get, Touch and Stats, Get fills either the string or the handle, Touch fills the handle if
+        // it is given
+        std::string *out = nullptr;
+        Value *out_value = nullptr;
+        StorageStats *stats;
+
+        // Subset of the MultiGet batch owned by the shard, see CacheBase::GetMany
+        const std::vector<std::string> *keys;
+        const std::vector<size_t> *hashes;
+        const size_t *at;
+        size_t count;
+        std::vector<Value> *values;
+        std::vector<uint64_t> *versions = nullptr;
+
+        // Counter update, delta in and the new value out
+        uint64_t delta;
+        uint64_t counter;
+        CounterStatus status;
+
+        // Version expected by compare and set or the one read by touch, outcome of compare and set
+        uint64_t version;
+        CasStatus cas;
+
+        bool result;
+        size_t found;
+
+        // One of kPending, kWaiting, kDone, caller waits for kDone on futex once it is tired of spinning
+        std::atomic<int> done;
+    };
+
+    // Everything owned by a single core
+    struct Core {
+        Concurrency::MPSCQueue mailbox;
+
+        // kAwake or kSleeping, owner sleeps on futex until somebody puts request into the empty mailbox
+        std::atomic<int> state;
+        std::atomic<bool> running;
+
+        // Core is served by the attached thread instead of the own one, the attached thread is woken up by
+        // event_fd instead of futex
+        std::atomic<bool> attached;
+        int event_fd;
+
+        // When expired entries are reclaimed next time and whether the last sweep has left some of them, touched
+        // only by the thread serving the core
+        std::chrono::steady_clock::time_point next_sweep;
+        bool more_expired;
+
+        size_t id;
+
+        // Shards owned by this core
+        std::vector<size_t> shards;
+        std::thread owner;
+    };
+
+    static constexpr int kPending = 0;
+    static constexpr int kWaiting = 1;
+    static constexpr int kDone = 2;
+
+    static constexpr int kAwake = 0;
+    static constexpr int kSleeping = 1;
+
+    // Splits the batch between shards, versions are retrived as well unless it is nullptr
+    size_t _multi_get(const std::vector<std::string> &keys, const std::vector<size_t> &hashes,
+                      std::vector<Value> &values, std::vector<uint64_t> *versions);
+
+    // Runs request by the owner of its shard, returns its result
+    bool _call(Request &req);
+
+    // Hands request over to the owner of its shard, request is done right away if caller is the owner
+    void _submit(Request &req);
+
+    // Waits until submitted request is done, returns its result
+    bool _wait(Request &req);
+
+    // Runs request on the shard, only owner thread of the shard could call it
+    void _execute(Request &req);
+
+    // Executes requests of the mailbox until it is empty, returns false if there were none. Only thread serving
+    // the core could call it
+    bool _drain(Core &c);
+
+    // Reclaims expired entries of the core shards if it is time to, only thread serving the core could call it
+    void _sweep(Core &c);
+
+    // Own thread of the given core
+    void _run(size_t core);
+
+    inline size_t _shard_of(size_t hash) const { return (hash >> 32) & _shard_mask; }
+
+    // Number of shards minus one, number of shards is a power of two
+    size_t _shard_mask;
+
+    std::vector<std::unique_ptr<CacheBase>> _shards;
+
+    // Core which owns each shard
+    std::vector<size_t> _owners;
+
+    // Cores which have owner thread, the ones process is allowed to run on
+    std::vector<size_t> _active;
+
+    Concurrency::CoreLocal<Core> _cores;
+};
+
+} // namespace Backend
+} // namespace Afina
+
+#endif // AFINA_STORAGE_PER_CORE_STORAGE_H
@@ -0,0 +1,91 @@
+#ifndef AFINA_STORAGE_READ_BUFFER_H
+#define AFINA_STORAGE_READ_BUFFER_H
+
+#include <atomic>
+#include <cstddef>
+#include <cstdint>
+
+#include "Entry.h"
+
+namespace Afina {
+namespace Backend {
+
+/**
+ * # Lossy buffer of cache hits
+ * Readers record entries they have hit instead of reordering the cache, whoever holds the cache exclusively
+ * replays them later in batch. Buffer is split into stripes placed in separate cache lines, each thread uses its
+ * own stripe, so recording is a single CAS on a line shared by few threads. Once stripe is full new hits are
+ * dropped until it is drained: eviction order becomes approximate, but readers never wait.
+ *
+ * Record must be called while cache can't be modified (i.e under shared lock), Drain - while nobody records
+ * (i.e under exclusive lock), so recorded entries are still alive once drained as long as every modification
+ * drains the buffer first.
+ */
+class ReadBuffer {
+public:
+    ReadBuffer() {
+        for (size_t i = 0; i < kStripes; i++) {
+            _stripes[i].writes.store(0, std::memory_order_relaxed);
+            _stripes[i].reads = 0;
+        }
+    }
+
+    ReadBuffer(const ReadBuffer &) = delete;
+    ReadBuffer &operator=(const ReadBuffer &) = delete;
+
+    /**
+     * Records hit of the entry, returns false once stripe of the current thread is full and should be drained
+     */
+    inline bool Record(Entry *node) {
+        Stripe &stripe = _stripes[_stripe()];
+        uint32_t writes = stripe.writes.load(std::memory_order_relaxed);
+        do {
+            if (writes - stripe.reads >= kSlots) {
+                // Lost hit, the entry just stays where it was
+                return false;
+            }
+        } while (!stripe.writes.compare_exchange_weak(writes, writes + 1, std::memory_order_relaxed));
+
+        stripe.slots[writes % kSlots] = node;
+        return writes + 1 - stripe.reads < kSlots;
+    }
+
+    /**
+     * Calls replay for every recorded entry and empties the buffer
+     */
+    template <typename F> void Drain(F replay) {
+        for (size_t i = 0; i < kStripes; i++) {
+            Stripe &stripe = _stripes[i];
+            uint32_t writes = stripe.writes.load(std::memory_order_relaxed);
+            for (; stripe.reads != writes; stripe.reads++) {
+                replay(*stripe.slots[stripe.reads % kSlots]);
+            }
+        }
+    }
+
+private:
+    static constexpr size_t kStripes = 16;
+    static constexpr size_t kSlots = 32;
+
+    struct Stripe {
+        std::atomic<uint32_t> writes;
+        // Changed only by Drain, readers never see it changing
+        uint32_t reads;
+        Entry *slots[kSlots];
+        char pad[64 - (sizeof(std::atomic<uint32_t>) + sizeof(uint32_t)) % 64];
+    };
+
+    // Threads get stripes round robin on their first use
+    static inline size_t _stripe() {
+        static std::atomic<size_t> next(0);
+        static thread_local size_t stripe = next.fetch_add(1, std::memory_order_relaxed) % kStripes;
+        return stripe;
+    }
+
+    Stripe _stripes[kStripes];
+};
+
+} // namespace Backend
+} // namespace Afina
+
+#endif // AFINA_STORAGE_READ_BUFFER_H
@@ -0,0 +1,50 @@
+#ifndef AFINA_STORAGE_SHARD_BATCH_H
+#define AFINA_STORAGE_SHARD_BATCH_H
+
+#include <cstddef>
+#include <vector>
+
+namespace Afina {
+namespace Backend {
+
+/**
+ * # Keys of the batch grouped by shard
+ * Counting sort of key indexes by their shard, so sharded storage could hand all keys of the shard to it at once
+ * and take shard lock only once per batch. Order of keys within the shard is preserved.
+ */
+class ShardBatch {
+public:
+    /**
+     * Groups keys by shard_of(hash), which must be less than n_shards
+     */
+    template <typename F> ShardBatch(const std::vector<size_t> &hashes, size_t n_shards, F shard_of)
+        : _offsets(n_shards + 1, 0), _at(hashes.size()) {
+        for (size_t hash : hashes) {
+            _offsets[shard_of(hash) + 1]++;
+        }
+        for (size_t s = 1; s <= n_shards; s++) {
+            _offsets[s] += _offsets[s - 1];
+        }
+
+        std::vector<size_t> next(_offsets.begin(), _offsets.end() - 1);
+        for (size_t i = 0; i < hashes.size(); i++) {
+            _at[next[shard_of(hashes[i])]++] = i;
+        }
+    }
+
+    // Number of keys of the shard
+    inline size_t Size(size_t shard) const { return _offsets[shard + 1] - _offsets[shard]; }
+
+    // Indexes of the shard keys in the batch
+    inline const size_t *At(size_t shard) const { return _at.data() + _offsets[shard]; }
+
+private:
+    // Keys of shard s are _at[_offsets[s]] ... _at[_offsets[s + 1] - 1]
+    std::vector<size_t> _offsets;
+    std::vector<size_t> _at;
+};
+
+} // namespace Backend
+} // namespace Afina
+
+#endif // AFINA_STORAGE_SHARD_BATCH_H
@@ -1,12 +1,9 @@
 #ifndef AFINA_STORAGE_SIMPLE_LRU_H
 #define AFINA_STORAGE_SIMPLE_LRU_H
 
-#include <map>
-#include <memory>
-#include <mutex>
 #include <string>
 
-#include <afina/Storage.h>
+#include "CacheBase.h"
 
 namespace Afina {
 namespace Backend {
@@ -15,68 +12,31 @@ namespace Backend {
 * # Map based implementation
 * That is NOT thread safe implementaiton!!
 */
-class SimpleLRU : public Afina::Storage {
+class SimpleLRU : public CacheBase {
 public:
-    SimpleLRU(size_t max_size = 1024) : _max_size(max_size), _cur_size(0) {
-        _lru_head = new lru_node({"", ""});
-        _lru_head->prev = _lru_head;
-        _lru_head->next.reset(_lru_head);
-    }
-
-    ~SimpleLRU() {
-        _lru_index.clear();
-        auto node = _lru_head->next.get();
-        while (node != _lru_head) {
-            std::swap(node->prev, node->next->prev);
-            std::swap(node->next, node->next->prev->next);
-            node->next.reset();
-            node = _lru_head->prev;
-        }
-        _lru_head->next.reset();
-    }
+    SimpleLRU(size_t max_size = 1024) : CacheBase(max_size) { _lru_head.make_head(); }
+    ~SimpleLRU() {}
 
-    // Implements Afina::Storage interface
-    bool Put(const std::string &key, const std::string &value) override;
+protected:
+    // See CacheBase.h
+    void _on_insert(Entry &node) override { node.link_before(*_lru_head.next); }
 
-    // Implements Afina::Storage interface
-    bool PutIfAbsent(const std::string &key, const std::string &value) override;
-
-    // Implements Afina::Storage interface
-    bool Set(const std::string &key, const std::string &value) override;
+    // See CacheBase.h
+    void _on_access(Entry &node) override {
+        node.unlink();
+        node.link_before(*_lru_head.next);
+    }
 
-    // Implements Afina::Storage interface
-    bool Delete(const std::string &key) override;
+    // See CacheBase.h
+    void _on_remove(Entry &node) override { node.unlink(); }
 
-    // Implements Afina::Storage interface
-    bool Get(const std::string &key, std::string &value) override;
+    // See CacheBase.h
+    Entry *_victim() override { return _lru_head.prev; }
 
 private:
-    // LRU cache node
-    using lru_node = struct lru_node {
-        const std::string key;
-        std::string value;
-        lru_node* prev;
-        std::unique_ptr<lru_node> next;
-    };
-
-    // Maximum number of bytes could be stored in this cache.
-    // i.e all (keys+values) must be less the _max_size
-    std::size_t _max_size;
-    std::size_t _cur_size;
-
-    // Main storage of lru_nodes, elements in this list ordered descending by "freshness": in the head
-    // element that wasn't used for longest time.
-    //
-    // List owns all nodes
-    lru_node* _lru_head;
-
-    // Index of nodes from list above, allows fast random access to elements by lru_node#key
-    std::map<std::reference_wrapper<const std::string>, std::reference_wrapper<lru_node>, std::less<std::string>> _lru_index;
-
-
-    void _set_node(lru_node& node, const std::string &value);
-    void _add_node(const std::string &key, const std::string &value);
-    void _free_mem(size_t size);
+    // Main storage of entries, elements in this list ordered descending by "freshness": next to
+    // the head is the most recent one, previous to the head - element that wasn't used for longest time.
+    Entry _lru_head;
 };
 
 } // namespace Backend
@@ -0,0 +1,106 @@
+#include "SlabAllocator.h"
+
+#include <algorithm>
+#include <cassert>
+#include <cstdlib>
+#include <new>
+
+namespace Afina {
+namespace Backend {
+
+constexpr uint32_t SlabAllocator::kLargeClass;
+constexpr size_t SlabAllocator::kHeaderSize;
+
+// See SlabAllocator.h
+SlabAllocator::SlabAllocator(size_t page_size) : _page_size(page_size) {
+    assert((page_size & (page_size - 1)) == 0 && page_size > 2 * kHeaderSize);
+
+    size_t max_chunk = (_page_size - kHeaderSize) & ~size_t(7);
+    for (size_t size = 64; size < max_chunk; size = ((size + size / 4) + 7) & ~size_t(7)) {
+        _classes.push_back({size, nullptr, nullptr, nullptr});
+    }
+    _classes.push_back({max_chunk, nullptr, nullptr, nullptr});
+
+    _large_head.prev = &_large_head;
+    _large_head.next = &_large_head;
+}
+
+// See SlabAllocator.h
+SlabAllocator::~SlabAllocator() {
+    for (Page *page : _pages) {
+        std::free(page);
+    }
+
+    while (_large_head.next != &_large_head) {
+        Page *page = _large_head.next;
+        _large_head.next = page->next;
+        std::free(page);
+    }
+}
+
+// See SlabAllocator.h
+void *SlabAllocator::Allocate(size_t size, size_t &capacity) {
+    auto it = std::lower_bound(_classes.begin(), _classes.end(), size,
+                               [](const SizeClass &c, size_t s) { return c.chunk_size < s; });
+
+    // Too large for any class, serve it by the dedicated page
+    if (it == _classes.end()) {
+        Page *page = _new_page(kHeaderSize + size);
+        page->size_class = kLargeClass;
+        page->prev = &_large_head;
+        page->next = _large_head.next;
+        _large_head.next->prev = page;
+        _large_head.next = page;
+
+        capacity = size;
+        return reinterpret_cast<char *>(page) + kHeaderSize;
+    }
+
+    SizeClass &cls = *it;
+    capacity = cls.chunk_size;
+    if (cls.free_list != nullptr) {
+        FreeChunk *chunk = cls.free_list;
+        cls.free_list = chunk->next;
+        return chunk;
+    }
+
+    if (cls.carve_end - cls.carve_begin < ptrdiff_t(cls.chunk_size)) {
+        Page *page = _new_page(_page_size);
+        page->size_class = it - _classes.begin();
+        _pages.push_back(page);
+
+        cls.carve_begin = reinterpret_cast<char *>(page) + kHeaderSize;
+        cls.carve_end = reinterpret_cast<char *>(page) + _page_size;
+    }
+
+    void *result = cls.carve_begin;
+    cls.carve_begin += cls.chunk_size;
+    return result;
+}
+
+// See SlabAllocator.h
+void SlabAllocator::Free(void *ptr) {
+    Page *page = _page_of(ptr);
+    if (page->size_class == kLargeClass) {
+        page->prev->next = page->next;
+        page->next->prev = page->prev;
+        std::free(page);
+        return;
+    }
+
+    SizeClass &cls = _classes[page->size_class];
+    FreeChunk *chunk = static_cast<FreeChunk *>(ptr);
+    chunk->next = cls.free_list;
+    cls.free_list = chunk;
+}
+
+SlabAllocator::Page *SlabAllocator::_new_page(size_t size) {
+    void *page = nullptr;
+    if (posix_memalign(&page, _page_size, size) != 0) {
+        throw std::bad_alloc();
+    }
+    return static_cast<Page *>(page);
+}
+
+} // namespace Backend
+} // namespace Afina
@@ -0,0 +1,106 @@
+#ifndef AFINA_STORAGE_SLAB_ALLOCATOR_H
+#define AFINA_STORAGE_SLAB_ALLOCATOR_H
+
+#include <cstddef>
+#include <cstdint>
+#include <vector>
+
+namespace Afina {
+namespace Backend {
+
+/**
+ * # Size classed memory pool
+ * Memory is taken from the system by pages which are aligned to the page size, each page serves chunks of a single
+ * size class. Size classes grow by 1.25 factor, so internal fragmentation is bounded by 25%. Freed chunks are kept
+ * in per class free lists and never returned to the system until allocator is destroyed.
+ *
+ * Requests that don't fit into a page are served by a dedicated page of the required size.
+ *
+ * That is NOT thread safe implementation!!
+ */
+class SlabAllocator {
+public:
+    /**
+     * @param page_size size of the memory block requested from the system, must be power of 2
+     */
+    SlabAllocator(size_t page_size = 1 << 20);
+    ~SlabAllocator();
+
+    SlabAllocator(const SlabAllocator &) = delete;
+    SlabAllocator &operator=(const SlabAllocator &) = delete;
+
+    /**
+     * Allocates chunk of at least size bytes, chunk is aligned to 8 bytes
+     *
+     * @param size number of bytes requested
+     * @param capacity output parameter, real size of the chunk
+     * @return chunk address, throws std::bad_alloc if system is out of memory
+     */
+    void *Allocate(size_t size, size_t &capacity);
+
+    /**
+     * Returns chunk allocated by this allocator back to the pool
+     */
+    void Free(void *ptr);
+
+    /**
+     * Largest allocation served from the pages, anything larger gets dedicated page which is released
+     * back to the system on Free
+     */
+    inline size_t MaxPooledSize() const { return _classes.back().chunk_size; }
+
+private:
+    // Header placed at the start of every page
+    struct Page {
+        // Index of size class or kLargeClass for dedicated pages
+        uint32_t size_class;
+
+        // List of dedicated pages, used to release them on destruction
+        Page *prev;
+        Page *next;
+    };
+
+    // Free chunk, links itself into free list
+    struct FreeChunk {
+        FreeChunk *next;
+    };
+
+    struct SizeClass {
+        // Size of each chunk
+        size_t chunk_size;
+
+        // Free chunks of this class
+        FreeChunk *free_list;
+
+        // Tail of the latest page that wasn't carved into chunks yet
+        char *carve_begin;
+        char *carve_end;
+    };
+
+    static constexpr uint32_t kLargeClass = UINT32_MAX;
+
+    // Page header size rounded up to keep chunks aligned
+    static constexpr size_t kHeaderSize = (sizeof(Page) + 7) & ~size_t(7);
+
+    inline Page *_page_of(void *ptr) const {
+        return reinterpret_cast<Page *>(reinterpret_cast<uintptr_t>(ptr) & ~uintptr_t(_page_size - 1));
+    }
+
+    Page *_new_page(size_t size);
+
+    size_t _page_size;
+
+    // Size classes ordered by chunk size
+    std::vector<SizeClass> _classes;
+
+    // All pages serving size classes
+    std::vector<Page *> _pages;
+
+    // Dedicated pages
+    Page _large_head;
+};
+
+} // namespace Backend
+} // namespace Afina
+
+#endif // AFINA_STORAGE_SLAB_ALLOCATOR_H
@@ -0,0 +1,59 @@
+#ifndef AFINA_STORAGE_STAT_COUNTER_H
+#define AFINA_STORAGE_STAT_COUNTER_H
+
+#include <atomic>
+#include <cstddef>
+#include <cstdint>
+
+namespace Afina {
+namespace Backend {
+
+/**
+ * # Statistics counter
+ * Counter is split into cells placed in separate cache lines, each thread increments its own cell, so counting
+ * in hot paths doesn't make threads fight for a single cache line. Reading sums all the cells, so it is slow and
+ * not exact while counter is being updated, which is fine for statistics.
+ */
+class StatCounter {
+public:
+    StatCounter() {
+        for (size_t i = 0; i < kCells; i++) {
+            _cells[i].value.store(0, std::memory_order_relaxed);
+        }
+    }
+
+    StatCounter(const StatCounter &) = delete;
+    StatCounter &operator=(const StatCounter &) = delete;
+
+    inline void Add(uint64_t n = 1) { _cells[_cell()].value.fetch_add(n, std::memory_order_relaxed); }
+
+    uint64_t Load() const {
+        uint64_t result = 0;
+        for (size_t i = 0; i < kCells; i++) {
+            result += _cells[i].value.load(std::memory_order_relaxed);
+        }
+        return result;
+    }
+
+private:
+    static constexpr size_t kCells = 16;
+
+    struct Cell {
+        std::atomic<uint64_t> value;
+        char pad[64 - sizeof(std::atomic<uint64_t>)];
+    };
+
+    // Threads get cells round robin on their first use
+    static inline size_t _cell() {
+        static std::atomic<size_t> next(0);
+        static thread_local size_t cell = next.fetch_add(1, std::memory_order_relaxed) % kCells;
+        return cell;
+    }
+
+    Cell _cells[kCells];
+};
+
+} // namespace Backend
+} // namespace Afina
+
+#endif // AFINA_STORAGE_STAT_COUNTER_H
@@ -1,36 +1,160 @@
 #include "StripedLockLRU.h"
 
+#include "ShardBatch.h"
+
 namespace Afina {
 namespace Backend {
 
 // See MapBasedGlobalLockImpl.h
-bool StripedLockLRU::Put(const std::string &key, const std::string &value) {
-    return shards_[get_shard_num(key)]->Put(key, value);
+bool StripedLockLRU::Put(const std::string &key, size_t hash, const std::string &value, uint32_t expire_at) {
+    return shards_[get_shard_num(hash)]->Put(key, hash, value, expire_at);
+}
+
+// See MapBasedGlobalLockImpl.h
+bool StripedLockLRU::PutIfAbsent(const std::string &key, size_t hash,
+                            const std::string &value, uint32_t expire_at) {
+    return shards_[get_shard_num(hash)]->PutIfAbsent(key, hash, value, expire_at);
+}
+
+// See MapBasedGlobalLockImpl.h
+bool StripedLockLRU::Set(const std::string &key, size_t hash, const std::string &value, uint32_t expire_at) {
+    return shards_[get_shard_num(hash)]->Set(key, hash, value, expire_at);
+}
+
+// See MapBasedGlobalLockImpl.h
+bool StripedLockLRU::Delete(const std::string &key, size_t hash) {
+    return shards_[get_shard_num(hash)]->Delete(key, hash);
+}
+
+// See MapBasedGlobalLockImpl.h
+bool StripedLockLRU::Get(const std::string &key, size_t hash, std::string &value) {
+    return shards_[get_shard_num(hash)]->Get(key, hash, value);
+}
+
+// See MapBasedGlobalLockImpl.h
+bool StripedLockLRU::Put(const std::string &key, size_t hash, Value value, uint32_t expire_at) {
+    return shards_[get_shard_num(hash)]->Put(key, hash, std::move(value), expire_at);
+}
+
+// See MapBasedGlobalLockImpl.h
+bool StripedLockLRU::PutIfAbsent(const std::string &key, size_t hash, Value value, uint32_t expire_at) {
+    return shards_[get_shard_num(hash)]->PutIfAbsent(key, hash, std::move(value), expire_at);
+}
+
+// See MapBasedGlobalLockImpl.h
+bool StripedLockLRU::Set(const std::string &key, size_t hash, Value value, uint32_t expire_at) {
+    return shards_[get_shard_num(hash)]->Set(key, hash, std::move(value), expire_at);
+}
+
+// See MapBasedGlobalLockImpl.h
+bool StripedLockLRU::Get(const std::string &key, size_t hash, Value &value) {
+    return shards_[get_shard_num(hash)]->Get(key, hash, value);
+}
+
+// See MapBasedGlobalLockImpl.h
+bool StripedLockLRU::Append(const std::string &key, size_t hash, const std::string &data) {
+    return shards_[get_shard_num(hash)]->Append(key, hash, data);
+}
+
+// See MapBasedGlobalLockImpl.h
+bool StripedLockLRU::Prepend(const std::string &key, size_t hash, const std::string &data) {
+    return shards_[get_shard_num(hash)]->Prepend(key, hash, data);
+}
+
+// See MapBasedGlobalLockImpl.h
+CounterStatus StripedLockLRU::Increment(const std::string &key, size_t hash, uint64_t delta, uint64_t &value) {
+    return shards_[get_shard_num(hash)]->Increment(key, hash, delta, value);
+}
+
+// See MapBasedGlobalLockImpl.h
+CounterStatus StripedLockLRU::Decrement(const std::string &key, size_t hash, uint64_t delta, uint64_t &value) {
+    return shards_[get_shard_num(hash)]->Decrement(key, hash, delta, value);
+}
+
+// See MapBasedGlobalLockImpl.h
+size_t StripedLockLRU::MultiGet(const std::vector<std::string> &keys, const std::vector<size_t> &hashes,
+                                std::vector<Value> &values) {
+    values.assign(keys.size(), Value());
+    ShardBatch batch(hashes, shards_.size(), [this](size_t hash) { return get_shard_num(hash); });
+
+    size_t found = 0;
+    for (size_t i = 0; i < shards_.size(); i++) {
+        if (batch.Size(i) > 0) {
+            found += shards_[i]->GetMany(keys, hashes, batch.At(i), batch.Size(i), values, nullptr);
+        }
+    }
+    return found;
+}
+
+// See MapBasedGlobalLockImpl.h
+size_t StripedLockLRU::MultiGets(const std::vector<std::string> &keys, const std::vector<size_t> &hashes,
+                                 std::vector<Value> &values, std::vector<uint64_t> &versions) {
+    values.assign(keys.size(), Value());
+    versions.assign(keys.size(), 0);
+    ShardBatch batch(hashes, shards_.size(), [this](size_t hash) { return get_shard_num(hash); });
+
+    size_t found = 0;
+    for (size_t i = 0; i < shards_.size(); i++) {
+        if (batch.Size(i) > 0) {
+            found += shards_[i]->GetMany(keys, hashes, batch.At(i), batch.Size(i), values, &versions);
+        }
+    }
+    return found;
+}
+
+// See MapBasedGlobalLockImpl.h
+CasStatus StripedLockLRU::CompareAndSet(const std::string &key, size_t hash, Value value, uint64_t version,
+                                        uint32_t expire_at) {
+    return shards_[get_shard_num(hash)]->CompareAndSet(key, hash, std::move(value), version, expire_at);
+}
+
+// See MapBasedGlobalLockImpl.h
+bool StripedLockLRU::Touch(const std::string &key, size_t hash, uint32_t expire_at) {
+    return shards_[get_shard_num(hash)]->Touch(key, hash, expire_at);
 }
 
 // See MapBasedGlobalLockImpl.h
-bool StripedLockLRU::PutIfAbsent(const std::string &key,
-                            const std::string &value) {
-    return shards_[get_shard_num(key)]->PutIfAbsent(key, value);
+bool StripedLockLRU::GetAndTouch(const std::string &key, size_t hash, uint32_t expire_at, Value &value,
+                                 uint64_t &version) {
+    return shards_[get_shard_num(hash)]->GetAndTouch(key, hash, expire_at, value, version);
 }
 
 // See MapBasedGlobalLockImpl.h
-bool StripedLockLRU::Set(const std::string &key, const std::string &value) {
-    return shards_[get_shard_num(key)]->Set(key, value);
+void StripedLockLRU::FlushAll(uint32_t at) {
+    for (auto &shard : shards_) {
+        shard->FlushAll(at);
+    }
 }
 
 // See MapBasedGlobalLockImpl.h
-bool StripedLockLRU::Delete(const std::string &key) {
-    return shards_[get_shard_num(key)]->Delete(key);
+void StripedLockLRU::FlushNamespace(const std::string &ns) {
+    for (auto &shard : shards_) {
+        shard->FlushNamespace(ns);
+    }
 }
 
 // See MapBasedGlobalLockImpl.h
-bool StripedLockLRU::Get(const std::string &key, std::string &value) {
-    return shards_[get_shard_num(key)]->Get(key, value);
+void StripedLockLRU::GetStats(StorageStats &stats) {
+    StorageStats total;
+    for (auto &shard : shards_) {
+        StorageStats shard_stats;
+        shard->GetStats(shard_stats);
+        total.get_hits += shard_stats.get_hits;
+        total.get_misses += shard_stats.get_misses;
+        total.evictions += shard_stats.evictions;
+        total.curr_items += shard_stats.curr_items;
+        total.bytes += shard_stats.bytes;
+        total.limit_maxbytes += shard_stats.limit_maxbytes;
+    }
+    stats = total;
 }
 
-size_t StripedLockLRU::get_shard_num(const std::string &key) {
-    return std::hash<std::string>{}(key) % shards_.size(); // проверить
+bool StripedLockLRU::sweep_shards() {
+    bool more = false;
+    for (auto &shard : shards_) {
+        more |= shard->Sweep();
+    }
+    return more;
 }
 
 
@@ -1,13 +1,16 @@
 #ifndef AFINA_STORAGE_STRIPED_LOCK_LRU_H
 #define AFINA_STORAGE_STRIPED_LOCK_LRU_H
 
+#include <functional>
 #include <map>
 #include <memory>
 #include <mutex>
 #include <string>
 #include <vector>
 
+#include <afina/Hash.h>
 #include <afina/Storage.h>
+#include "Sweeper.h"
 #include "ThreadSafeSimpleLRU.h"
 
 namespace Afina {
@@ -15,54 +18,163 @@ namespace Backend {
 
 /**
 * # Map based implementation
+* Keys are spread over independent shards, each one is a thread safe cache with its own lock and an equal
+* part of _max_size. Shards are ThreadSafeSimplLRU unless other thread safe cache is given by the factory.
+* Number of shards is rounded up to the power of two, so shard is selected by the mask of the key hash, and
+* the same hash is passed to the shard.
+*
 * That IS thread safe and striped implementation!!
 */
 class StripedLockLRU : public Afina::Storage {
 public:
-    StripedLockLRU(size_t max_size = 1024, size_t n_shards = 4) : _max_size(max_size) {
-        for (size_t i = 0; i < n_shards; ++i) {
-            shards_.emplace_back(new ThreadSafeSimplLRU(_max_size / n_shards));
+    // Creates thread safe shard which stores at most given number of bytes
+    using ShardFactory = std::function<CacheBase *(size_t)>;
+
+    StripedLockLRU(size_t max_size = 1024, size_t n_shards = 4)
+        : StripedLockLRU(max_size, n_shards, [](size_t size) { return new ThreadSafeSimplLRU(size); }) {}
+
+    StripedLockLRU(size_t max_size, size_t n_shards, ShardFactory make_shard)
+        : _max_size(max_size), _sweeper([this]() { return sweep_shards(); }) {
+        size_t n = 1;
+        while (n < n_shards) {
+            n *= 2;
+        }
+        _shard_mask = n - 1;
+        for (size_t i = 0; i < n; ++i) {
+            shards_.emplace_back(make_shard(_max_size / n));
         }
     }
 
     ~StripedLockLRU() {}
 
-    static StripedLockLRU* create_striped_lock_lru(size_t max_size, size_t n_shards) {
+    static StripedLockLRU* create_striped_lock_lru(size_t max_size, size_t n_shards,
+                                                   ShardFactory make_shard = nullptr) {
         if (max_size / n_shards < 8) {
             throw std::runtime_error("Shards are too small.");
         } else if (max_size / n_shards > 1024 * 1024) {
             throw std::runtime_error("Shards are too large.");
+        } else if (make_shard) {
+            return new StripedLockLRU(max_size, n_shards, make_shard);
         } else {
             return new StripedLockLRU(max_size, n_shards);
         }
     }
 
     // Implements Afina::Storage interface
-    bool Put(const std::string &key, const std::string &value) override;
+    void Start() override { _sweeper.Start(); }
+
+    // Implements Afina::Storage interface
+    void Stop() override { _sweeper.Stop(); }
+
+    // Implements Afina::Storage interface
+    bool Put(const std::string &key, const std::string &value, uint32_t expire_at = 0) override {
+        return Put(key, Hash(key), value, expire_at);
+    }
+
+    // Implements Afina::Storage interface
+    bool PutIfAbsent(const std::string &key, const std::string &value, uint32_t expire_at = 0) override {
+        return PutIfAbsent(key, Hash(key), value, expire_at);
+    }
+
+    // Implements Afina::Storage interface
+    bool Set(const std::string &key, const std::string &value, uint32_t expire_at = 0) override {
+        return Set(key, Hash(key), value, expire_at);
+    }
+
+    // Implements Afina::Storage interface
+    bool Delete(const std::string &key) override { return Delete(key, Hash(key)); }
+
+    // Implements Afina::Storage interface
+    bool Get(const std::string &key, std::string &value) override { return Get(key, Hash(key), value); }
+
+    // Implements Afina::Storage interface
+    bool Put(const std::string &key, size_t hash, const std::string &value, uint32_t expire_at = 0) override;
+
+    // Implements Afina::Storage interface
+    bool PutIfAbsent(const std::string &key, size_t hash, const std::string &value, uint32_t expire_at = 0) override;
+
+    // Implements Afina::Storage interface
+    bool Set(const std::string &key, size_t hash, const std::string &value, uint32_t expire_at = 0) override;
+
+    // Implements Afina::Storage interface
+    bool Delete(const std::string &key, size_t hash) override;
+
+    // Implements Afina::Storage interface
+    bool Get(const std::string &key, size_t hash, std::string &value) override;
 
     // Implements Afina::Storage interface
-    bool PutIfAbsent(const std::string &key, const std::string &value) override;
+    bool Put(const std::string &key, size_t hash, Value value, uint32_t expire_at = 0) override;
 
     // Implements Afina::Storage interface
-    bool Set(const std::string &key, const std::string &value) override;
+    bool PutIfAbsent(const std::string &key, size_t hash, Value value, uint32_t expire_at = 0) override;
 
     // Implements Afina::Storage interface
-    bool Delete(const std::string &key) override;
+    bool Set(const std::string &key, size_t hash, Value value, uint32_t expire_at = 0) override;
 
     // Implements Afina::Storage interface
-    bool Get(const std::string &key, std::string &value) override;
+    bool Get(const std::string &key, size_t hash, Value &value) override;
+
+    // Implements Afina::Storage interface
+    bool Append(const std::string &key, size_t hash, const std::string &data) override;
+
+    // Implements Afina::Storage interface
+    bool Prepend(const std::string &key, size_t hash, const std::string &data) override;
+
+    // Implements Afina::Storage interface
+    CounterStatus Increment(const std::string &key, size_t hash, uint64_t delta, uint64_t &value) override;
+
+    // Implements Afina::Storage interface
+    CounterStatus Decrement(const std::string &key, size_t hash, uint64_t delta, uint64_t &value) override;
+
+    // Implements Afina::Storage interface
+    size_t MultiGet(const std::vector<std::string> &keys, const std::vector<size_t> &hashes,
+                    std::vector<Value> &values) override;
+
+    // Implements Afina::Storage interface
+    size_t MultiGets(const std::vector<std::string> &keys, const std::vector<size_t> &hashes,
+                     std::vector<Value> &values, std::vector<uint64_t> &versions) override;
+
+    // Implements Afina::Storage interface
+    CasStatus CompareAndSet(const std::string &key, size_t hash, Value value, uint64_t version,
+                            uint32_t expire_at = 0) override;
+
+    // Implements Afina::Storage interface
+    bool Touch(const std::string &key, size_t hash, uint32_t expire_at) override;
+
+    // Implements Afina::Storage interface
+    bool GetAndTouch(const std::string &key, size_t hash, uint32_t expire_at, Value &value,
+                     uint64_t &version) override;
+
+    // Implements Afina::Storage interface
+    void FlushAll(uint32_t at = 0) override;
+
+    // Implements Afina::Storage interface
+    void FlushNamespace(const std::string &ns) override;
+
+    // Implements Afina::Storage interface
+    void GetStats(StorageStats &stats) override;
 
 private:
     // Shards vector
 
-    std::vector<std::unique_ptr<ThreadSafeSimplLRU>> shards_;
+    std::vector<std::unique_ptr<CacheBase>> shards_;
 
     // Maximum number of bytes could be stored in this cache.
     // i.e all (keys+values) must be less the _max_size
     std::size_t _max_size;
 
-    // Function gets the shard number by the node key
-    size_t get_shard_num(const std::string& key);
+    // Number of shards minus one, number of shards is a power of two
+    size_t _shard_mask;
+
+    // Function gets the shard number by the key hash. Shards take low bits of the hash for their indexes,
+    // so high ones are used here
+    inline size_t get_shard_num(size_t hash) const { return (hash >> 32) & _shard_mask; }
+
+    // Removes a slice of expired entries from every shard, returns true if there could be more
+    bool sweep_shards();
+
+    // One background sweep for all the shards, each shard is locked only for its own slice
+    Sweeper _sweeper;
 };
 
 
@@ -0,0 +1,42 @@
+#include "Sweeper.h"
+
+namespace Afina {
+namespace Backend {
+
+// See Sweeper.h
+void Sweeper::Start() {
+    std::lock_guard<std::mutex> lock(_mutex);
+    if (_running.load()) {
+        return;
+    }
+    _running.store(true);
+    _thread = std::thread(&Sweeper::_run, this);
+}
+
+// See Sweeper.h
+void Sweeper::Stop() {
+    {
+        std::lock_guard<std::mutex> lock(_mutex);
+        if (!_running.load()) {
+            return;
+        }
+        _running.store(false);
+    }
+    _stopped.notify_all();
+    _thread.join();
+}
+
+void Sweeper::_run() {
+    while (_running.load()) {
+        // Let the requests take the storage locks between slices
+        while (_running.load() && _step()) {
+            std::this_thread::yield();
+        }
+
+        std::unique_lock<std::mutex> lock(_mutex);
+        _stopped.wait_for(lock, _period, [this] { return !_running.load(); });
+    }
+}
+
+} // namespace Backend
+} // namespace Afina
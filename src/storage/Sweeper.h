@@ -0,0 +1,54 @@
+#ifndef AFINA_STORAGE_SWEEPER_H
+#define AFINA_STORAGE_SWEEPER_H
+
+#include <atomic>
+#include <chrono>
+#include <condition_variable>
+#include <functional>
+#include <mutex>
+#include <thread>
+
+namespace Afina {
+namespace Backend {
+
+/**
+ * # Background maintenance of the storage
+ * Runs given step in a separate thread once per period. Step is supposed to do a small bounded piece of work
+ * under storage locks and return true if there is more work, in that case it is called again right away, so
+ * locks are released between steps and requests are never blocked for long.
+ */
+class Sweeper {
+public:
+    Sweeper(std::function<bool()> step, std::chrono::milliseconds period = std::chrono::milliseconds(100))
+        : _step(step), _period(period), _running(false) {}
+    ~Sweeper() { Stop(); }
+
+    Sweeper(const Sweeper &) = delete;
+    Sweeper &operator=(const Sweeper &) = delete;
+
+    /**
+     * Starts background thread, does nothing if it is already running
+     */
+    void Start();
+
+    /**
+     * Stops background thread and waits until it finishes current step
+     */
+    void Stop();
+
+private:
+    void _run();
+
+    std::function<bool()> _step;
+    std::chrono::milliseconds _period;
+
+    std::mutex _mutex;
+    std::condition_variable _stopped;
+    std::atomic<bool> _running;
+    std::thread _thread;
+};
+
+} // namespace Backend
+} // namespace Afina
+
+#endif // AFINA_STORAGE_SWEEPER_H
@@ -0,0 +1,267 @@
+#ifndef AFINA_STORAGE_SWISS_TABLE_H
+#define AFINA_STORAGE_SWISS_TABLE_H
+
+#include <cstddef>
+#include <cstdint>
+#include <cstring>
+#include <memory>
+#include <utility>
+
+#ifdef __SSE2__
+#include <emmintrin.h>
+#endif
+
+namespace Afina {
+namespace Backend {
+
+/**
+ * # Open addressing hash index
+ * Swiss table style index of the nodes that are owned by somebody else (i.e LRU list). Table is split into groups
+ * of 16 slots, each slot has one control byte which is either empty/deleted marker or 7 bits of the hash (tag).
+ * Lookup loads the whole group of control bytes at once, compares all tags with a single SIMD instruction and
+ * touches only those nodes whose tag matches. So in the common case lookup costs a control group read plus the
+ * node itself.
+ *
+ * Table doesn't compute hashes, caller must pass hash of the key to every call. Traits must provide:
+ * - static size_t hash(const T *node): hash of the node key, used on rehash
+ * - static bool equal(const T *node, const K &key): if node has given key
+ *
+ * That is NOT thread safe implementation!!
+ */
+template <typename T, typename Traits> class SwissTable {
+public:
+    SwissTable() : _capacity(0), _size(0), _growth_left(0) { _resize(kGroupWidth); }
+
+    SwissTable(const SwissTable &) = delete;
+    SwissTable &operator=(const SwissTable &) = delete;
+
+    /**
+     * Returns node associated with the key or nullptr if there is no such node
+     */
+    template <typename K> T *Find(const K &key, size_t hash) const {
+        size_t group = _h1(hash) & _group_mask();
+        for (size_t step = 1;; step++) {
+            const int8_t *ctrl = &_ctrl[group * kGroupWidth];
+            for (uint32_t mask = _match(ctrl, _h2(hash)); mask != 0; mask &= mask - 1) {
+                T *node = _slots[group * kGroupWidth + __builtin_ctz(mask)];
+                if (Traits::equal(node, key)) {
+                    return node;
+                }
+            }
+            if (_match(ctrl, kEmpty) != 0) {
+                return nullptr;
+            }
+            group = (group + step) & _group_mask();
+        }
+    }
+
+    /**
+     * Brings first control group of the hash and its slots into the cache. Batch of lookups issues it for all
+     * keys before the first Find, so memory latencies of the batch overlap
+     */
+    inline void Prefetch(size_t hash) const {
+        size_t group = _h1(hash) & _group_mask();
+        __builtin_prefetch(&_ctrl[group * kGroupWidth]);
+        __builtin_prefetch(&_slots[group * kGroupWidth]);
+        __builtin_prefetch(&_slots[group * kGroupWidth] + kGroupWidth - 1);
+    }
+
+    /**
+     * Brings nodes whose tag matches in the first group of the hash into the cache, group itself should be
+     * prefetched already
+     */
+    inline void PrefetchNodes(size_t hash) const {
+        size_t group = _h1(hash) & _group_mask();
+        for (uint32_t mask = _match(&_ctrl[group * kGroupWidth], _h2(hash)); mask != 0; mask &= mask - 1) {
+            __builtin_prefetch(_slots[group * kGroupWidth + __builtin_ctz(mask)]);
+        }
+    }
+
+    /**
+     * Adds node into the index. Node with the same key must not be present in the table
+     */
+    void Insert(T *node, size_t hash) {
+        if (_growth_left == 0) {
+            // Tombstones eat growth budget as well, so before grow table check if it is enough to clean them up
+            _resize(_size * 2 < _capacity - _capacity / 8 ? _capacity : _capacity * 2);
+        }
+
+        size_t slot = _find_free(hash);
+        if (_ctrl[slot] == kEmpty) {
+            _growth_left--;
+        }
+        _ctrl[slot] = _h2(hash);
+        _slots[slot] = node;
+        _size++;
+    }
+
+    /**
+     * Removes node associated with the key from index and return it, or nullptr if there is no such node
+     */
+    template <typename K> T *Erase(const K &key, size_t hash) {
+        size_t group = _h1(hash) & _group_mask();
+        for (size_t step = 1;; step++) {
+            int8_t *ctrl = &_ctrl[group * kGroupWidth];
+            for (uint32_t mask = _match(ctrl, _h2(hash)); mask != 0; mask &= mask - 1) {
+                size_t slot = group * kGroupWidth + __builtin_ctz(mask);
+                T *node = _slots[slot];
+                if (Traits::equal(node, key)) {
+                    // If group has an empty slot then no probe sequence ever went past it, so slot could be
+                    // released for good. Otherwise some other node may live further and tombstone is required
+                    if (_match(ctrl, kEmpty) != 0) {
+                        _ctrl[slot] = kEmpty;
+                        _growth_left++;
+                    } else {
+                        _ctrl[slot] = kDeleted;
+                    }
+                    _slots[slot] = nullptr;
+                    _size--;
+                    return node;
+                }
+            }
+            if (_match(ctrl, kEmpty) != 0) {
+                return nullptr;
+            }
+            group = (group + step) & _group_mask();
+        }
+    }
+
+    /**
+     * Puts node into the slot of the one associated with the key, returns node that was replaced or nullptr if
+     * there is no node for the key. Both nodes must have the same hash
+     */
+    template <typename K> T *Replace(const K &key, size_t hash, T *node) {
+        size_t group = _h1(hash) & _group_mask();
+        for (size_t step = 1;; step++) {
+            const int8_t *ctrl = &_ctrl[group * kGroupWidth];
+            for (uint32_t mask = _match(ctrl, _h2(hash)); mask != 0; mask &= mask - 1) {
+                T *&slot = _slots[group * kGroupWidth + __builtin_ctz(mask)];
+                if (Traits::equal(slot, key)) {
+                    std::swap(slot, node);
+                    return node;
+                }
+            }
+            if (_match(ctrl, kEmpty) != 0) {
+                return nullptr;
+            }
+            group = (group + step) & _group_mask();
+        }
+    }
+
+    /**
+     * Removes all nodes from the index, nodes itself are not touched
+     */
+    void Clear() {
+        std::memset(_ctrl.get(), kEmpty, _capacity);
+        _size = 0;
+        _growth_left = _max_load(_capacity);
+    }
+
+    /**
+     * Calls f(T *node) for every node of the index in no particular order, index must not be changed meanwhile
+     */
+    template <typename F> void ForEach(F f) const {
+        for (size_t i = 0; i < _capacity; i++) {
+            if (_ctrl[i] >= 0) {
+                f(_slots[i]);
+            }
+        }
+    }
+
+    inline size_t Size() const { return _size; }
+
+private:
+    static constexpr size_t kGroupWidth = 16;
+    static constexpr int8_t kEmpty = -128;
+    static constexpr int8_t kDeleted = -2;
+
+    // Upper bits of hash selects group to start probe from, lower 7 bits are stored in control byte
+    static inline size_t _h1(size_t hash) { return hash >> 7; }
+    static inline int8_t _h2(size_t hash) { return hash & 0x7F; }
+
+    // Table is never filled more than on 7/8 to keep probe sequences short
+    static inline size_t _max_load(size_t capacity) { return capacity - capacity / 8; }
+
+    inline size_t _group_mask() const { return _capacity / kGroupWidth - 1; }
+
+    // Bit mask of control bytes in the group which are equal to the given one
+    static inline uint32_t _match(const int8_t *ctrl, int8_t value) {
+#ifdef __SSE2__
+        __m128i group = _mm_loadu_si128(reinterpret_cast<const __m128i *>(ctrl));
+        return _mm_movemask_epi8(_mm_cmpeq_epi8(group, _mm_set1_epi8(value)));
+#else
+        uint32_t mask = 0;
+        for (size_t i = 0; i < kGroupWidth; i++) {
+            mask |= uint32_t(ctrl[i] == value) << i;
+        }
+        return mask;
+#endif
+    }
+
+    // Bit mask of empty or deleted control bytes in the group, both has sign bit set
+    static inline uint32_t _match_free(const int8_t *ctrl) {
+#ifdef __SSE2__
+        return _mm_movemask_epi8(_mm_loadu_si128(reinterpret_cast<const __m128i *>(ctrl)));
+#else
+        uint32_t mask = 0;
+        for (size_t i = 0; i < kGroupWidth; i++) {
+            mask |= uint32_t(ctrl[i] < 0) << i;
+        }
+        return mask;
+#endif
+    }
+
+    // First empty or deleted slot on the probe sequence of the given hash
+    size_t _find_free(size_t hash) const {
+        size_t group = _h1(hash) & _group_mask();
+        for (size_t step = 1;; step++) {
+            uint32_t mask = _match_free(&_ctrl[group * kGroupWidth]);
+            if (mask != 0) {
+                return group * kGroupWidth + __builtin_ctz(mask);
+            }
+            group = (group + step) & _group_mask();
+        }
+    }
+
+    // Reallocates table to hold new_capacity slots and rehash all nodes, drops tombstones as well
+    void _resize(size_t new_capacity) {
+        std::unique_ptr<int8_t[]> old_ctrl(std::move(_ctrl));
+        std::unique_ptr<T *[]> old_slots(std::move(_slots));
+        size_t old_capacity = _capacity;
+
+        _ctrl.reset(new int8_t[new_capacity]);
+        _slots.reset(new T *[new_capacity]);
+        _capacity = new_capacity;
+        std::memset(_ctrl.get(), kEmpty, _capacity);
+        _growth_left = _max_load(_capacity) - _size;
+
+        for (size_t i = 0; i < old_capacity; i++) {
+            if (old_ctrl[i] >= 0) {
+                size_t hash = Traits::hash(old_slots[i]);
+                size_t slot = _find_free(hash);
+                _ctrl[slot] = _h2(hash);
+                _slots[slot] = old_slots[i];
+            }
+        }
+    }
+
+    // Control bytes, one per slot
+    std::unique_ptr<int8_t[]> _ctrl;
+
+    // Nodes, table doesn't own them
+    std::unique_ptr<T *[]> _slots;
+
+    // Number of slots, always power of 2 and multiple of group width
+    size_t _capacity;
+
+    // Number of nodes in the table
+    size_t _size;
+
+    // Number of empty slots could be filled before table must be rehashed
+    size_t _growth_left;
+};
+
+} // namespace Backend
+} // namespace Afina
+
+#endif // AFINA_STORAGE_SWISS_TABLE_H
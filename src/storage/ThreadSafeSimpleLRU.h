@@ -1,64 +1,301 @@
 #ifndef AFINA_STORAGE_THREAD_SAFE_SIMPLE_LRU_H
 #define AFINA_STORAGE_THREAD_SAFE_SIMPLE_LRU_H
 
+#include <algorithm>
 #include <map>
 #include <mutex>
 #include <string>
 
+#include <afina/concurrency/SharedMutex.h>
+
+#include "ReadBuffer.h"
 #include "SimpleLRU.h"
+#include "Sweeper.h"
 
 namespace Afina {
 namespace Backend {
 
 /**
  * # SimpleLRU thread safe version
+ * Get runs under shared lock and doesn't touch LRU list, hits are recorded into the read buffer instead and
+ * replayed in batch by the next writer, by the background sweep or by the reader which has filled its buffer
+ * stripe. So LRU order is eventually consistent and some hits could be lost under heavy read load. As in
+ * ClockLRU, Get only skips expired entry.
  *
- *
+ * That IS thread safe implementation!!
  */
 class ThreadSafeSimplLRU : public SimpleLRU {
 public:
-    ThreadSafeSimplLRU(size_t max_size = 1024) : SimpleLRU(max_size) {}
+    ThreadSafeSimplLRU(size_t max_size = 1024)
+        : SimpleLRU(max_size), _sweeper([this]() { return Sweep(); }) {}
     ~ThreadSafeSimplLRU() {}
 
+    // Implements Afina::Storage interface
+    void Start() override { _sweeper.Start(); }
+
+    // Implements Afina::Storage interface
+    void Stop() override { _sweeper.Stop(); }
+
+    // See CacheBase.h
+    bool Sweep(size_t limit = kSweepSlice) override {
+        std::lock_guard<Concurrency::SharedMutex> lock(_storage_mutex);
+        _drain();
+        return _expire(limit) == limit;
+    }
+
+    // see SimpleLRU.h
+    bool Put(const std::string &key, const std::string &value, uint32_t expire_at = 0) override {
+        return Put(key, _hash(key), value, expire_at);
+    }
+
+    // see SimpleLRU.h
+    bool Put(const std::string &key, size_t hash, const std::string &value, uint32_t expire_at = 0) override {
+        std::lock_guard<Concurrency::SharedMutex> lock(_storage_mutex);
+        _drain();
+        return SimpleLRU::Put(key, hash, value, expire_at);
+    }
+
+    // see SimpleLRU.h
+    bool PutIfAbsent(const std::string &key, const std::string &value, uint32_t expire_at = 0) override {
+        return PutIfAbsent(key, _hash(key), value, expire_at);
+    }
+
+    // see SimpleLRU.h
+    bool PutIfAbsent(const std::string &key, size_t hash, const std::string &value, uint32_t expire_at = 0) override {
+        std::lock_guard<Concurrency::SharedMutex> lock(_storage_mutex);
+        _drain();
+        return SimpleLRU::PutIfAbsent(key, hash, value, expire_at);
+    }
+
+    // see SimpleLRU.h
+    bool Set(const std::string &key, const std::string &value, uint32_t expire_at = 0) override {
+        return Set(key, _hash(key), value, expire_at);
+    }
+
+    // see SimpleLRU.h
+    bool Set(const std::string &key, size_t hash, const std::string &value, uint32_t expire_at = 0) override {
+        std::lock_guard<Concurrency::SharedMutex> lock(_storage_mutex);
+        _drain();
+        return SimpleLRU::Set(key, hash, value, expire_at);
+    }
+
+    // see SimpleLRU.h
+    bool Delete(const std::string &key) override { return Delete(key, _hash(key)); }
+
+    // see SimpleLRU.h
+    bool Delete(const std::string &key, size_t hash) override {
+        std::lock_guard<Concurrency::SharedMutex> lock(_storage_mutex);
+        _drain();
+        return SimpleLRU::Delete(key, hash);
+    }
+
+    // see SimpleLRU.h
+    bool Get(const std::string &key, std::string &value) override { return Get(key, _hash(key), value); }
+
+    // see SimpleLRU.h
+    bool Get(const std::string &key, size_t hash, std::string &value) override {
+        bool full;
+        {
+            Concurrency::SharedLock lock(_storage_mutex);
+            Entry *node = _lookup(key, hash);
+            if (node == nullptr || _dead(*node, TimingWheel::Now())) {
+                _misses.Add();
+                return false;
+            }
+
+            node->copy_value(value);
+            full = !_reads.Record(node);
+            _hits.Add();
+        }
+
+        // Somebody else is already modifying cache, so the buffer will be drained anyway
+        if (full && _storage_mutex.try_lock()) {
+            _drain();
+            _storage_mutex.unlock();
+        }
+        return true;
+    }
+
+    // see SimpleLRU.h
+    bool Put(const std::string &key, size_t hash, Value value, uint32_t expire_at = 0) override {
+        std::lock_guard<Concurrency::SharedMutex> lock(_storage_mutex);
+        _drain();
+        return SimpleLRU::Put(key, hash, std::move(value), expire_at);
+    }
+
+    // see SimpleLRU.h
+    bool PutIfAbsent(const std::string &key, size_t hash, Value value, uint32_t expire_at = 0) override {
+        std::lock_guard<Concurrency::SharedMutex> lock(_storage_mutex);
+        _drain();
+        return SimpleLRU::PutIfAbsent(key, hash, std::move(value), expire_at);
+    }
+
+    // see SimpleLRU.h
+    bool Set(const std::string &key, size_t hash, Value value, uint32_t expire_at = 0) override {
+        std::lock_guard<Concurrency::SharedMutex> lock(_storage_mutex);
+        _drain();
+        return SimpleLRU::Set(key, hash, std::move(value), expire_at);
+    }
+
+    // see SimpleLRU.h
+    bool Get(const std::string &key, size_t hash, Value &value) override {
+        bool full;
+        {
+            Concurrency::SharedLock lock(_storage_mutex);
+            Entry *node = _lookup(key, hash);
+            if (node == nullptr || _dead(*node, TimingWheel::Now())) {
+                _misses.Add();
+                return false;
+            }
+
+            value = _share(*node);
+            full = !_reads.Record(node);
+            _hits.Add();
+        }
+
+        if (full && _storage_mutex.try_lock()) {
+            _drain();
+            _storage_mutex.unlock();
+        }
+        return true;
+    }
+
+    // see SimpleLRU.h
+    bool Append(const std::string &key, size_t hash, const std::string &data) override {
+        std::lock_guard<Concurrency::SharedMutex> lock(_storage_mutex);
+        _drain();
+        return SimpleLRU::Append(key, hash, data);
+    }
+
     // see SimpleLRU.h
-    bool Put(const std::string &key, const std::string &value) override {
-        // TODO: sinchronization
-        std::lock_guard<std::mutex> lock(_storage_mutex);
-        return SimpleLRU::Put(key, value);
+    bool Prepend(const std::string &key, size_t hash, const std::string &data) override {
+        std::lock_guard<Concurrency::SharedMutex> lock(_storage_mutex);
+        _drain();
+        return SimpleLRU::Prepend(key, hash, data);
     }
 
     // see SimpleLRU.h
-    bool PutIfAbsent(const std::string &key, const std::string &value) override {
-        // TODO: sinchronization
-        std::lock_guard<std::mutex> lock(_storage_mutex);
-        return SimpleLRU::PutIfAbsent(key, value);
+    CounterStatus Increment(const std::string &key, size_t hash, uint64_t delta, uint64_t &value) override {
+        if (_shared_count(key, hash, delta, false, value)) {
+            return CounterStatus::Done;
+        }
+        std::lock_guard<Concurrency::SharedMutex> lock(_storage_mutex);
+        _drain();
+        return SimpleLRU::Increment(key, hash, delta, value);
     }
 
     // see SimpleLRU.h
-    bool Set(const std::string &key, const std::string &value) override {
-        // TODO: sinchronization
-        std::lock_guard<std::mutex> lock(_storage_mutex);
-        return SimpleLRU::Set(key, value);
+    CounterStatus Decrement(const std::string &key, size_t hash, uint64_t delta, uint64_t &value) override {
+        if (_shared_count(key, hash, delta, true, value)) {
+            return CounterStatus::Done;
+        }
+        std::lock_guard<Concurrency::SharedMutex> lock(_storage_mutex);
+        _drain();
+        return SimpleLRU::Decrement(key, hash, delta, value);
     }
 
     // see SimpleLRU.h
-    bool Delete(const std::string &key) override {
-        // TODO: sinchronization
-        std::lock_guard<std::mutex> lock(_storage_mutex);
-        return SimpleLRU::Delete(key);
+    CasStatus CompareAndSet(const std::string &key, size_t hash, Value value, uint64_t version,
+                            uint32_t expire_at = 0) override {
+        std::lock_guard<Concurrency::SharedMutex> lock(_storage_mutex);
+        _drain();
+        return SimpleLRU::CompareAndSet(key, hash, std::move(value), version, expire_at);
     }
 
     // see SimpleLRU.h
-    bool Get(const std::string &key, std::string &value) override {
-        // TODO: sinchronization
-        std::lock_guard<std::mutex> lock(_storage_mutex);
-        return SimpleLRU::Get(key, value);
+    bool Touch(const std::string &key, size_t hash, uint32_t expire_at) override {
+        std::lock_guard<Concurrency::SharedMutex> lock(_storage_mutex);
+        _drain();
+        return SimpleLRU::Touch(key, hash, expire_at);
+    }
+
+    // see SimpleLRU.h
+    bool GetAndTouch(const std::string &key, size_t hash, uint32_t expire_at, Value &value,
+                     uint64_t &version) override {
+        std::lock_guard<Concurrency::SharedMutex> lock(_storage_mutex);
+        _drain();
+        return SimpleLRU::GetAndTouch(key, hash, expire_at, value, version);
+    }
+
+    // see CacheBase.h
+    size_t GetMany(const std::vector<std::string> &keys, const std::vector<size_t> &hashes, const size_t *at,
+                   size_t n, std::vector<Value> &values, std::vector<uint64_t> *versions) override {
+        bool full = false;
+        size_t found = 0;
+        {
+            Concurrency::SharedLock lock(_storage_mutex);
+            uint32_t now = TimingWheel::Now();
+            for (size_t begin = 0; begin < n; begin += kBatch) {
+                size_t end = std::min(n, begin + kBatch);
+                _prefetch(hashes, at + begin, end - begin);
+                for (size_t i = begin; i < end; i++) {
+                    Entry *node = _lookup(keys[at[i]], hashes[at[i]]);
+                    if (node == nullptr || _dead(*node, now)) {
+                        _misses.Add();
+                        continue;
+                    }
+
+                    if (versions != nullptr) {
+                        (*versions)[at[i]] = node->version.load(std::memory_order_acquire);
+                    }
+                    values[at[i]] = _share(*node);
+                    full |= !_reads.Record(node);
+                    _hits.Add();
+                    found++;
+                }
+            }
+        }
+
+        if (full && _storage_mutex.try_lock()) {
+            _drain();
+            _storage_mutex.unlock();
+        }
+        return found;
+    }
+
+    // see SimpleLRU.h
+    void GetStats(StorageStats &stats) override {
+        Concurrency::SharedLock lock(_storage_mutex);
+        SimpleLRU::GetStats(stats);
     }
 
 private:
+    // Moves entries hit since the last drain to the head of LRU list, requires exclusive lock
+    void _drain() {
+        _reads.Drain([this](Entry &node) { _on_access(node); });
+    }
+
+    // Updates counter which is already numeric under the shared lock by a single atomic instruction, returns
+    // false if update needs exclusive lock
+    bool _shared_count(const std::string &key, size_t hash, uint64_t delta, bool decrement, uint64_t &value) {
+        bool full;
+        {
+            Concurrency::SharedLock lock(_storage_mutex);
+            Entry *node = _lookup(key, hash);
+            if (node == nullptr || _dead(*node, TimingWheel::Now()) || !node->numeric) {
+                return false;
+            }
+
+            value = node->count(delta, decrement);
+            _stamp(*node);
+            full = !_reads.Record(node);
+        }
+
+        if (full && _storage_mutex.try_lock()) {
+            _drain();
+            _storage_mutex.unlock();
+        }
+        return true;
+    }
+
+    // Readers holds it in shared mode, anybody who changes cache - in exclusive
+    Concurrency::SharedMutex _storage_mutex;
+
+    // Hits waiting to be applied to LRU order
+    ReadBuffer _reads;
 
-    std::mutex _storage_mutex;
-    // TODO: sinchronization primitives
+    // Reclaims expired entries in background
+    Sweeper _sweeper;
 };
 
 } // namespace Backend
@@ -0,0 +1,123 @@
+#include "TimingWheel.h"
+
+#include <cassert>
+
+namespace Afina {
+namespace Backend {
+
+constexpr size_t TimingWheel::kLevels;
+constexpr size_t TimingWheel::kSlotBits;
+constexpr size_t TimingWheel::kSlots;
+
+// Slot lists are singly headed: each entry keeps address of the pointer referring to it, so it could be
+// unlinked without knowing the slot
+static inline void link_timer(Entry *&head, Entry &entry) {
+    entry.timer_next = head;
+    if (head != nullptr) {
+        head->timer_pprev = &entry.timer_next;
+    }
+    head = &entry;
+    entry.timer_pprev = &head;
+}
+
+static inline void unlink_timer(Entry &entry) {
+    *entry.timer_pprev = entry.timer_next;
+    if (entry.timer_next != nullptr) {
+        entry.timer_next->timer_pprev = entry.timer_pprev;
+    }
+    entry.timer_next = nullptr;
+    entry.timer_pprev = nullptr;
+}
+
+// See TimingWheel.h
+TimingWheel::TimingWheel(uint32_t now) : _now(now), _size(0), _due(nullptr) {
+    for (size_t level = 0; level < kLevels; level++) {
+        for (size_t slot = 0; slot < kSlots; slot++) {
+            _slots[level][slot] = nullptr;
+        }
+    }
+}
+
+// See TimingWheel.h
+void TimingWheel::Schedule(Entry &entry) {
+    assert(entry.expire_at != 0 && entry.timer_pprev == nullptr);
+    _place(entry);
+    _size++;
+}
+
+// See TimingWheel.h
+void TimingWheel::Cancel(Entry &entry) {
+    if (entry.timer_pprev != nullptr) {
+        unlink_timer(entry);
+        _size--;
+    }
+}
+
+// See TimingWheel.h
+Entry *TimingWheel::Expired(uint32_t now) {
+    if (_size == 0) {
+        // Nothing to redistribute, so just jump
+        if (now > _now) {
+            _now = now;
+        }
+        return nullptr;
+    }
+
+    while (_due == nullptr && _now < now) {
+        _tick();
+    }
+    return _due;
+}
+
+void TimingWheel::_place(Entry &entry) {
+    uint32_t expire_at = entry.expire_at;
+    if (expire_at <= _now) {
+        link_timer(_due, entry);
+        return;
+    }
+
+    uint32_t delta = expire_at - _now;
+    for (size_t level = 0; level < kLevels; level++) {
+        if (delta < (uint32_t(1) << (kSlotBits * (level + 1)))) {
+            link_timer(_slots[level][(expire_at >> (kSlotBits * level)) & (kSlots - 1)], entry);
+            return;
+        }
+    }
+
+    // Too far for the wheel, park it in the farthest slot of the top level, it will be redistributed from there
+    uint32_t parked = _now + (uint32_t(1) << (kSlotBits * kLevels)) - 1;
+    link_timer(_slots[kLevels - 1][(parked >> (kSlotBits * (kLevels - 1))) & (kSlots - 1)], entry);
+}
+
+void TimingWheel::_tick() {
+    _now++;
+
+    // Every time lower level makes a full turn, next slot of the upper level is redistributed
+    for (size_t level = 1; level < kLevels; level++) {
+        if ((_now & ((uint32_t(1) << (kSlotBits * level)) - 1)) != 0) {
+            break;
+        }
+
+        Entry *&slot = _slots[level][(_now >> (kSlotBits * level)) & (kSlots - 1)];
+        Entry *entry = slot;
+        slot = nullptr;
+        while (entry != nullptr) {
+            Entry *next = entry->timer_next;
+            entry->timer_next = nullptr;
+            entry->timer_pprev = nullptr;
+            _place(*entry);
+            entry = next;
+        }
+    }
+
+    // Everything in the current level 0 slot expires right now
+    Entry *&slot = _slots[0][_now & (kSlots - 1)];
+    while (slot != nullptr) {
+        Entry &entry = *slot;
+        unlink_timer(entry);
+        link_timer(_due, entry);
+    }
+}
+
+} // namespace Backend
+} // namespace Afina
@@ -0,0 +1,85 @@
+#ifndef AFINA_STORAGE_TIMING_WHEEL_H
+#define AFINA_STORAGE_TIMING_WHEEL_H
+
+#include <cstddef>
+#include <cstdint>
+#include <ctime>
+
+#include "Entry.h"
+
+namespace Afina {
+namespace Backend {
+
+/**
+ * # Hierarchical timing wheel of entries expiration
+ * Wheel has 4 levels of 64 slots, one second resolution. Level 0 slots hold entries expiring in the next 64
+ * seconds, one slot per second, each slot of level N covers 64^N seconds. Once wheel time reaches the range of
+ * a higher level slot, its entries get redistributed over the lower levels, so scheduling and cancellation are
+ * O(1) and each entry is moved at most once per level.
+ *
+ * Entries are linked through their own timer links, so wheel doesn't allocate anything.
+ *
+ * That is NOT thread safe implementation!!
+ */
+class TimingWheel {
+public:
+    TimingWheel(uint32_t now = Now());
+    ~TimingWheel() {}
+
+    TimingWheel(const TimingWheel &) = delete;
+    TimingWheel &operator=(const TimingWheel &) = delete;
+
+    /**
+     * Current unix time in seconds, the same clock used to compute expire_at
+     */
+    static inline uint32_t Now() { return std::time(nullptr); }
+
+    /**
+     * Adds entry into the wheel according to its expire_at, which must not be zero. Entry must not be scheduled
+     * already
+     */
+    void Schedule(Entry &entry);
+
+    /**
+     * Removes entry from the wheel, does nothing if entry isn't scheduled
+     */
+    void Cancel(Entry &entry);
+
+    /**
+     * Advances wheel up to the given time and returns one of entries expired by that time or nullptr if there
+     * is no such entries. Entry is left in the wheel, caller is expected to remove it from the cache and so
+     * cancel it
+     */
+    Entry *Expired(uint32_t now);
+
+    /**
+     * Number of scheduled entries
+     */
+    inline size_t Size() const { return _size; }
+
+private:
+    static constexpr size_t kLevels = 4;
+    static constexpr size_t kSlotBits = 6;
+    static constexpr size_t kSlots = 1 << kSlotBits;
+
+    // Puts entry into the right slot relative to the current wheel time
+    void _place(Entry &entry);
+
+    // Advances wheel time by one second
+    void _tick();
+
+    // Time up to which wheel has been advanced
+    uint32_t _now;
+
+    size_t _size;
+
+    // Entries which are already expired
+    Entry *_due;
+
+    Entry *_slots[kLevels][kSlots];
+};
+
+} // namespace Backend
+} // namespace Afina
+
+#endif // AFINA_STORAGE_TIMING_WHEEL_H
@@ -0,0 +1,99 @@
+#include "TinyLFU.h"
+
+namespace Afina {
+namespace Backend {
+
+TinyLFU::TinyLFU(size_t max_size)
+    : CacheBase(max_size), _window_max(max_size / 100), _protected_max((max_size - max_size / 100) / 10 * 8),
+      _candidate(nullptr), _sketch(max_size / 64) {
+    for (size_t i = 0; i < 3; i++) {
+        _lists[i].make_head();
+        _sizes[i] = 0;
+    }
+}
+
+// See CacheBase.h
+void TinyLFU::_on_insert(Entry &node) {
+    _sketch.Increment(node.hash);
+    node.queue = kWindow;
+    node.link_before(*_lists[kWindow].next);
+    _sizes[kWindow] += _size_of(node);
+
+    // Window overflow goes to the main cache, the last one will compete with main's victim once cache is full
+    while (_sizes[kWindow] > _window_max && _tail(_lists[kWindow]) != &node) {
+        _candidate = _tail(_lists[kWindow]);
+        _move(*_candidate, kProbation);
+    }
+}
+
+// See CacheBase.h
+void TinyLFU::_on_access(Entry &node) {
+    _sketch.Increment(node.hash);
+    if (&node == _candidate) {
+        // Already proved to be useful
+        _candidate = nullptr;
+    }
+    if (node.queue != kProbation) {
+        _move(node, Queue(node.queue));
+        return;
+    }
+
+    // Second access in the main cache, entry has proved to be useful
+    _move(node, kProtected);
+    while (_sizes[kProtected] > _protected_max) {
+        _move(*_tail(_lists[kProtected]), kProbation);
+    }
+}
+
+// See CacheBase.h
+void TinyLFU::_on_remove(Entry &node) {
+    if (&node == _candidate) {
+        _candidate = nullptr;
+    }
+    node.unlink();
+    _sizes[node.queue] -= _size_of(node);
+}
+
+// See CacheBase.h
+void TinyLFU::_on_replace(Entry &old, Entry &fresh) {
+    CacheBase::_on_replace(old, fresh);
+    fresh.queue = old.queue;
+    if (&old == _candidate) {
+        _candidate = &fresh;
+    }
+}
+
+// See CacheBase.h
+void TinyLFU::_on_resize(Entry &node, size_t old_size) { _sizes[node.queue] += _size_of(node) - old_size; }
+
+// See CacheBase.h
+Entry *TinyLFU::_victim() {
+    Entry *victim = _tail(_lists[kProbation]);
+    if (victim == nullptr) {
+        victim = _tail(_lists[kProtected]);
+    }
+    if (victim == nullptr) {
+        return _tail(_lists[kWindow]);
+    }
+
+    // Entry which has just left the window stays in the main cache only if it is used more often than the victim
+    Entry *candidate = _candidate;
+    _candidate = nullptr;
+    if (candidate != nullptr && candidate != victim &&
+        _sketch.Frequency(candidate->hash) <= _sketch.Frequency(victim->hash)) {
+        return candidate;
+    }
+    return victim;
+}
+
+void TinyLFU::_move(Entry &node, Queue queue) {
+    node.unlink();
+    _sizes[node.queue] -= _size_of(node);
+
+    node.queue = queue;
+    node.link_before(*_lists[queue].next);
+    _sizes[queue] += _size_of(node);
+}
+
+} // namespace Backend
+} // namespace Afina
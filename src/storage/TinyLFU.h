@@ -0,0 +1,78 @@
+#ifndef AFINA_STORAGE_TINY_LFU_H
+#define AFINA_STORAGE_TINY_LFU_H
+
+#include <string>
+
+#include "CacheBase.h"
+#include "FrequencySketch.h"
+
+namespace Afina {
+namespace Backend {
+
+/**
+ * # W-TinyLFU
+ * New entries get into the small window LRU (1% of the memory), entry leaving the window competes for the
+ * place in the main cache with main's eviction victim: the one accessed more often according to the frequency
+ * sketch stays, the other one gets evicted. So keys used only once pass through the window without pushing
+ * out valuable ones.
+ *
+ * Main cache is segmented LRU: entries come into probation segment and get promoted into protected one (80% of
+ * the main) on the next access, protected overflow is demoted back to probation. Victims are taken from
+ * probation first.
+ *
+ * That is NOT thread safe implementation!!
+ */
+class TinyLFU : public CacheBase {
+public:
+    TinyLFU(size_t max_size = 1024);
+    ~TinyLFU() {}
+
+protected:
+    // See CacheBase.h
+    void _on_insert(Entry &node) override;
+
+    // See CacheBase.h
+    void _on_access(Entry &node) override;
+
+    // See CacheBase.h
+    void _on_remove(Entry &node) override;
+
+    // See CacheBase.h
+    void _on_replace(Entry &old, Entry &fresh) override;
+
+    // See CacheBase.h
+    void _on_resize(Entry &node, size_t old_size) override;
+
+    // See CacheBase.h
+    Entry *_victim() override;
+
+private:
+    enum Queue : uint8_t { kWindow, kProbation, kProtected };
+
+    static inline size_t _size_of(const Entry &node) { return node.key_size + node.value_size; }
+
+    // Least recently used entry of the list or nullptr if list is empty
+    static inline Entry *_tail(Entry &head) { return head.prev != &head ? head.prev : nullptr; }
+
+    // Moves entry to the head of the given list
+    void _move(Entry &node, Queue queue);
+
+    // Lists ordered from the most recently used to the least one
+    Entry _lists[3];
+
+    // Number of bytes of keys and values in each list
+    size_t _sizes[3];
+
+    size_t _window_max;
+    size_t _protected_max;
+
+    // The latest entry moved from the window into the main cache, which hasn't competed with a victim yet
+    Entry *_candidate;
+
+    FrequencySketch _sketch;
+};
+
+} // namespace Backend
+} // namespace Afina
+
+#endif // AFINA_STORAGE_TINY_LFU_H
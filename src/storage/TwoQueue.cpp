@@ -0,0 +1,89 @@
+#include "TwoQueue.h"
+
+namespace Afina {
+namespace Backend {
+
+TwoQueue::TwoQueue(size_t max_size)
+    : CacheBase(max_size), _in_max(max_size / 4), _out_max(max_size / 2), _ghosts_size(0) {
+    for (size_t i = 0; i < 2; i++) {
+        _lists[i].make_head();
+        _sizes[i] = 0;
+    }
+}
+
+// See CacheBase.h
+void TwoQueue::_on_insert(Entry &node) {
+    // Key which has been evicted recently is used again, so it is worth keeping
+    node.queue = _forget(node.hash) ? kMain : kIn;
+    node.link_before(*_lists[node.queue].next);
+    _sizes[node.queue] += _size_of(node);
+}
+
+// See CacheBase.h
+void TwoQueue::_on_access(Entry &node) {
+    // Hits in A1in are most likely correlated ones, they don't prove anything
+    if (node.queue == kMain) {
+        node.unlink();
+        node.link_before(*_lists[kMain].next);
+    }
+}
+
+// See CacheBase.h
+void TwoQueue::_on_remove(Entry &node) {
+    node.unlink();
+    _sizes[node.queue] -= _size_of(node);
+}
+
+// See CacheBase.h
+void TwoQueue::_on_replace(Entry &old, Entry &fresh) {
+    CacheBase::_on_replace(old, fresh);
+    fresh.queue = old.queue;
+}
+
+// See CacheBase.h
+void TwoQueue::_on_resize(Entry &node, size_t old_size) { _sizes[node.queue] += _size_of(node) - old_size; }
+
+// See CacheBase.h
+void TwoQueue::_on_evict(Entry &node) {
+    // Only entries which have really left A1in are remembered, growing entry is chosen as victim but stays
+    if (node.queue == kIn) {
+        _remember(node);
+    }
+}
+
+// See CacheBase.h
+Entry *TwoQueue::_victim() {
+    Entry *victim = _tail(_lists[kMain]);
+    if (victim == nullptr || _sizes[kIn] > _in_max) {
+        victim = _tail(_lists[kIn]);
+    }
+    return victim;
+}
+
+void TwoQueue::_remember(const Entry &node) {
+    _forget(node.hash);
+    _ghosts.push_front(Ghost{node.hash, _size_of(node)});
+    _ghost_index[node.hash] = _ghosts.begin();
+    _ghosts_size += _size_of(node);
+
+    while (_ghosts_size > _out_max) {
+        _ghosts_size -= _ghosts.back().size;
+        _ghost_index.erase(_ghosts.back().hash);
+        _ghosts.pop_back();
+    }
+}
+
+bool TwoQueue::_forget(size_t hash) {
+    auto it = _ghost_index.find(hash);
+    if (it == _ghost_index.end()) {
+        return false;
+    }
+
+    _ghosts_size -= it->second->size;
+    _ghosts.erase(it->second);
+    _ghost_index.erase(it);
+    return true;
+}
+
+} // namespace Backend
+} // namespace Afina
@@ -0,0 +1,90 @@
+#ifndef AFINA_STORAGE_TWO_QUEUE_H
+#define AFINA_STORAGE_TWO_QUEUE_H
+
+#include <list>
+#include <string>
+#include <unordered_map>
+
+#include "CacheBase.h"
+
+namespace Afina {
+namespace Backend {
+
+/**
+ * # Full 2Q
+ * New entries get into A1in FIFO queue, hits there don't change anything. Entries evicted from A1in leave
+ * their hash in A1out ghost queue, and if the key comes back while its ghost is still remembered, it goes
+ * straight into Am LRU - the only place where entries are considered hot. So the keyspace scan flows through
+ * A1in and A1out, hot set in Am stays in the cache.
+ *
+ * A1in is evicted first once it holds more than 25% of _max_size bytes, ghosts remember 50% of _max_size
+ * bytes of evicted entries. Ghosts hold neither keys nor values, so they are not counted in _max_size.
+ *
+ * That is NOT thread safe implementation!!
+ */
+class TwoQueue : public CacheBase {
+public:
+    TwoQueue(size_t max_size = 1024);
+    ~TwoQueue() {}
+
+protected:
+    // See CacheBase.h
+    void _on_insert(Entry &node) override;
+
+    // See CacheBase.h
+    void _on_access(Entry &node) override;
+
+    // See CacheBase.h
+    void _on_remove(Entry &node) override;
+
+    // See CacheBase.h
+    void _on_replace(Entry &old, Entry &fresh) override;
+
+    // See CacheBase.h
+    void _on_resize(Entry &node, size_t old_size) override;
+
+    // See CacheBase.h
+    void _on_evict(Entry &node) override;
+
+    // See CacheBase.h
+    Entry *_victim() override;
+
+private:
+    enum Queue : uint8_t { kIn, kMain };
+
+    // Evicted entry remembered by A1out
+    struct Ghost {
+        size_t hash;
+        size_t size;
+    };
+
+    static inline size_t _size_of(const Entry &node) { return node.key_size + node.value_size; }
+
+    // Least recently used entry of the list or nullptr if list is empty
+    static inline Entry *_tail(Entry &head) { return head.prev != &head ? head.prev : nullptr; }
+
+    // Adds ghost of the evicted entry, the oldest ghosts are forgotten to fit into _out_max
+    void _remember(const Entry &node);
+
+    // Removes ghost with the given hash, returns false if there is no such ghost
+    bool _forget(size_t hash);
+
+    // A1in and Am, ordered from the newest (most recently used) entry to the oldest one
+    Entry _lists[2];
+
+    // Number of bytes of keys and values in each list
+    size_t _sizes[2];
+
+    size_t _in_max;
+    size_t _out_max;
+
+    // A1out ghosts from the newest to the oldest one, indexed by hash
+    std::list<Ghost> _ghosts;
+    std::unordered_map<size_t, std::list<Ghost>::iterator> _ghost_index;
+    size_t _ghosts_size;
+};
+
+} // namespace Backend
+} // namespace Afina
+
+#endif // AFINA_STORAGE_TWO_QUEUE_H
@@ -0,0 +1,218 @@
+#include <gtest/gtest.h>
+
+#include <string>
+
+#include <afina/execute/Add.h>
+#include <afina/execute/AnyCommand.h>
+#include <afina/execute/Append.h>
+#include <afina/execute/Cas.h>
+#include <afina/execute/Decr.h>
+#include <afina/execute/FlushAll.h>
+#include <afina/execute/FlushNamespace.h>
+#include <afina/execute/Gat.h>
+#include <afina/execute/Gats.h>
+#include <afina/execute/Get.h>
+#include <afina/execute/Gets.h>
+#include <afina/execute/Incr.h>
+#include <afina/execute/Prepend.h>
+#include <afina/execute/Replace.h>
+#include <afina/execute/Response.h>
+#include <afina/execute/Set.h>
+#include <afina/execute/Touch.h>
+
+#include "storage/SimpleLRU.h"
+
+using namespace Afina;
+
+TEST(ExecuteTest, ResponseParts) {
+    Execute::Response response;
+    response.Append("VALUE ");
+    response.Append("k 0 3\r\n");
+    response.Append(Value(std::string("abc")));
+    response.Append("\r\n", 2);
+    EXPECT_EQ(18, response.Size());
+    EXPECT_EQ("VALUE k 0 3\r\nabc\r\n", response.ToString());
+
+    struct iovec iov[8];
+    EXPECT_EQ(3, response.Gather(iov, 8, 0));
+    EXPECT_EQ(13, iov[0].iov_len);
+    EXPECT_EQ(2, response.Gather(iov, 8, 14));
+    EXPECT_EQ("bc", std::string(static_cast<char *>(iov[0].iov_base), iov[0].iov_len));
+    EXPECT_EQ(1, response.Gather(iov, 1, 0));
+
+    response.Clear();
+    EXPECT_TRUE(response.Empty());
+}
+
+TEST(ExecuteTest, GetSharesValue) {
+    Backend::SimpleLRU storage(1024 * 1024);
+
+    std::string data(16 * 1024, 'v');
+    const char *buffer = data.data();
+    Execute::Response response;
+    Execute::Set("key", 0, 0).Execute(storage, std::move(data), response);
+    EXPECT_EQ("STORED", response.ToString());
+
+    response.Clear();
+    Execute::Get(std::vector<std::string>{"key", "none"}).Execute(storage, std::string(), response);
+
+    const char *sent = nullptr;
+    response.ForEach([&sent](const char *data, size_t size) {
+        if (size == 16 * 1024) {
+            sent = data;
+        }
+    });
+    EXPECT_EQ(buffer, sent);
+    EXPECT_EQ("VALUE key 0 16384\r\n" + std::string(16 * 1024, 'v') + "\r\nEND", response.ToString());
+}
+
+TEST(ExecuteTest, AppendFlat) {
+    Backend::SimpleLRU storage(1024 * 1024);
+
+    Execute::Set set("key", 0, 0);
+    Execute::Append append("key", 0, 0), missing("none", 0, 0);
+
+    // Commands are run by the flat interface of the base class
+    std::string out;
+    static_cast<Execute::Command &>(set).Execute(storage, "foo", out);
+    EXPECT_EQ("STORED", out);
+    static_cast<Execute::Command &>(append).Execute(storage, "bar", out);
+    EXPECT_EQ("STORED", out);
+    static_cast<Execute::Command &>(missing).Execute(storage, "bar", out);
+    EXPECT_EQ("NOT_STORED", out);
+
+    std::string value;
+    EXPECT_TRUE(storage.Get("key", value));
+    EXPECT_EQ("foobar", value);
+}
+
+TEST(ExecuteTest, ConditionalStores) {
+    Backend::SimpleLRU storage(1024 * 1024);
+
+    Execute::Response out;
+    Execute::Replace("key", 0, 0).Execute(storage, "foo", out);
+    Execute::Prepend("key", 0, 0).Execute(storage, "bar", out);
+    Execute::Add("key", 0, 0).Execute(storage, "foo", out);
+    Execute::Add("key", 0, 0).Execute(storage, "bar", out);
+    Execute::Replace("key", 0, 0).Execute(storage, "baz", out);
+    Execute::Prepend("key", 0, 0).Execute(storage, ">", out);
+    EXPECT_EQ("NOT_STOREDNOT_STOREDSTOREDNOT_STOREDSTOREDSTORED", out.ToString());
+
+    std::string value;
+    EXPECT_TRUE(storage.Get("key", value));
+    EXPECT_EQ(">baz", value);
+}
+
+TEST(ExecuteTest, IncrDecr) {
+    Backend::SimpleLRU storage(1024 * 1024);
+    storage.Put("num", "41");
+    storage.Put("text", "abc");
+
+    Execute::Response out;
+    Execute::Incr("num", 1).Execute(storage, "", out);
+    out.Append(" ");
+    Execute::Decr("num", 50).Execute(storage, "", out);
+    out.Append(" ");
+    Execute::Incr("none", 1).Execute(storage, "", out);
+    out.Append(" ");
+    Execute::Decr("text", 1).Execute(storage, "", out);
+    EXPECT_EQ("42 0 NOT_FOUND CLIENT_ERROR cannot increment or decrement non-numeric value", out.ToString());
+}
+
+TEST(ExecuteTest, GetsCas) {
+    Backend::SimpleLRU storage(1024 * 1024);
+    storage.Put("key", "abc");
+
+    std::vector<Value> values;
+    std::vector<uint64_t> versions;
+    storage.MultiGets({"key"}, {Hash("key")}, values, versions);
+    std::string version = std::to_string(versions[0]);
+
+    Execute::Response out;
+    Execute::Gets({"key", "none"}).Execute(storage, "", out);
+    EXPECT_EQ("VALUE key 0 3 " + version + "\r\nabc\r\nEND", out.ToString());
+
+    out.Clear();
+    Execute::Cas("none", 0, 0, versions[0]).Execute(storage, "x", out);
+    out.Append(" ");
+    Execute::Cas("key", 0, 0, versions[0] + 1).Execute(storage, "x", out);
+    out.Append(" ");
+    Execute::Cas("key", 0, 0, versions[0]).Execute(storage, "x", out);
+    out.Append(" ");
+    Execute::Cas("key", 0, 0, versions[0]).Execute(storage, "y", out);
+    EXPECT_EQ("NOT_FOUND EXISTS STORED EXISTS", out.ToString());
+}
+
+TEST(ExecuteTest, TouchGat) {
+    Backend::SimpleLRU storage(1024 * 1024);
+    storage.Put("key", "abc");
+
+    Execute::Response out;
+    Execute::Touch("key", 100).Execute(storage, "", out);
+    out.Append(" ");
+    Execute::Touch("none", 100).Execute(storage, "", out);
+    EXPECT_EQ("TOUCHED NOT_FOUND", out.ToString());
+
+    out.Clear();
+    Execute::Gat({"key", "none"}, 0).Execute(storage, "", out);
+    EXPECT_EQ("VALUE key 0 3\r\nabc\r\nEND", out.ToString());
+
+    std::vector<Value> values;
+    std::vector<uint64_t> versions;
+    storage.MultiGets({"key"}, {Hash("key")}, values, versions);
+    out.Clear();
+    Execute::Gats({"key"}, 0).Execute(storage, "", out);
+    EXPECT_EQ("VALUE key 0 3 " + std::to_string(versions[0]) + "\r\nabc\r\nEND", out.ToString());
+
+    // Negative expire time removes the key
+    out.Clear();
+    Execute::Gat({"key"}, -1).Execute(storage, "", out);
+    Execute::Gat({"key"}, 0).Execute(storage, "", out);
+    EXPECT_EQ("VALUE key 0 3\r\nabc\r\nENDEND", out.ToString());
+}
+
+TEST(ExecuteTest, Flush) {
+    Backend::SimpleLRU storage(1024 * 1024);
+    storage.Put("ns:key", "abc");
+    storage.Put("key", "def");
+
+    Execute::Response out;
+    Execute::FlushNamespace({"ns"}).Execute(storage, "", out);
+    EXPECT_EQ("OK", out.ToString());
+
+    std::string value;
+    EXPECT_FALSE(storage.Get("ns:key", value));
+    EXPECT_TRUE(storage.Get("key", value));
+
+    out.Clear();
+    Execute::FlushAll().Execute(storage, "", out);
+    EXPECT_EQ("OK", out.ToString());
+    EXPECT_FALSE(storage.Get("key", value));
+}
+
+TEST(ExecuteTest, AnyCommand) {
+    Backend::SimpleLRU storage(1024 * 1024);
+    Execute::AnyCommand command;
+    ASSERT_FALSE(command);
+    ASSERT_EQ(nullptr, command.get());
+
+    Execute::Response out;
+    command.Emplace<Execute::Set>("key", 0, 0);
+    ASSERT_TRUE(command);
+    command.Execute(storage, "abc", out);
+    EXPECT_EQ("STORED", out.ToString());
+
+    out.Clear();
+    command.Emplace<Execute::Get>(std::vector<std::string>{"key"});
+    command.Execute(storage, "", out);
+    EXPECT_EQ("VALUE key 0 3\r\nabc\r\nEND", out.ToString());
+
+    // Command is usable through the interface as well
+    out.Clear();
+    command.get()->Execute(storage, "", out);
+    EXPECT_EQ("VALUE key 0 3\r\nabc\r\nEND", out.ToString());
+
+    command.Reset();
+    ASSERT_FALSE(command);
+    EXPECT_THROW(command.Execute(storage, "", out), std::runtime_error);
+}
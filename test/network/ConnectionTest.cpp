@@ -0,0 +1,181 @@
+#include <gtest/gtest.h>
+
+#include <chrono>
+#include <map>
+#include <memory>
+#include <string>
+#include <thread>
+
+#include <fcntl.h>
+#include <sys/eventfd.h>
+#include <sys/socket.h>
+#include <sys/time.h>
+#include <unistd.h>
+
+#include <spdlog/logger.h>
+#include <spdlog/sinks/null_sink.h>
+
+#include <afina/logging/Service.h>
+
+#include "network/mt_nonblocking/Worker.h"
+#include "storage/ThreadSafeSimpleLRU.h"
+
+using namespace Afina;
+
+// Loggers writing nowhere
+class NullLogging : public Logging::Service {
+public:
+    void Start() override {}
+    void Stop() override {}
+    std::shared_ptr<spdlog::logger> select(const std::string &name) noexcept override {
+        return std::make_shared<spdlog::logger>(name, std::make_shared<spdlog::sinks::null_sink_mt>());
+    }
+    std::unique_ptr<spdlog::logger> create(const std::string &name,
+                                           const std::map<std::string, std::string> &mdc) noexcept override {
+        auto sink = std::make_shared<spdlog::sinks::null_sink_mt>();
+        return std::unique_ptr<spdlog::logger>(new spdlog::logger(name, sink));
+    }
+    void reopen_all() override {}
+};
+
+// Worker serving a single connection, test is the client on the other end of the socket pair
+class ConnectionTest : public ::testing::Test {
+protected:
+    void SetUp() override {
+        storage = std::make_shared<Backend::ThreadSafeSimplLRU>(64 << 20);
+        wakeup = eventfd(0, EFD_NONBLOCK);
+        ASSERT_NE(-1, wakeup);
+
+        int fds[2];
+        ASSERT_EQ(0, socketpair(AF_UNIX, SOCK_STREAM, 0, fds));
+        ASSERT_EQ(0, fcntl(fds[0], F_SETFL, O_NONBLOCK));
+        client = fds[1];
+
+        // Client never waits forever for the response which doesn't come
+        struct timeval tv = {5, 0};
+        ASSERT_EQ(0, setsockopt(client, SOL_SOCKET, SO_RCVTIMEO, &tv, sizeof(tv)));
+
+        worker.reset(new Network::MTnonblock::Worker(storage, std::make_shared<NullLogging>()));
+        worker->Start(wakeup);
+        worker->Accept(fds[0]);
+    }
+
+    void TearDown() override {
+        worker->Stop();
+        eventfd_write(wakeup, 1);
+        worker->Join();
+        worker.reset();
+        close(client);
+        close(wakeup);
+    }
+
+    void Send(const std::string &data) {
+        for (size_t sent = 0; sent < data.size();) {
+            ssize_t written = write(client, data.data() + sent, data.size() - sent);
+            ASSERT_LT(0, written);
+            sent += written;
+        }
+    }
+
+    // Reads exactly size bytes, or less if connection is closed or nothing comes for too long
+    std::string Receive(size_t size) {
+        std::string result(size, '\0');
+        size_t filled = 0;
+        while (filled < size) {
+            ssize_t readed = read(client, &result[filled], size - filled);
+            if (readed <= 0) {
+                break;
+            }
+            filled += readed;
+        }
+        result.resize(filled);
+        return result;
+    }
+
+    // Response to get of the single key
+    static std::string Found(const std::string &key, const std::string &value) {
+        return "VALUE " + key + " 0 " + std::to_string(value.size()) + "\r\n" + value + "\r\nEND\r\n";
+    }
+
+    // Lets worker handle what it has got so far
+    static void Settle() { std::this_thread::sleep_for(std::chrono::milliseconds(200)); }
+
+    std::shared_ptr<Backend::ThreadSafeSimplLRU> storage;
+    std::unique_ptr<Network::MTnonblock::Worker> worker;
+    int wakeup;
+    int client;
+};
+
+TEST_F(ConnectionTest, PipelinedOrder) {
+    std::string commands = "set a 0 0 1\r\n1\r\nget a\r\nappend a 0 0 1\r\n2\r\nget a\r\nincr a 3\r\nget a\r\n";
+    std::string expected = "STORED\r\n" + Found("a", "1") + "STORED\r\n" + Found("a", "12") + "15\r\n" + Found("a", "15");
+
+    // Batch comes in one go and split at every byte, responses follow the commands either way
+    Send(commands);
+    ASSERT_EQ(expected, Receive(expected.size()));
+
+    for (char c : commands) {
+        Send(std::string(1, c));
+    }
+    ASSERT_EQ(expected, Receive(expected.size()));
+}
+
+TEST_F(ConnectionTest, QueuedOutput) {
+    std::string value(256 << 10, 'v');
+    ASSERT_TRUE(storage->Put("big", value));
+
+    // Responses don't fit into the socket, the rest is written as client takes them
+    std::string commands, expected;
+    for (int i = 0; i < 8; i++) {
+        commands += "get big\r\n";
+        expected += Found("big", value);
+    }
+    Send(commands);
+    Settle();
+    ASSERT_EQ(expected, Receive(expected.size()));
+
+    // Connection goes on once the queue is written
+    Send("get big\r\n");
+    ASSERT_EQ(Found("big", value), Receive(expected.size() / 8));
+}
+
+TEST_F(ConnectionTest, PauseAndResume) {
+    std::string value(1 << 20, 'v');
+    ASSERT_TRUE(storage->Put("big", value));
+
+    // Client doesn't take responses, so commands are not read any further
+    std::string commands, expected;
+    for (int i = 0; i < 8; i++) {
+        commands += "get big\r\n";
+        expected += Found("big", value);
+    }
+    Send(commands);
+    Settle();
+    Send("set c 0 0 1\r\n1\r\n");
+    Settle();
+
+    std::string c;
+    ASSERT_FALSE(storage->Get("c", c));
+
+    // Reading resumes once responses are written
+    expected += "STORED\r\n";
+    ASSERT_EQ(expected, Receive(expected.size()));
+    ASSERT_TRUE(storage->Get("c", c));
+    ASSERT_EQ("1", c);
+}
+
+TEST_F(ConnectionTest, HalfCloseWithPendingOutput) {
+    std::string value(1 << 20, 'v');
+    ASSERT_TRUE(storage->Put("big", value));
+
+    // Client closes its side right after commands, responses still come and then connection is closed
+    Send("get big\r\nget big\r\nset c 0 0 1\r\n1\r\n");
+    ASSERT_EQ(0, shutdown(client, SHUT_WR));
+    Settle();
+
+    std::string expected = Found("big", value) + Found("big", value) + "STORED\r\n";
+    ASSERT_EQ(expected, Receive(expected.size()));
+
+    char byte;
+    ASSERT_EQ(0, read(client, &byte, 1));
+}
@@ -0,0 +1,72 @@
+#include <gtest/gtest.h>
+
+#include <cstring>
+#include <string>
+
+#include <unistd.h>
+
+#include "network/InputBuffer.h"
+
+using namespace Afina;
+
+TEST(InputBufferTest, ConsumeWithoutCopy) {
+    Network::InputBuffer input(16);
+    ASSERT_TRUE(input.Empty());
+
+    std::memcpy(input.Reserve(10), "get a\r\nget", 10);
+    input.Commit(10);
+    const char *data = input.Data();
+    ASSERT_EQ(10, input.Size());
+
+    input.Consume(7);
+    ASSERT_EQ(data + 7, input.Data());
+    ASSERT_EQ("get", std::string(input.Data(), input.Size()));
+
+    // Unread bytes are moved to the front once there is no room after them
+    std::memcpy(input.Reserve(12), " b\r\nget c\r\n", 11);
+    input.Commit(11);
+    ASSERT_EQ(16, input.Capacity());
+    ASSERT_EQ("get b\r\nget c\r\n", std::string(input.Data(), input.Size()));
+
+    // Cursors go back to the front once everything is consumed
+    input.Consume(input.Size());
+    ASSERT_TRUE(input.Empty());
+    ASSERT_EQ(data, input.Data());
+}
+
+TEST(InputBufferTest, GrowAndShrink) {
+    Network::InputBuffer input(16);
+    std::memcpy(input.Reserve(4), "set ", 4);
+    input.Commit(4);
+
+    std::string value(100, 'x');
+    std::memcpy(input.Reserve(value.size()), value.data(), value.size());
+    input.Commit(value.size());
+    ASSERT_LE(104, input.Capacity());
+    ASSERT_EQ("set " + value, std::string(input.Data(), input.Size()));
+
+    // Nothing is released while there are bytes to process
+    input.Shrink();
+    ASSERT_LE(104, input.Capacity());
+
+    input.Consume(input.Size());
+    input.Shrink();
+    ASSERT_EQ(16, input.Capacity());
+}
+
+TEST(InputBufferTest, ReadFrom) {
+    int fds[2];
+    ASSERT_EQ(0, pipe(fds));
+
+    std::string value(1000, 'v');
+    ASSERT_EQ(value.size(), write(fds[1], value.data(), value.size()));
+
+    // Room for the whole value is made at once
+    Network::InputBuffer input(16);
+    ASSERT_EQ(value.size(), input.ReadFrom(fds[0], value.size()));
+    ASSERT_EQ(value, std::string(input.Data(), input.Size()));
+
+    close(fds[1]);
+    ASSERT_EQ(0, input.ReadFrom(fds[0]));
+    close(fds[0]);
+}
@@ -0,0 +1,69 @@
+#include <gtest/gtest.h>
+
+#include <cerrno>
+#include <string>
+
+#include <fcntl.h>
+#include <sys/socket.h>
+#include <unistd.h>
+
+#include "network/Transfer.h"
+
+using namespace Afina;
+
+TEST(TransferTest, ReceiveArgumentPart) {
+    int fds[2];
+    ASSERT_EQ(0, socketpair(AF_UNIX, SOCK_STREAM, 0, fds));
+    ASSERT_EQ(0, fcntl(fds[0], F_SETFL, O_NONBLOCK));
+
+    std::string value(Network::kReceiveChunk + 100, 'v');
+    std::string argument;
+    size_t filled = 0, remains = value.size();
+
+    // Room is made by chunks, bytes arrived go right after the filled ones
+    ASSERT_EQ(10, write(fds[1], value.data(), 10));
+    ASSERT_EQ(10, Network::receive_argument_part(fds[0], argument, filled, remains));
+    ASSERT_EQ(Network::kReceiveChunk, argument.size());
+    ASSERT_EQ(10, filled);
+    ASSERT_EQ(value.size() - 10, remains);
+
+    ASSERT_EQ(-1, Network::receive_argument_part(fds[0], argument, filled, remains));
+    ASSERT_EQ(EAGAIN, errno);
+
+    close(fds[1]);
+    ASSERT_EQ(0, Network::receive_argument_part(fds[0], argument, filled, remains));
+    close(fds[0]);
+}
+
+TEST(TransferTest, SendResponsePart) {
+    int fds[2];
+    ASSERT_EQ(0, socketpair(AF_UNIX, SOCK_STREAM, 0, fds));
+    ASSERT_EQ(0, fcntl(fds[1], F_SETFL, O_NONBLOCK));
+
+    std::string value(4 << 20, 'v');
+    Execute::Response response;
+    response.Append("VALUE ", 6);
+    response.Append(Value(std::string(value)));
+
+    // Socket takes only a part of the large response, the rest is written once the peer reads
+    size_t sent = 0;
+    ASSERT_FALSE(Network::send_response_part(fds[1], response, sent));
+    ASSERT_LT(0, sent);
+    ASSERT_GT(response.Size(), sent);
+
+    std::string received;
+    char buffer[65536];
+    while (received.size() < response.Size()) {
+        ssize_t readed = read(fds[0], buffer, sizeof(buffer));
+        ASSERT_LT(0, readed);
+        received.append(buffer, readed);
+        if (sent < response.Size()) {
+            Network::send_response_part(fds[1], response, sent);
+        }
+    }
+    ASSERT_EQ(response.Size(), sent);
+    ASSERT_EQ("VALUE " + value, received);
+
+    close(fds[0]);
+    close(fds[1]);
+}
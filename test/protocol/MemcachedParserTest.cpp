@@ -1,12 +1,27 @@
 #include <gtest/gtest.h>
 
 #include <memory>
+#include <sstream>
 #include <string>
+#include <typeinfo>
 
+#include <afina/Hash.h>
 #include <afina/execute/Add.h>
+#include <afina/execute/AnyCommand.h>
+#include <afina/execute/Cas.h>
+#include <afina/execute/Decr.h>
+#include <afina/execute/FlushAll.h>
+#include <afina/execute/FlushNamespace.h>
+#include <afina/execute/Gat.h>
+#include <afina/execute/Gats.h>
 #include <afina/execute/Get.h>
+#include <afina/execute/Gets.h>
+#include <afina/execute/Incr.h>
+#include <afina/execute/Prepend.h>
+#include <afina/execute/Replace.h>
 #include <afina/execute/Set.h>
 #include <afina/execute/Stats.h>
+#include <afina/execute/Touch.h>
 
 #include <protocol/Parser.h>
 
@@ -58,6 +73,163 @@ TEST(MemcachedParserTest, SimpleAdd) {
     ASSERT_EQ(-1, tmp->expire());
 }
 
+// Verify replace and prepend commands are built
+TEST(MemcachedParserTest, ReplacePrepend) {
+    Protocol::Parser parser;
+
+    size_t consumed = 0;
+    ASSERT_TRUE(parser.Parse("replace foo 0 0 3\r\n", consumed));
+    ASSERT_EQ("replace", parser.Name());
+
+    size_t value_size;
+    std::unique_ptr<Execute::Command> cmd = parser.Build(value_size);
+    ASSERT_TRUE(dynamic_cast<Execute::Replace *>(cmd.get()) != nullptr);
+    ASSERT_EQ(3, value_size);
+
+    parser.Reset();
+    ASSERT_TRUE(parser.Parse("prepend bar 0 0 5\r\n", consumed));
+    cmd = parser.Build(value_size);
+    ASSERT_TRUE(dynamic_cast<Execute::Prepend *>(cmd.get()) != nullptr);
+    ASSERT_EQ("bar", static_cast<Execute::Prepend *>(cmd.get())->key());
+    ASSERT_EQ(5, value_size);
+}
+
+TEST(MemcachedParserTest, IncrDecr) {
+    Protocol::Parser parser;
+
+    size_t consumed = 0;
+    ASSERT_TRUE(parser.Parse("incr foo 18446744073709551615\r\n", consumed));
+    ASSERT_EQ(31, consumed);
+
+    size_t value_size;
+    std::unique_ptr<Execute::Command> cmd = parser.Build(value_size);
+    Execute::Incr *incr = dynamic_cast<Execute::Incr *>(cmd.get());
+    ASSERT_TRUE(incr != nullptr);
+    ASSERT_EQ("foo", incr->key());
+    ASSERT_EQ(UINT64_MAX, incr->delta());
+    ASSERT_EQ(0, value_size);
+
+    parser.Reset();
+    ASSERT_TRUE(parser.Parse("decr bar 5\r\n", consumed));
+    cmd = parser.Build(value_size);
+    ASSERT_TRUE(dynamic_cast<Execute::Decr *>(cmd.get()) != nullptr);
+    ASSERT_EQ(5, static_cast<Execute::Decr *>(cmd.get())->delta());
+
+    parser.Reset();
+    ASSERT_THROW(parser.Parse("incr foo 18446744073709551616\r\n", consumed), std::runtime_error);
+    parser.Reset();
+    ASSERT_THROW(parser.Parse("incr foo -1\r\n", consumed), std::runtime_error);
+    parser.Reset();
+    ASSERT_THROW(parser.Parse("decr foo\r\n", consumed), std::runtime_error);
+}
+
+TEST(MemcachedParserTest, GetsCas) {
+    Protocol::Parser parser;
+
+    size_t consumed = 0;
+    ASSERT_TRUE(parser.Parse("gets foo bar\r\n", consumed));
+    size_t value_size;
+    std::unique_ptr<Execute::Command> cmd = parser.Build(value_size);
+    Execute::Gets *gets = dynamic_cast<Execute::Gets *>(cmd.get());
+    ASSERT_TRUE(gets != nullptr);
+    ASSERT_EQ(2, gets->keys().size());
+
+    parser.Reset();
+    ASSERT_TRUE(parser.Parse("cas foo 0 100 3 18446744073709551615\r\nbar\r\n", consumed));
+    ASSERT_EQ(38, consumed);
+    cmd = parser.Build(value_size);
+    Execute::Cas *cas = dynamic_cast<Execute::Cas *>(cmd.get());
+    ASSERT_TRUE(cas != nullptr);
+    ASSERT_EQ("foo", cas->key());
+    ASSERT_EQ(100, cas->expire());
+    ASSERT_EQ(UINT64_MAX, cas->version());
+    ASSERT_EQ(3, value_size);
+
+    parser.Reset();
+    ASSERT_THROW(parser.Parse("cas foo 0 0 3\r\n", consumed), std::runtime_error);
+    parser.Reset();
+    ASSERT_THROW(parser.Parse("cas foo 0 0 3 18446744073709551616\r\n", consumed), std::runtime_error);
+}
+
+TEST(MemcachedParserTest, TouchGat) {
+    Protocol::Parser parser;
+
+    size_t consumed = 0;
+    ASSERT_TRUE(parser.Parse("touch foo -100\r\n", consumed));
+    size_t value_size;
+    std::unique_ptr<Execute::Command> cmd = parser.Build(value_size);
+    Execute::Touch *touch = dynamic_cast<Execute::Touch *>(cmd.get());
+    ASSERT_TRUE(touch != nullptr);
+    ASSERT_EQ("foo", touch->key());
+    ASSERT_EQ(-100, touch->expire());
+    ASSERT_EQ(0, value_size);
+
+    parser.Reset();
+    ASSERT_TRUE(parser.Parse("gat 3600 foo bar\r\n", consumed));
+    cmd = parser.Build(value_size);
+    Execute::Gat *gat = dynamic_cast<Execute::Gat *>(cmd.get());
+    ASSERT_TRUE(gat != nullptr);
+    ASSERT_TRUE(dynamic_cast<Execute::Gats *>(cmd.get()) == nullptr);
+    ASSERT_EQ(3600, gat->expire());
+    ASSERT_EQ(std::vector<std::string>({"foo", "bar"}), gat->keys());
+
+    parser.Reset();
+    ASSERT_TRUE(parser.Parse("gats 0 foo\r\n", consumed));
+    cmd = parser.Build(value_size);
+    ASSERT_TRUE(dynamic_cast<Execute::Gats *>(cmd.get()) != nullptr);
+
+    parser.Reset();
+    ASSERT_THROW(parser.Parse("touch foo\r\n", consumed), std::runtime_error);
+}
+
+TEST(MemcachedParserTest, Flush) {
+    Protocol::Parser parser;
+
+    size_t consumed = 0;
+    ASSERT_TRUE(parser.Parse("flush_all\r\n", consumed));
+    ASSERT_EQ(11, consumed);
+    size_t value_size;
+    std::unique_ptr<Execute::Command> cmd = parser.Build(value_size);
+    Execute::FlushAll *flush = dynamic_cast<Execute::FlushAll *>(cmd.get());
+    ASSERT_TRUE(flush != nullptr);
+    ASSERT_EQ(0, flush->delay());
+    ASSERT_EQ(0, value_size);
+
+    parser.Reset();
+    ASSERT_TRUE(parser.Parse("flush_all 60\r\n", consumed));
+    cmd = parser.Build(value_size);
+    flush = dynamic_cast<Execute::FlushAll *>(cmd.get());
+    ASSERT_TRUE(flush != nullptr);
+    ASSERT_EQ(60, flush->delay());
+
+    parser.Reset();
+    ASSERT_TRUE(parser.Parse("flush_ns users sessions\r\n", consumed));
+    cmd = parser.Build(value_size);
+    Execute::FlushNamespace *flush_ns = dynamic_cast<Execute::FlushNamespace *>(cmd.get());
+    ASSERT_TRUE(flush_ns != nullptr);
+    ASSERT_EQ(std::vector<std::string>({"users", "sessions"}), flush_ns->namespaces());
+
+    parser.Reset();
+    ASSERT_THROW(parser.Parse("flush_ns\r\n", consumed), std::runtime_error);
+}
+
+// Verify multi digit expire time
+TEST(MemcachedParserTest, SetExpire) {
+    Protocol::Parser parser;
+
+    size_t consumed = 0;
+    bool cmd_avail = parser.Parse("set foo 0 3600 6\r\nfooval\r\n", consumed);
+    ASSERT_TRUE(cmd_avail);
+    ASSERT_EQ(18, consumed);
+
+    size_t value_size;
+    std::unique_ptr<Execute::Command> cmd = parser.Build(value_size);
+    ASSERT_FALSE(cmd == nullptr);
+
+    Execute::Set *tmp = reinterpret_cast<Execute::Set *>(cmd.get());
+    ASSERT_EQ(3600, tmp->expire());
+}
+
 // Verify simple get command passed in a single string
 TEST(MemcachedParserTest, SimpleGet) {
     Protocol::Parser parser;
@@ -79,6 +251,13 @@ TEST(MemcachedParserTest, SimpleGet) {
     ASSERT_EQ("ke", keys[0]);
     ASSERT_EQ("key2", keys[1]);
     ASSERT_EQ("super_long_key", keys[2]);
+
+    // Keys are hashed once by the parser
+    std::vector<size_t> hashes = tmp->hashes();
+    ASSERT_EQ(3, hashes.size());
+    for (size_t i = 0; i < keys.size(); i++) {
+        ASSERT_EQ(Hash(keys[i]), hashes[i]);
+    }
 }
 
 TEST(MemcachedParserTest, Stats) {
@@ -98,3 +277,148 @@ TEST(MemcachedParserTest, Stats) {
     Execute::Stats *tmp = reinterpret_cast<Execute::Stats *>(cmd.get());
     ASSERT_FALSE(tmp == nullptr);
 }
+
+// Fields of the command as text, so that commands built by different paths of the parser could be compared
+static std::string Describe(const Execute::Command *cmd, size_t value_size) {
+    std::stringstream out;
+    out << typeid(*cmd).name() << " " << value_size;
+    if (auto insert = dynamic_cast<const Execute::InsertCommand *>(cmd)) {
+        out << " " << insert->key() << " " << insert->hash() << " " << insert->flags() << " " << insert->expire();
+    }
+    if (auto cas = dynamic_cast<const Execute::Cas *>(cmd)) {
+        out << " " << cas->version();
+    }
+    if (auto counter = dynamic_cast<const Execute::CounterCommand *>(cmd)) {
+        out << " " << counter->key() << " " << counter->hash() << " " << counter->delta();
+    }
+    if (auto get = dynamic_cast<const Execute::Get *>(cmd)) {
+        for (size_t i = 0; i < get->keys().size(); i++) {
+            out << " " << get->keys()[i] << " " << get->hashes()[i];
+        }
+    }
+    if (auto gat = dynamic_cast<const Execute::Gat *>(cmd)) {
+        out << " " << gat->expire();
+    }
+    if (auto touch = dynamic_cast<const Execute::Touch *>(cmd)) {
+        out << " " << touch->key() << " " << touch->expire();
+    }
+    if (auto flush = dynamic_cast<const Execute::FlushAll *>(cmd)) {
+        out << " " << flush->delay();
+    }
+    if (auto flush = dynamic_cast<const Execute::FlushNamespace *>(cmd)) {
+        for (const std::string &ns : flush->namespaces()) {
+            out << " " << ns;
+        }
+    }
+    return out.str();
+}
+
+// Verify that whole command line and the one split across reads are parsed the same way
+TEST(MemcachedParserTest, SplitMatchesWhole) {
+    std::vector<std::string> lines{
+        "set foo 0 0 6\r\n",
+        "add key_which_is_longer_than_thirty_two_bytes 4294967295 -2147483648 4294967295\r\n",
+        "replace foo 1 2147483647 3\r\n",
+        "append foo 0 -1 3\r\n",
+        "cas foo 0 100 3 18446744073709551615\r\n",
+        "incr foo 18446744073709551615\r\n",
+        "decr foo 0\r\n",
+        "get a b c d e f g h i j k l m n o p q r s t u v w x y z aa bb cc dd\r\n",
+        "gets foo\r\n",
+        "gat 3600 foo bar\r\n",
+        "gats -1 foo\r\n",
+        "touch foo 0\r\n",
+        "flush_all\r\n",
+        "flush_all 60\r\n",
+        "flush_ns users sessions\r\n",
+        "stats\r\n",
+        // Not well formed, but accepted by the state machine
+        "set foo 0 0 3 noreply\r\n",
+        "get foo  bar\r\n",
+        "set foo 1x 0 3\r\n",
+    };
+
+    for (const std::string &line : lines) {
+        Protocol::Parser whole;
+        size_t consumed = 0;
+        ASSERT_TRUE(whole.Parse(line + "value\r\n", consumed)) << line;
+        ASSERT_EQ(line.size(), consumed) << line;
+
+        Protocol::Parser split;
+        size_t total = 0;
+        bool done = false;
+        for (size_t i = 0; i < line.size() && !done; i++) {
+            done = split.Parse(&line[i], 1, consumed);
+            total += consumed;
+        }
+        ASSERT_TRUE(done) << line;
+        ASSERT_EQ(line.size(), total) << line;
+        ASSERT_EQ(whole.Name(), split.Name());
+
+        size_t whole_size, split_size;
+        std::unique_ptr<Execute::Command> whole_cmd = whole.Build(whole_size);
+        std::unique_ptr<Execute::Command> split_cmd = split.Build(split_size);
+        ASSERT_EQ(Describe(split_cmd.get(), split_size), Describe(whole_cmd.get(), whole_size)) << line;
+    }
+
+    // Errors are the same as well
+    for (const std::string &line : {"incr foo 18446744073709551616\r\n", "set foo 0 2147483648 3\r\n",
+                                    "unknown foo\r\n", "touch foo\r\n"}) {
+        Protocol::Parser parser;
+        size_t consumed = 0;
+        ASSERT_THROW(parser.Parse(line, consumed), std::runtime_error) << line;
+    }
+}
+
+// Verify that keys of the whole line point into the input and keys of the split one are copied
+TEST(MemcachedParserTest, KeysAreViews) {
+    Protocol::Parser parser;
+
+    const char input[] = "gets foo barbaz\r\n";
+    size_t consumed = 0;
+    ASSERT_TRUE(parser.Parse(input, sizeof(input) - 1, consumed));
+    ASSERT_EQ("gets", parser.Name());
+    ASSERT_EQ(2, parser.KeysCount());
+    ASSERT_EQ(input + 5, parser.Key(0).data);
+    ASSERT_EQ("foo", parser.Key(0).str());
+    ASSERT_EQ(input + 9, parser.Key(1).data);
+    ASSERT_EQ("barbaz", parser.Key(1).str());
+
+    parser.Reset();
+    ASSERT_FALSE(parser.Parse(input, 7, consumed));
+    ASSERT_EQ("", parser.Name());
+    ASSERT_TRUE(parser.Parse(input + 7, sizeof(input) - 8, consumed));
+    ASSERT_EQ("gets", parser.Name());
+    ASSERT_EQ(2, parser.KeysCount());
+    ASSERT_EQ("foo", parser.Key(0).str());
+    ASSERT_EQ("barbaz", parser.Key(1).str());
+    ASSERT_TRUE(parser.Key(1).data < input || parser.Key(1).data >= input + sizeof(input));
+}
+
+TEST(MemcachedParserTest, BuildInPlace) {
+    Protocol::Parser parser;
+    Execute::AnyCommand command;
+
+    size_t value_size = 0;
+    ASSERT_FALSE(parser.Build(command, value_size));
+    ASSERT_FALSE(command);
+
+    size_t consumed = 0;
+    ASSERT_TRUE(parser.Parse("set foo 1 0 3\r\n", consumed));
+    ASSERT_TRUE(parser.Build(command, value_size));
+    ASSERT_TRUE(command);
+    ASSERT_EQ(3, value_size);
+    ASSERT_EQ(typeid(Execute::Set), typeid(*command.get()));
+
+    // The same command object is reused for the next one
+    parser.Reset();
+    ASSERT_TRUE(parser.Parse("gets foo bar\r\n", consumed));
+    ASSERT_TRUE(parser.Build(command, value_size));
+    ASSERT_EQ(0, value_size);
+    ASSERT_EQ(typeid(Execute::Gets), typeid(*command.get()));
+
+    Execute::Gets *gets = static_cast<Execute::Gets *>(command.get());
+    ASSERT_EQ(2, gets->keys().size());
+    ASSERT_EQ("foo", gets->keys()[0]);
+    ASSERT_EQ("bar", gets->keys()[1]);
+}
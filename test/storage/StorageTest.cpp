@@ -1,16 +1,34 @@
 #include "gtest/gtest.h"
+#include <algorithm>
+#include <atomic>
+#include <chrono>
 #include <iomanip>
 #include <iostream>
+#include <memory>
 #include <set>
+#include <thread>
 #include <vector>
 
+#include <poll.h>
+#include <pthread.h>
+#include <sched.h>
+
 #include <afina/execute/Add.h>
 #include <afina/execute/Append.h>
 #include <afina/execute/Delete.h>
 #include <afina/execute/Get.h>
 #include <afina/execute/Set.h>
 
+#include "storage/ClockLRU.h"
+#include "storage/GlobalLock.h"
+#include "storage/OptimisticCuckoo.h"
+#include "storage/PerCoreStorage.h"
 #include "storage/SimpleLRU.h"
+#include "storage/StripedLockLRU.h"
+#include "storage/ThreadSafeSimpleLRU.h"
+#include "storage/TinyLFU.h"
+#include "storage/TwoQueue.h"
+#include "storage/TimingWheel.h"
 
 using namespace Afina::Backend;
 using namespace Afina::Execute;
@@ -195,3 +213,1197 @@ TEST(StorageTest, MaxTest) {
         EXPECT_FALSE(storage.Get(key, res));
     }
 }
+
+TEST(StorageTest, DeleteReinsertTest) {
+    const size_t length = 20;
+    SimpleLRU storage(2 * 10000 * length);
+
+    for (long i = 0; i < 10000; ++i) {
+        auto key = pad_space("Key " + std::to_string(i), length);
+        auto val = pad_space("Val " + std::to_string(i), length);
+        EXPECT_TRUE(storage.Put(key, val));
+    }
+
+    // Leaves a lot of tombstones in the index
+    for (long i = 0; i < 10000; i += 2) {
+        auto key = pad_space("Key " + std::to_string(i), length);
+        EXPECT_TRUE(storage.Delete(key));
+    }
+
+    for (long i = 0; i < 10000; ++i) {
+        auto key = pad_space("Key " + std::to_string(i), length);
+        auto val = pad_space("Val " + std::to_string(i), length);
+
+        std::string res;
+        if (i % 2 == 0) {
+            EXPECT_FALSE(storage.Get(key, res));
+            EXPECT_TRUE(storage.PutIfAbsent(key, val));
+        } else {
+            EXPECT_TRUE(storage.Get(key, res));
+            EXPECT_TRUE(val == res);
+        }
+    }
+
+    for (long i = 0; i < 10000; ++i) {
+        auto key = pad_space("Key " + std::to_string(i), length);
+        auto val = pad_space("Val " + std::to_string(i), length);
+
+        std::string res;
+        EXPECT_TRUE(storage.Get(key, res));
+        EXPECT_TRUE(val == res);
+    }
+}
+
+TEST(StorageTest, ResizeValue) {
+    SimpleLRU storage(8 * 1024 * 1024);
+
+    // Value grows out of its chunk, then shrinks back and finally doesn't fit into any size class
+    std::string value;
+    for (size_t size : {1, 100, 1000, 10, 100000, 2 * 1024 * 1024, 5}) {
+        std::string val(size, 'a' + size % 26);
+        EXPECT_TRUE(storage.Put("KEY1", val));
+        EXPECT_TRUE(storage.Put("KEY2", val));
+
+        EXPECT_TRUE(storage.Get("KEY1", value));
+        EXPECT_TRUE(value == val);
+    }
+
+    EXPECT_TRUE(storage.Delete("KEY1"));
+    EXPECT_FALSE(storage.Get("KEY1", value));
+    EXPECT_TRUE(storage.Get("KEY2", value));
+    EXPECT_TRUE(value == "fffff");
+}
+
+TEST(StorageTest, ClockSecondChance) {
+    const size_t length = 20;
+    ClockLRU storage(2 * 100 * length);
+
+    for (long i = 0; i < 100; ++i) {
+        auto key = pad_space("Key " + std::to_string(i), length);
+        auto val = pad_space("Val " + std::to_string(i), length);
+        EXPECT_TRUE(storage.Put(key, val));
+    }
+
+    // Referenced entries survive the next round of evictions
+    std::string res;
+    for (long i = 0; i < 100; i += 2) {
+        auto key = pad_space("Key " + std::to_string(i), length);
+        EXPECT_TRUE(storage.Get(key, res));
+    }
+
+    for (long i = 100; i < 150; ++i) {
+        auto key = pad_space("Key " + std::to_string(i), length);
+        auto val = pad_space("Val " + std::to_string(i), length);
+        EXPECT_TRUE(storage.Put(key, val));
+    }
+
+    for (long i = 0; i < 150; ++i) {
+        auto key = pad_space("Key " + std::to_string(i), length);
+        auto val = pad_space("Val " + std::to_string(i), length);
+        if (i < 100 && i % 2 == 1) {
+            EXPECT_FALSE(storage.Get(key, res));
+        } else {
+            EXPECT_TRUE(storage.Get(key, res));
+            EXPECT_TRUE(val == res);
+        }
+    }
+}
+
+TEST(StorageTest, ClockConcurrentGet) {
+    const size_t length = 20;
+    ClockLRU storage(2 * 1000 * length);
+
+    for (long i = 0; i < 1000; ++i) {
+        auto key = pad_space("Key " + std::to_string(i), length);
+        auto val = pad_space("Val " + std::to_string(i), length);
+        EXPECT_TRUE(storage.Put(key, val));
+    }
+
+    std::vector<std::thread> readers;
+    std::atomic<long> misses(0);
+    for (int t = 0; t < 4; t++) {
+        readers.emplace_back([&storage, &misses, length]() {
+            std::string res;
+            for (long i = 0; i < 1000; ++i) {
+                auto key = pad_space("Key " + std::to_string(i), length);
+                if (!storage.Get(key, res) || res != pad_space("Val " + std::to_string(i), length)) {
+                    misses++;
+                }
+            }
+        });
+    }
+    for (long i = 1000; i < 1100; ++i) {
+        auto key = pad_space("Key " + std::to_string(i), length);
+        storage.Set(key, "none");
+    }
+    for (auto &t : readers) {
+        t.join();
+    }
+    EXPECT_EQ(0, misses.load());
+}
+
+TEST(StorageTest, BufferedReadsKeepLRUOrder) {
+    ThreadSafeSimplLRU storage(3 * 8);
+    std::string res;
+    EXPECT_TRUE(storage.Put("KEY1", "val1"));
+    EXPECT_TRUE(storage.Put("KEY2", "val2"));
+    EXPECT_TRUE(storage.Put("KEY3", "val3"));
+
+    // Hits are applied before the next write, so KEY1 is the most recent one by then
+    for (int i = 0; i < 100; i++) {
+        EXPECT_TRUE(storage.Get("KEY1", res));
+    }
+    EXPECT_TRUE(storage.Put("KEY4", "val4"));
+
+    EXPECT_TRUE(storage.Get("KEY1", res));
+    EXPECT_FALSE(storage.Get("KEY2", res));
+    EXPECT_TRUE(storage.Get("KEY3", res));
+    EXPECT_TRUE(storage.Get("KEY4", res));
+}
+
+TEST(StorageTest, BufferedReadsConcurrentWrites) {
+    const size_t length = 20;
+    ThreadSafeSimplLRU storage(2 * 2 * 1000 * length);
+
+    for (long i = 0; i < 1000; ++i) {
+        auto key = pad_space("Key " + std::to_string(i), length);
+        auto val = pad_space("Val " + std::to_string(i), length);
+        EXPECT_TRUE(storage.Put(key, val));
+    }
+
+    std::vector<std::thread> readers;
+    std::atomic<long> misses(0);
+    for (int t = 0; t < 4; t++) {
+        readers.emplace_back([&storage, &misses, length]() {
+            std::string res;
+            for (int round = 0; round < 10; round++) {
+                for (long i = 0; i < 1000; ++i) {
+                    auto key = pad_space("Key " + std::to_string(i), length);
+                    if (!storage.Get(key, res) || res != pad_space("Val " + std::to_string(i), length)) {
+                        misses++;
+                    }
+                }
+            }
+        });
+    }
+
+    // Writers update entries and add new ones while readers are recording hits
+    for (long i = 0; i < 1000; ++i) {
+        auto key = pad_space("Key " + std::to_string(i), length);
+        EXPECT_TRUE(storage.Set(key, pad_space("Val " + std::to_string(i), length)));
+        key = pad_space("New " + std::to_string(i), length);
+        EXPECT_TRUE(storage.Put(key, pad_space("Val " + std::to_string(i), length)));
+    }
+    for (auto &t : readers) {
+        t.join();
+    }
+    EXPECT_EQ(0, misses.load());
+}
+
+TEST(StorageTest, CuckooBasic) {
+    OptimisticCuckoo storage(1024 * 1024);
+    std::string value;
+
+    EXPECT_TRUE(storage.PutIfAbsent("KEY1", "val1"));
+    EXPECT_FALSE(storage.PutIfAbsent("KEY1", "val2"));
+    EXPECT_FALSE(storage.Set("KEY2", "val2"));
+    EXPECT_TRUE(storage.Put("KEY2", "val2"));
+
+    // Grows out of the chunk
+    EXPECT_TRUE(storage.Set("KEY1", std::string(1000, 'a')));
+    EXPECT_TRUE(storage.Get("KEY1", value));
+    EXPECT_TRUE(value == std::string(1000, 'a'));
+
+    EXPECT_TRUE(storage.Delete("KEY2"));
+    EXPECT_FALSE(storage.Delete("KEY2"));
+    EXPECT_FALSE(storage.Get("KEY2", value));
+
+    // Items that don't fit into the pool page are rejected
+    EXPECT_FALSE(storage.Put("KEY3", std::string(2 * 1024 * 1024, 'a')));
+}
+
+TEST(StorageTest, CuckooEviction) {
+    const size_t length = 20;
+    OptimisticCuckoo storage(2 * 1000 * length);
+
+    // Much more keys than buckets could hold, displacement and eviction keep the budget
+    std::string res;
+    for (long i = 0; i < 5000; ++i) {
+        auto key = pad_space("Key " + std::to_string(i), length);
+        auto val = pad_space("Val " + std::to_string(i), length);
+        EXPECT_TRUE(storage.Put(key, val));
+        EXPECT_TRUE(storage.Get(key, res));
+        EXPECT_TRUE(val == res);
+    }
+
+    size_t found = 0;
+    for (long i = 0; i < 5000; ++i) {
+        auto key = pad_space("Key " + std::to_string(i), length);
+        if (storage.Get(key, res)) {
+            EXPECT_TRUE(res == pad_space("Val " + std::to_string(i), length));
+            found++;
+        }
+    }
+    EXPECT_LE(found, 1000);
+    EXPECT_GT(found, 0);
+}
+
+TEST(StorageTest, CuckooConcurrentGet) {
+    const size_t length = 20;
+    OptimisticCuckoo storage(2 * 1000 * length);
+
+    for (long i = 0; i < 500; ++i) {
+        auto key = pad_space("Key " + std::to_string(i), length);
+        auto val = pad_space("Val " + std::to_string(i), length);
+        EXPECT_TRUE(storage.Put(key, val));
+    }
+
+    // Readers never see value torn by the concurrent writer
+    std::atomic<bool> stop(false);
+    std::atomic<long> errors(0);
+    std::vector<std::thread> readers;
+    for (int t = 0; t < 4; t++) {
+        readers.emplace_back([&storage, &stop, &errors, length]() {
+            std::string res;
+            while (!stop.load()) {
+                for (long i = 0; i < 500; ++i) {
+                    auto key = pad_space("Key " + std::to_string(i), length);
+                    if (storage.Get(key, res) && res != pad_space("Val " + std::to_string(i), length) &&
+                        res != pad_space("Alt " + std::to_string(i), length) + "++") {
+                        errors++;
+                    }
+                }
+            }
+        });
+    }
+
+    for (int round = 0; round < 20; round++) {
+        for (long i = 0; i < 500; ++i) {
+            auto key = pad_space("Key " + std::to_string(i), length);
+            if (round % 2 == 0) {
+                storage.Put(key, pad_space("Alt " + std::to_string(i), length) + "++");
+            } else {
+                storage.Put(key, pad_space("Val " + std::to_string(i), length));
+            }
+        }
+    }
+    stop.store(true);
+    for (auto &t : readers) {
+        t.join();
+    }
+    EXPECT_EQ(0, errors.load());
+}
+
+TEST(StorageTest, TimingWheelLevels) {
+    const uint32_t start = 1000000;
+    TimingWheel wheel(start);
+
+    // One entry for every level and one beyond the wheel range
+    std::vector<uint32_t> delays = {0, 1, 63, 64, 100, 4095, 4096, 300000, 20000000, 40000000};
+    std::unique_ptr<Entry[]> entries(new Entry[delays.size()]());
+    for (size_t i = 0; i < delays.size(); i++) {
+        entries[i].expire_at = start + delays[i];
+        wheel.Schedule(entries[i]);
+    }
+
+    // Canceled entry never shows up
+    Entry canceled{};
+    canceled.expire_at = start + 10;
+    wheel.Schedule(canceled);
+    wheel.Cancel(canceled);
+    EXPECT_EQ(delays.size(), wheel.Size());
+
+    for (size_t i = 0; i < delays.size(); i++) {
+        uint32_t expire_at = start + delays[i];
+        if (delays[i] > 0) {
+            EXPECT_EQ(nullptr, wheel.Expired(expire_at - 1));
+        }
+        EXPECT_EQ(&entries[i], wheel.Expired(expire_at));
+        wheel.Cancel(entries[i]);
+        EXPECT_EQ(nullptr, wheel.Expired(expire_at));
+    }
+    EXPECT_EQ(0, wheel.Size());
+}
+
+TEST(StorageTest, ExpireLazily) {
+    uint32_t past = TimingWheel::Now() - 1;
+    uint32_t future = TimingWheel::Now() + 3600;
+
+    SimpleLRU lru(1024 * 1024);
+    ClockLRU clock(1024 * 1024);
+    OptimisticCuckoo cuckoo(1024 * 1024);
+    StripedLockLRU striped(1024 * 1024, 4);
+    for (Afina::Storage *storage : std::vector<Afina::Storage *>{&lru, &clock, &cuckoo, &striped}) {
+        std::string value;
+        EXPECT_TRUE(storage->Put("KEY1", "val1", past));
+        EXPECT_TRUE(storage->Put("KEY2", "val2", future));
+        EXPECT_TRUE(storage->Put("KEY3", "val3", past));
+
+        EXPECT_FALSE(storage->Get("KEY1", value));
+        EXPECT_TRUE(storage->Get("KEY2", value));
+        EXPECT_TRUE(value == "val2");
+
+        // Expired key is absent for every operation
+        EXPECT_FALSE(storage->Set("KEY1", "val1"));
+        EXPECT_FALSE(storage->Delete("KEY3"));
+        EXPECT_TRUE(storage->PutIfAbsent("KEY3", "val3"));
+        EXPECT_TRUE(storage->Get("KEY3", value));
+        EXPECT_TRUE(value == "val3");
+
+        // TTL could be changed by the update
+        EXPECT_TRUE(storage->Set("KEY2", "val2", past));
+        EXPECT_FALSE(storage->Get("KEY2", value));
+    }
+}
+
+TEST(StorageTest, ExpireOnWrite) {
+    const size_t length = 20;
+    SimpleLRU storage(2 * 100 * length);
+    uint32_t now = TimingWheel::Now();
+
+    // Oldest entry would be evicted first unless expired ones were reclaimed
+    EXPECT_TRUE(storage.Put(pad_space("Key", length), pad_space("Val", length)));
+    for (long i = 0; i < 99; ++i) {
+        auto key = pad_space("Key " + std::to_string(i), length);
+        EXPECT_TRUE(storage.Put(key, pad_space("Val", length), now - 1));
+    }
+    for (long i = 100; i < 199; ++i) {
+        auto key = pad_space("Key " + std::to_string(i), length);
+        EXPECT_TRUE(storage.Put(key, pad_space("Val", length)));
+    }
+
+    std::string res;
+    EXPECT_TRUE(storage.Get(pad_space("Key", length), res));
+}
+
+TEST(StorageTest, ExpireInBackground) {
+    const size_t length = 20;
+    ThreadSafeSimplLRU lru(2 * 100 * length);
+    ClockLRU clock(2 * 100 * length);
+    OptimisticCuckoo cuckoo(2 * 100 * length);
+
+    uint32_t expire_at = TimingWheel::Now() + 1;
+    for (long i = 0; i < 100; ++i) {
+        auto key = pad_space("Key " + std::to_string(i), length);
+        auto val = pad_space("Val " + std::to_string(i), length);
+        EXPECT_TRUE(lru.Put(key, val, expire_at));
+        EXPECT_TRUE(clock.Put(key, val, expire_at));
+        EXPECT_TRUE(cuckoo.Put(key, val, expire_at));
+    }
+
+    lru.Start();
+    clock.Start();
+    cuckoo.Start();
+    std::this_thread::sleep_for(std::chrono::milliseconds(2500));
+    lru.Stop();
+    clock.Stop();
+    cuckoo.Stop();
+
+    // Nothing left for the sweep
+    EXPECT_FALSE(lru.Sweep(1));
+    EXPECT_FALSE(clock.Sweep(1));
+    EXPECT_FALSE(cuckoo.Sweep(1));
+}
+
+TEST(StorageTest, TinyLFUBasic) {
+    GlobalLock<TinyLFU> storage(1024 * 1024);
+    std::string value;
+
+    EXPECT_TRUE(storage.PutIfAbsent("KEY1", "val1"));
+    EXPECT_FALSE(storage.PutIfAbsent("KEY1", "val2"));
+    EXPECT_TRUE(storage.Get("KEY1", value));
+    EXPECT_TRUE(storage.Set("KEY1", std::string(1000, 'a')));
+    EXPECT_TRUE(storage.Get("KEY1", value));
+    EXPECT_TRUE(value == std::string(1000, 'a'));
+    EXPECT_TRUE(storage.Delete("KEY1"));
+    EXPECT_FALSE(storage.Get("KEY1", value));
+}
+
+TEST(StorageTest, TinyLFUScanResistance) {
+    const size_t length = 20;
+    TinyLFU storage(2 * 100 * length);
+
+    // Frequently used keys fill the cache
+    std::string res;
+    for (int round = 0; round < 5; round++) {
+        for (long i = 0; i < 90; ++i) {
+            auto key = pad_space("Hot " + std::to_string(i), length);
+            if (!storage.Get(key, res)) {
+                EXPECT_TRUE(storage.Put(key, pad_space("Val " + std::to_string(i), length)));
+            }
+        }
+    }
+
+    // Scan of keys used only once doesn't push them out
+    for (long i = 0; i < 1000; ++i) {
+        auto key = pad_space("Scan " + std::to_string(i), length);
+        EXPECT_TRUE(storage.Put(key, pad_space("Val " + std::to_string(i), length)));
+    }
+
+    size_t hot = 0;
+    for (long i = 0; i < 90; ++i) {
+        if (storage.Get(pad_space("Hot " + std::to_string(i), length), res)) {
+            EXPECT_TRUE(res == pad_space("Val " + std::to_string(i), length));
+            hot++;
+        }
+    }
+    EXPECT_GE(hot, 70);
+}
+
+TEST(StorageTest, TwoQueueGrowthKeepsQueue) {
+    TwoQueue storage(1000);
+    EXPECT_TRUE(storage.Put("a", std::string(10, 'a')));
+    for (int i = 0; i < 8; i++) {
+        EXPECT_TRUE(storage.Put("k" + std::to_string(i), std::string(98, 'k')));
+    }
+
+    // Entry at the tail of A1in grows under memory pressure, it is chosen as victim but must not leave a ghost
+    // behind, otherwise it would be promoted into Am on its way back
+    EXPECT_TRUE(storage.Put("a", std::string(200, 'a')));
+    std::string value;
+    EXPECT_TRUE(storage.Get("a", value));
+    EXPECT_EQ(std::string(200, 'a'), value);
+
+    // So it is still in A1in and scan pushes it out as any other entry of A1in
+    for (int i = 0; i < 20; i++) {
+        EXPECT_TRUE(storage.Put("s" + std::to_string(i), std::string(98, 's')));
+    }
+    EXPECT_FALSE(storage.Get("a", value));
+}
+
+TEST(StorageTest, TwoQueueScanResistance) {
+    const size_t length = 20;
+    const size_t max_size = 4 * 200 * 2 * length;
+    std::unique_ptr<StripedLockLRU> storage(StripedLockLRU::create_striped_lock_lru(
+        max_size, 4, [](size_t size) { return new GlobalLock<TwoQueue>(size); }));
+
+    // Hot keys come back after eviction by the unique ones, so they get into the main queue
+    std::string res;
+    for (int round = 0; round < 10; round++) {
+        for (long i = 0; i < 100; ++i) {
+            auto key = pad_space("Hot " + std::to_string(i), length);
+            if (!storage->Get(key, res)) {
+                EXPECT_TRUE(storage->Put(key, pad_space("Val " + std::to_string(i), length)));
+            }
+        }
+        for (long i = 0; i < 200; ++i) {
+            auto key = pad_space("Once " + std::to_string(round * 200 + i), length);
+            EXPECT_TRUE(storage->Put(key, pad_space("Val " + std::to_string(i), length)));
+        }
+    }
+
+    // Scan flows through the FIFO queue only
+    for (long i = 0; i < 1000; ++i) {
+        auto key = pad_space("Scan " + std::to_string(i), length);
+        EXPECT_TRUE(storage->Put(key, pad_space("Val " + std::to_string(i), length)));
+    }
+
+    size_t hot = 0;
+    for (long i = 0; i < 100; ++i) {
+        if (storage->Get(pad_space("Hot " + std::to_string(i), length), res)) {
+            EXPECT_TRUE(res == pad_space("Val " + std::to_string(i), length));
+            hot++;
+        }
+    }
+    EXPECT_EQ(hot, 100);
+
+    Afina::StorageStats stats;
+    storage->GetStats(stats);
+    EXPECT_LE(stats.bytes, max_size);
+    EXPECT_EQ(stats.limit_maxbytes, max_size);
+}
+
+TEST(StorageTest, CoreLocalAlignment) {
+    Afina::Concurrency::CoreLocal<std::atomic<int>> counters;
+    ASSERT_EQ(Afina::Concurrency::CoreLocal<int>::Cores(), counters.Size());
+    for (size_t i = 0; i < counters.Size(); i++) {
+        // Each instance starts its own cache line, so cores never share one
+        EXPECT_EQ(0, reinterpret_cast<uintptr_t>(&counters.Get(i)) % 64);
+    }
+    if (counters.Size() > 1) {
+        EXPECT_EQ(64, reinterpret_cast<char *>(&counters.Get(1)) - reinterpret_cast<char *>(&counters.Get(0)));
+    }
+}
+
+TEST(StorageTest, PerCoreConcurrent) {
+    const size_t length = 20;
+    PerCoreStorage storage(2 * 4 * 1000 * length);
+
+    // Every request is handed off to the owner of its shard, callers race on the mailboxes
+    std::vector<std::thread> workers;
+    std::atomic<long> errors(0);
+    for (int t = 0; t < 4; t++) {
+        workers.emplace_back([&storage, &errors, length, t]() {
+            std::string res;
+            for (long i = 0; i < 1000; ++i) {
+                auto key = pad_space("Key " + std::to_string(t) + " " + std::to_string(i), length);
+                auto val = pad_space("Val " + std::to_string(i), length);
+                if (!storage.Put(key, val) || !storage.Get(key, res) || res != val) {
+                    errors++;
+                }
+                if (i % 2 == 0 && !storage.Delete(key)) {
+                    errors++;
+                }
+            }
+        });
+    }
+    for (auto &t : workers) {
+        t.join();
+    }
+    EXPECT_EQ(0, errors.load());
+
+    Afina::StorageStats stats;
+    storage.GetStats(stats);
+    EXPECT_EQ(4 * 500, stats.curr_items);
+    EXPECT_EQ(4 * 1000, stats.get_hits);
+}
+
+TEST(StorageTest, PerCoreAttach) {
+    const size_t length = 20;
+    PerCoreStorage storage(1024 * 1024);
+
+    cpu_set_t allowed;
+    CPU_ZERO(&allowed);
+    ASSERT_EQ(0, sched_getaffinity(0, sizeof(allowed), &allowed));
+    const size_t n = CPU_COUNT(&allowed);
+
+    // Every core is taken over by the thread pinned to it, threads wait for each other and serve own core from
+    // the loop as a worker does
+    std::vector<std::thread> workers;
+    std::atomic<long> errors(0);
+    std::atomic<size_t> finished(0);
+    for (size_t core = 0; core < CPU_SETSIZE; core++) {
+        if (!CPU_ISSET(core, &allowed)) {
+            continue;
+        }
+        workers.emplace_back([&storage, &errors, &finished, n, length, core]() {
+            cpu_set_t cpus;
+            CPU_ZERO(&cpus);
+            CPU_SET(core, &cpus);
+            pthread_setaffinity_np(pthread_self(), sizeof(cpus), &cpus);
+
+            int fd = storage.Attach(core);
+            if (fd == -1 || storage.Attach(core) != -1) {
+                errors++;
+            }
+
+            std::string res;
+            for (long i = 0; i < 1000; ++i) {
+                auto key = pad_space("Key " + std::to_string(core) + " " + std::to_string(i), length);
+                auto val = pad_space("Val " + std::to_string(i), length);
+                if (!storage.Put(key, val) || !storage.Get(key, res) || res != val) {
+                    errors++;
+                }
+            }
+
+            finished++;
+            while (fd != -1 && finished.load() < n) {
+                struct pollfd event = {fd, POLLIN, 0};
+                if (poll(&event, 1, 1) > 0) {
+                    storage.Serve();
+                }
+            }
+            storage.Detach();
+        });
+    }
+    for (auto &t : workers) {
+        t.join();
+    }
+    EXPECT_EQ(0, errors.load());
+
+    // Cores are served by own threads again
+    std::string res;
+    EXPECT_TRUE(storage.Get(pad_space("Key 0 999", length), res) || !CPU_ISSET(0, &allowed));
+    Afina::StorageStats stats;
+    storage.GetStats(stats);
+    EXPECT_EQ(n * 1000, stats.curr_items);
+}
+
+TEST(StorageTest, HashSpreadsKeys) {
+    EXPECT_EQ(Afina::Hash("some key"), Afina::Hash(std::string("some key")));
+    EXPECT_NE(Afina::Hash(std::string("a", 1)), Afina::Hash(std::string("a\0", 2)));
+    EXPECT_NE(Afina::Hash("0123456789abcdef0"), Afina::Hash("0123456789abcdef1"));
+
+    // Every shard of 4 gets keys, both from low and high bits of the hash
+    size_t low[4] = {0}, high[4] = {0};
+    for (long i = 0; i < 4000; ++i) {
+        size_t hash = Afina::Hash("Key " + std::to_string(i));
+        low[hash & 3]++;
+        high[(hash >> 32) & 3]++;
+    }
+    for (int i = 0; i < 4; i++) {
+        EXPECT_GT(low[i], 800);
+        EXPECT_GT(high[i], 800);
+    }
+}
+
+TEST(StorageTest, PrecomputedHash) {
+    SimpleLRU lru(1024 * 1024);
+    ThreadSafeSimplLRU mt_lru(1024 * 1024);
+    ClockLRU clock(1024 * 1024);
+    OptimisticCuckoo cuckoo(1024 * 1024);
+    StripedLockLRU striped(1024 * 1024, 3);
+    GlobalLock<TwoQueue> two_queue(1024 * 1024);
+    PerCoreStorage per_core(1024 * 1024);
+    for (Afina::Storage *storage :
+         std::vector<Afina::Storage *>{&lru, &mt_lru, &clock, &cuckoo, &striped, &two_queue, &per_core}) {
+        std::string key = "KEY1", value;
+        size_t hash = Afina::Hash(key);
+        EXPECT_TRUE(storage->Put(key, hash, "val1"));
+        EXPECT_TRUE(storage->Get(key, value));
+        EXPECT_TRUE(value == "val1");
+        EXPECT_FALSE(storage->PutIfAbsent(key, hash, "val2"));
+        EXPECT_TRUE(storage->Set(key, hash, "val3"));
+        EXPECT_TRUE(storage->Get(key, hash, value));
+        EXPECT_TRUE(value == "val3");
+        EXPECT_TRUE(storage->Delete(key, hash));
+        EXPECT_FALSE(storage->Get(key, value));
+    }
+}
+
+TEST(StorageTest, HitRatioStats) {
+    SimpleLRU lru(1024 * 1024);
+    ClockLRU clock(1024 * 1024);
+    OptimisticCuckoo cuckoo(1024 * 1024);
+    StripedLockLRU striped(1024 * 1024, 4);
+    TinyLFU lfu(1024 * 1024);
+    PerCoreStorage per_core(1024 * 1024);
+    for (Afina::Storage *storage :
+         std::vector<Afina::Storage *>{&lru, &clock, &cuckoo, &striped, &lfu, &per_core}) {
+        std::string value;
+        EXPECT_TRUE(storage->Put("KEY1", "val1"));
+        EXPECT_TRUE(storage->Put("KEY2", "val2"));
+        EXPECT_TRUE(storage->Get("KEY1", value));
+        EXPECT_TRUE(storage->Get("KEY1", value));
+        EXPECT_TRUE(storage->Get("KEY2", value));
+        EXPECT_FALSE(storage->Get("KEY3", value));
+
+        Afina::StorageStats stats;
+        storage->GetStats(stats);
+        EXPECT_EQ(3, stats.get_hits);
+        EXPECT_EQ(1, stats.get_misses);
+        EXPECT_EQ(2, stats.curr_items);
+        EXPECT_EQ(16, stats.bytes);
+        EXPECT_EQ(1024 * 1024, stats.limit_maxbytes);
+    }
+}
+
+TEST(StorageTest, ZeroCopyValue) {
+    SimpleLRU lru(1024 * 1024);
+    ThreadSafeSimplLRU mt_lru(1024 * 1024);
+    ClockLRU clock(1024 * 1024);
+    OptimisticCuckoo cuckoo(1024 * 1024);
+    StripedLockLRU striped(1024 * 1024, 3);
+    GlobalLock<TwoQueue> two_queue(1024 * 1024);
+    PerCoreStorage per_core(1024 * 1024);
+    for (Afina::Storage *storage :
+         std::vector<Afina::Storage *>{&lru, &mt_lru, &clock, &cuckoo, &striped, &two_queue, &per_core}) {
+        std::string key = "KEY1";
+        size_t hash = Afina::Hash(key);
+        std::string data(64 * 1024, 'x');
+        const char *buffer = data.data();
+
+        EXPECT_TRUE(storage->Put(key, hash, Afina::Value(std::move(data))));
+        Afina::Value value;
+        EXPECT_TRUE(storage->Get(key, hash, value));
+        EXPECT_EQ(buffer, value.data());
+        EXPECT_EQ(64 * 1024, value.size());
+
+        // Plain readers see the same bytes
+        std::string copy;
+        EXPECT_TRUE(storage->Get(key, copy));
+        EXPECT_TRUE(copy == value.str());
+
+        // Handle outlives the entry
+        EXPECT_TRUE(storage->Put(key, hash, Afina::Value(std::string(10, 'y'))));
+        EXPECT_EQ(buffer, value.data());
+        EXPECT_EQ(std::string(64 * 1024, 'x'), value.str());
+
+        Afina::Value small;
+        EXPECT_TRUE(storage->Get(key, hash, small));
+        EXPECT_EQ("yyyyyyyyyy", small.str());
+        EXPECT_TRUE(storage->Delete(key, hash));
+        EXPECT_FALSE(storage->Get(key, hash, small));
+    }
+}
+
+TEST(StorageTest, CuckooConcurrentSharedValues) {
+    OptimisticCuckoo storage(1024 * 1024);
+    const std::string key = "KEY1";
+    const size_t hash = Afina::Hash(key);
+    EXPECT_TRUE(storage.Put(key, hash, Afina::Value(std::string(8 * 1024, 'a'))));
+
+    // Readers share buffers the writer keeps releasing, every handle must stay whole until it is dropped
+    std::atomic<bool> stop(false);
+    std::atomic<long> errors(0);
+    auto whole = [](const std::string &data) {
+        return data.size() >= 4096 && data.find_first_not_of(data[0]) == std::string::npos;
+    };
+    std::vector<std::thread> readers;
+    for (int t = 0; t < 3; t++) {
+        readers.emplace_back([&]() {
+            while (!stop.load()) {
+                Afina::Value value;
+                std::string copy;
+                if (!storage.Get(key, hash, value) || !storage.Get(key, copy) || !whole(value.str()) ||
+                    !whole(copy)) {
+                    errors++;
+                }
+            }
+        });
+    }
+
+    for (int i = 0; i < 2000; i++) {
+        // Values larger than a pool page are kept external even when given by copy
+        if (i % 2 == 0) {
+            EXPECT_TRUE(storage.Put(key, hash, Afina::Value(std::string(8 * 1024 + i, 'a' + i % 26))));
+        } else {
+            EXPECT_TRUE(storage.Put(key, hash, std::string(64 * 1024 + i, 'a' + i % 26)));
+        }
+    }
+    stop = true;
+    for (auto &t : readers) {
+        t.join();
+    }
+    EXPECT_EQ(0, errors.load());
+}
+
+TEST(StorageTest, ZeroCopyEviction) {
+    SimpleLRU storage(3 * 8 * 1024);
+    std::vector<Afina::Value> held;
+    for (int i = 0; i < 16; i++) {
+        std::string key = "KEY" + std::to_string(i);
+        EXPECT_TRUE(storage.Put(key, Afina::Hash(key), Afina::Value(std::string(8 * 1024 - 8, 'a' + i))));
+
+        Afina::Value value;
+        EXPECT_TRUE(storage.Get(key, Afina::Hash(key), value));
+        held.push_back(value);
+    }
+
+    Afina::StorageStats stats;
+    storage.GetStats(stats);
+    EXPECT_LE(stats.bytes, 3 * 8 * 1024);
+    EXPECT_EQ(13, stats.evictions);
+    for (int i = 0; i < 16; i++) {
+        EXPECT_EQ(std::string(8 * 1024 - 8, 'a' + i), held[i].str());
+    }
+}
+
+TEST(StorageTest, MultiGet) {
+    SimpleLRU lru(1024 * 1024);
+    ThreadSafeSimplLRU mt_lru(1024 * 1024);
+    ClockLRU clock(1024 * 1024);
+    OptimisticCuckoo cuckoo(1024 * 1024);
+    StripedLockLRU striped(1024 * 1024, 4);
+    GlobalLock<TwoQueue> two_queue(1024 * 1024);
+    PerCoreStorage per_core(1024 * 1024);
+    for (Afina::Storage *storage :
+         std::vector<Afina::Storage *>{&lru, &mt_lru, &clock, &cuckoo, &striped, &two_queue, &per_core}) {
+        std::vector<std::string> keys;
+        std::vector<size_t> hashes;
+        for (int i = 0; i < 100; i++) {
+            keys.push_back("KEY" + std::to_string(i));
+            hashes.push_back(Afina::Hash(keys.back()));
+            if (i % 3 != 0) {
+                EXPECT_TRUE(storage->Put(keys.back(), hashes.back(), std::string(i % 5, 'a' + i % 26)));
+            }
+        }
+
+        std::vector<Afina::Value> values;
+        EXPECT_EQ(66, storage->MultiGet(keys, hashes, values));
+        ASSERT_EQ(100, values.size());
+        for (int i = 0; i < 100; i++) {
+            // Found empty value is told apart from the missing one
+            EXPECT_EQ(i % 3 != 0, bool(values[i]));
+            EXPECT_EQ(std::string(i % 3 != 0 ? i % 5 : 0, 'a' + i % 26), values[i].str());
+        }
+
+        Afina::StorageStats stats;
+        storage->GetStats(stats);
+        EXPECT_EQ(66, stats.get_hits);
+        EXPECT_EQ(34, stats.get_misses);
+    }
+}
+
+TEST(StorageTest, AppendPrepend) {
+    SimpleLRU lru(1024 * 1024);
+    ThreadSafeSimplLRU mt_lru(1024 * 1024);
+    ClockLRU clock(1024 * 1024);
+    OptimisticCuckoo cuckoo(1024 * 1024);
+    StripedLockLRU striped(1024 * 1024, 4);
+    GlobalLock<TwoQueue> two_queue(1024 * 1024);
+    PerCoreStorage per_core(1024 * 1024);
+    std::vector<Afina::Storage *> storages{&lru, &mt_lru, &clock, &cuckoo, &striped, &two_queue, &per_core};
+
+    uint32_t soon = TimingWheel::Now() + 2;
+    for (Afina::Storage *storage : storages) {
+        std::string key = "KEY1", value;
+        size_t hash = Afina::Hash(key);
+        EXPECT_FALSE(storage->Append(key, hash, "tail"));
+        EXPECT_FALSE(storage->Prepend(key, hash, "head"));
+
+        // Value outgrows its chunk several times
+        std::string expected = "mid";
+        EXPECT_TRUE(storage->Put(key, hash, expected, soon));
+        for (int i = 0; i < 200; i++) {
+            std::string tail(i % 7 + 1, 'a' + i % 26);
+            EXPECT_TRUE(storage->Append(key, hash, tail));
+            expected += tail;
+        }
+        EXPECT_TRUE(storage->Prepend(key, hash, "head"));
+        expected = "head" + expected;
+
+        EXPECT_TRUE(storage->Get(key, value));
+        EXPECT_EQ(expected, value);
+
+        // Large value given by handle is external, it gets copied into entry by the first concatenation
+        std::string large(8 * 1024, 'x');
+        EXPECT_TRUE(storage->Put("KEY2", Afina::Hash("KEY2"), Afina::Value(std::string(large))));
+        EXPECT_TRUE(storage->Append("KEY2", Afina::Hash("KEY2"), "y"));
+        EXPECT_TRUE(storage->Prepend("KEY2", Afina::Hash("KEY2"), "z"));
+        EXPECT_TRUE(storage->Get("KEY2", value));
+        EXPECT_EQ("z" + large + "y", value);
+
+        Afina::StorageStats stats;
+        storage->GetStats(stats);
+        EXPECT_EQ(4 + expected.size() + 4 + large.size() + 2, stats.bytes);
+    }
+
+    // Concatenation keeps expiration time
+    std::this_thread::sleep_for(std::chrono::milliseconds(2100));
+    for (Afina::Storage *storage : storages) {
+        std::string value;
+        EXPECT_FALSE(storage->Get("KEY1", value));
+        EXPECT_FALSE(storage->Append("KEY1", Afina::Hash("KEY1"), "tail"));
+    }
+}
+
+TEST(StorageTest, ConcurrentAppend) {
+    ThreadSafeSimplLRU mt_lru(1024 * 1024);
+    ClockLRU clock(1024 * 1024);
+    OptimisticCuckoo cuckoo(1024 * 1024);
+    StripedLockLRU striped(1024 * 1024, 4);
+    PerCoreStorage per_core(1024 * 1024);
+    for (Afina::Storage *storage : std::vector<Afina::Storage *>{&mt_lru, &clock, &cuckoo, &striped, &per_core}) {
+        size_t hash = Afina::Hash("KEY1");
+        EXPECT_TRUE(storage->Put("KEY1", hash, ""));
+
+        // Appends don't lose each other's data
+        std::vector<std::thread> writers;
+        for (int t = 0; t < 4; t++) {
+            writers.emplace_back([storage, hash, t]() {
+                for (int i = 0; i < 500; i++) {
+                    storage->Append("KEY1", hash, std::string(1, 'a' + t));
+                }
+            });
+        }
+        for (auto &writer : writers) {
+            writer.join();
+        }
+
+        std::string value;
+        EXPECT_TRUE(storage->Get("KEY1", value));
+        ASSERT_EQ(2000, value.size());
+        for (char c = 'a'; c < 'a' + 4; c++) {
+            EXPECT_EQ(500, std::count(value.begin(), value.end(), c));
+        }
+    }
+}
+
+TEST(StorageTest, IncrDecr) {
+    SimpleLRU lru(1024 * 1024);
+    ThreadSafeSimplLRU mt_lru(1024 * 1024);
+    ClockLRU clock(1024 * 1024);
+    OptimisticCuckoo cuckoo(1024 * 1024);
+    StripedLockLRU striped(1024 * 1024, 4);
+    GlobalLock<TwoQueue> two_queue(1024 * 1024);
+    PerCoreStorage per_core(1024 * 1024);
+    std::vector<Afina::Storage *> storages{&lru, &mt_lru, &clock, &cuckoo, &striped, &two_queue, &per_core};
+
+    for (Afina::Storage *storage : storages) {
+        uint64_t counter = 0;
+        std::string value;
+        size_t hash = Afina::Hash("KEY1");
+        EXPECT_EQ(Afina::CounterStatus::NotFound, storage->Increment("KEY1", hash, 1, counter));
+
+        // Short text doesn't leave room for the counter, so it moves to another chunk
+        EXPECT_TRUE(storage->Put("KEY1", hash, "7"));
+        EXPECT_EQ(Afina::CounterStatus::Done, storage->Increment("KEY1", hash, 5, counter));
+        EXPECT_EQ(12, counter);
+        EXPECT_EQ(Afina::CounterStatus::Done, storage->Decrement("KEY1", hash, 2, counter));
+        EXPECT_EQ(10, counter);
+        EXPECT_TRUE(storage->Get("KEY1", value));
+        EXPECT_EQ("10", value);
+
+        // Decrement stops at zero, increment wraps around
+        EXPECT_EQ(Afina::CounterStatus::Done, storage->Decrement("KEY1", hash, 100, counter));
+        EXPECT_EQ(0, counter);
+        EXPECT_TRUE(storage->Put("KEY1", hash, "18446744073709551615"));
+        EXPECT_EQ(Afina::CounterStatus::Done, storage->Increment("KEY1", hash, 2, counter));
+        EXPECT_EQ(1, counter);
+
+        // Counter is text again for the concatenation
+        EXPECT_TRUE(storage->Append("KEY1", hash, "0"));
+        EXPECT_TRUE(storage->Get("KEY1", value));
+        EXPECT_EQ("10", value);
+        EXPECT_EQ(Afina::CounterStatus::Done, storage->Increment("KEY1", hash, 1, counter));
+        EXPECT_EQ(11, counter);
+
+        Afina::StorageStats stats;
+        storage->GetStats(stats);
+        EXPECT_EQ(4 + Entry::kCounterSize, stats.bytes);
+
+        size_t other = Afina::Hash("KEY2");
+        for (const std::string &text : {"", "12a", "-1", "18446744073709551616", "123456789012345678901"}) {
+            EXPECT_TRUE(storage->Put("KEY2", other, text));
+            EXPECT_EQ(Afina::CounterStatus::NotNumeric, storage->Increment("KEY2", other, 1, counter));
+            EXPECT_TRUE(storage->Get("KEY2", value));
+            EXPECT_EQ(text, value);
+        }
+    }
+}
+
+TEST(StorageTest, ConcurrentIncr) {
+    ThreadSafeSimplLRU mt_lru(1024 * 1024);
+    ClockLRU clock(1024 * 1024);
+    OptimisticCuckoo cuckoo(1024 * 1024);
+    StripedLockLRU striped(1024 * 1024, 4);
+    PerCoreStorage per_core(1024 * 1024);
+    for (Afina::Storage *storage : std::vector<Afina::Storage *>{&mt_lru, &clock, &cuckoo, &striped, &per_core}) {
+        size_t hash = Afina::Hash("KEY1");
+        EXPECT_TRUE(storage->Put("KEY1", hash, "0"));
+
+        // Updates don't lose each other, readers see decimal text all along
+        std::vector<std::thread> threads;
+        for (int t = 0; t < 4; t++) {
+            threads.emplace_back([storage, hash, t]() {
+                uint64_t counter;
+                for (int i = 0; i < 1000; i++) {
+                    if (t % 2 == 0) {
+                        storage->Increment("KEY1", hash, 3, counter);
+                    } else {
+                        std::string value;
+                        EXPECT_TRUE(storage->Get("KEY1", value));
+                        EXPECT_NE(std::string::npos, value.find_first_of("0123456789"));
+                    }
+                }
+            });
+        }
+        for (auto &thread : threads) {
+            thread.join();
+        }
+
+        std::string value;
+        EXPECT_TRUE(storage->Get("KEY1", value));
+        EXPECT_EQ("6000", value);
+    }
+}
+
+TEST(StorageTest, CompareAndSet) {
+    SimpleLRU lru(1024 * 1024);
+    ThreadSafeSimplLRU mt_lru(1024 * 1024);
+    ClockLRU clock(1024 * 1024);
+    OptimisticCuckoo cuckoo(1024 * 1024);
+    StripedLockLRU striped(1024 * 1024, 4);
+    GlobalLock<TwoQueue> two_queue(1024 * 1024);
+    PerCoreStorage per_core(1024 * 1024);
+    std::vector<Afina::Storage *> storages{&lru, &mt_lru, &clock, &cuckoo, &striped, &two_queue, &per_core};
+
+    std::vector<std::string> keys{"KEY1", "KEY2", "KEY3"};
+    std::vector<size_t> hashes{Afina::Hash("KEY1"), Afina::Hash("KEY2"), Afina::Hash("KEY3")};
+    for (Afina::Storage *storage : storages) {
+        EXPECT_EQ(Afina::CasStatus::NotFound, storage->CompareAndSet("KEY1", hashes[0], Afina::Value("a", 1), 0));
+        EXPECT_TRUE(storage->Put("KEY1", hashes[0], "v1"));
+        EXPECT_TRUE(storage->Put("KEY2", hashes[1], "v2"));
+
+        std::vector<Afina::Value> values;
+        std::vector<uint64_t> versions;
+        EXPECT_EQ(2, storage->MultiGets(keys, hashes, values, versions));
+        ASSERT_EQ(3, versions.size());
+        EXPECT_EQ("v1", values[0].str());
+        EXPECT_NE(0, versions[0]);
+        EXPECT_FALSE(values[2]);
+
+        // Every kind of update changes the version
+        uint64_t version = versions[0];
+        uint64_t counter;
+        EXPECT_TRUE(storage->Append("KEY1", hashes[0], "0"));
+        EXPECT_EQ(Afina::CasStatus::Exists, storage->CompareAndSet("KEY1", hashes[0], Afina::Value("x", 1), version));
+        storage->MultiGets(keys, hashes, values, versions);
+        EXPECT_NE(version, versions[0]);
+
+        EXPECT_TRUE(storage->Put("KEY2", hashes[1], "5"));
+        version = versions[1];
+        storage->MultiGets(keys, hashes, values, versions);
+        EXPECT_NE(version, versions[1]);
+        version = versions[1];
+        EXPECT_EQ(Afina::CounterStatus::Done, storage->Increment("KEY2", hashes[1], 1, counter));
+        EXPECT_EQ(Afina::CounterStatus::Done, storage->Increment("KEY2", hashes[1], 1, counter));
+        storage->MultiGets(keys, hashes, values, versions);
+        EXPECT_NE(version, versions[1]);
+        EXPECT_EQ("7", values[1].str());
+
+        // Version which is still the current one lets the value through once
+        version = versions[0];
+        EXPECT_EQ(Afina::CasStatus::Stored, storage->CompareAndSet("KEY1", hashes[0], Afina::Value("new", 3), version));
+        EXPECT_EQ(Afina::CasStatus::Exists, storage->CompareAndSet("KEY1", hashes[0], Afina::Value("old", 3), version));
+        std::string value;
+        EXPECT_TRUE(storage->Get("KEY1", value));
+        EXPECT_EQ("new", value);
+
+        EXPECT_EQ(Afina::CasStatus::NotStored, storage->CompareAndSet("KEY1", hashes[0],
+                                                                      Afina::Value(std::string(2 * 1024 * 1024, 'x')),
+                                                                      versions[0]));
+        EXPECT_TRUE(storage->Delete("KEY1", hashes[0]));
+        EXPECT_EQ(Afina::CasStatus::NotFound, storage->CompareAndSet("KEY1", hashes[0], Afina::Value("a", 1), 0));
+    }
+}
+
+TEST(StorageTest, ConcurrentCompareAndSet) {
+    ThreadSafeSimplLRU mt_lru(1024 * 1024);
+    ClockLRU clock(1024 * 1024);
+    OptimisticCuckoo cuckoo(1024 * 1024);
+    StripedLockLRU striped(1024 * 1024, 4);
+    PerCoreStorage per_core(1024 * 1024);
+    for (Afina::Storage *storage : std::vector<Afina::Storage *>{&mt_lru, &clock, &cuckoo, &striped, &per_core}) {
+        std::vector<std::string> keys{"KEY1"};
+        std::vector<size_t> hashes{Afina::Hash("KEY1")};
+        EXPECT_TRUE(storage->Put("KEY1", hashes[0], "0"));
+
+        // Read-modify-write loops don't lose each other's updates, counter updates go in between
+        std::vector<std::thread> threads;
+        for (int t = 0; t < 4; t++) {
+            threads.emplace_back([storage, &keys, &hashes]() {
+                std::vector<Afina::Value> values;
+                std::vector<uint64_t> versions;
+                for (int i = 0; i < 500; i++) {
+                    uint64_t counter;
+                    storage->Increment("KEY1", hashes[0], 1, counter);
+                    Afina::CasStatus status;
+                    do {
+                        ASSERT_EQ(1, storage->MultiGets(keys, hashes, values, versions));
+                        std::string next = std::to_string(std::stoull(values[0].str()) + 1);
+                        status = storage->CompareAndSet("KEY1", hashes[0], Afina::Value(std::move(next)), versions[0]);
+                    } while (status == Afina::CasStatus::Exists);
+                    ASSERT_EQ(Afina::CasStatus::Stored, status);
+                }
+            });
+        }
+        for (auto &thread : threads) {
+            thread.join();
+        }
+
+        std::string value;
+        EXPECT_TRUE(storage->Get("KEY1", value));
+        EXPECT_EQ("4000", value);
+    }
+}
+
+TEST(StorageTest, Touch) {
+    SimpleLRU lru(1024 * 1024);
+    ThreadSafeSimplLRU mt_lru(1024 * 1024);
+    ClockLRU clock(1024 * 1024);
+    OptimisticCuckoo cuckoo(1024 * 1024);
+    StripedLockLRU striped(1024 * 1024, 4);
+    GlobalLock<TwoQueue> two_queue(1024 * 1024);
+    PerCoreStorage per_core(1024 * 1024);
+    std::vector<Afina::Storage *> storages{&lru, &mt_lru, &clock, &cuckoo, &striped, &two_queue, &per_core};
+
+    uint32_t soon = TimingWheel::Now() + 2;
+    std::vector<std::string> keys{"KEY1", "KEY2", "KEY3"};
+    std::vector<size_t> hashes{Afina::Hash("KEY1"), Afina::Hash("KEY2"), Afina::Hash("KEY3")};
+    for (Afina::Storage *storage : storages) {
+        EXPECT_FALSE(storage->Touch("KEY1", hashes[0], 0));
+        EXPECT_TRUE(storage->Put("KEY1", hashes[0], "v1", soon));
+        EXPECT_TRUE(storage->Put("KEY2", hashes[1], "v2"));
+        EXPECT_TRUE(storage->Put("KEY3", hashes[2], "v3"));
+
+        std::vector<Afina::Value> values;
+        std::vector<uint64_t> versions;
+        storage->MultiGets(keys, hashes, values, versions);
+
+        // Value and its version are kept
+        Afina::Value value;
+        uint64_t version;
+        EXPECT_TRUE(storage->Touch("KEY1", hashes[0], 0));
+        EXPECT_TRUE(storage->GetAndTouch("KEY2", hashes[1], soon, value, version));
+        EXPECT_EQ("v2", value.str());
+        EXPECT_EQ(versions[1], version);
+        EXPECT_EQ(Afina::CasStatus::Stored,
+                  storage->CompareAndSet("KEY1", hashes[0], Afina::Value("v1", 2), versions[0], soon));
+        EXPECT_TRUE(storage->Touch("KEY1", hashes[0], 0));
+
+        // Time in the past expires key right away
+        EXPECT_TRUE(storage->Touch("KEY3", hashes[2], 1));
+        EXPECT_FALSE(storage->GetAndTouch("KEY3", hashes[2], 0, value, version));
+        EXPECT_FALSE(storage->Touch("KEY3", hashes[2], 0));
+    }
+
+    std::this_thread::sleep_for(std::chrono::milliseconds(2100));
+    for (Afina::Storage *storage : storages) {
+        std::string value;
+        EXPECT_TRUE(storage->Get("KEY1", value));
+        EXPECT_FALSE(storage->Get("KEY2", value));
+    }
+}
+
+TEST(StorageTest, Flush) {
+    SimpleLRU lru(1024 * 1024);
+    ThreadSafeSimplLRU mt_lru(1024 * 1024);
+    ClockLRU clock(1024 * 1024);
+    OptimisticCuckoo cuckoo(1024 * 1024);
+    StripedLockLRU striped(1024 * 1024, 4);
+    GlobalLock<TwoQueue> two_queue(1024 * 1024);
+    PerCoreStorage per_core(1024 * 1024);
+    std::vector<Afina::Storage *> storages{&lru, &mt_lru, &clock, &cuckoo, &striped, &two_queue, &per_core};
+
+    for (Afina::Storage *storage : storages) {
+        EXPECT_TRUE(storage->Put("ns:KEY1", "v1"));
+        EXPECT_TRUE(storage->Put("ns:KEY2", "v2"));
+        EXPECT_TRUE(storage->Put("other:KEY1", "v3"));
+        EXPECT_TRUE(storage->Put("KEY1", "v4"));
+
+        std::string value;
+        storage->FlushNamespace("ns");
+        EXPECT_FALSE(storage->Get("ns:KEY1", value));
+        EXPECT_FALSE(storage->Get("ns:KEY2", value));
+        EXPECT_TRUE(storage->Get("other:KEY1", value));
+        EXPECT_TRUE(storage->Get("KEY1", value));
+
+        // Keys written after the flush are kept
+        EXPECT_TRUE(storage->PutIfAbsent("ns:KEY1", "v5"));
+        EXPECT_TRUE(storage->Get("ns:KEY1", value));
+        EXPECT_EQ("v5", value);
+
+        storage->FlushAll();
+        EXPECT_FALSE(storage->Get("ns:KEY1", value));
+        EXPECT_FALSE(storage->Get("other:KEY1", value));
+        EXPECT_FALSE(storage->Set("KEY1", "v6"));
+        EXPECT_FALSE(storage->Append("KEY1", Afina::Hash("KEY1"), "v6"));
+        uint64_t counter;
+        EXPECT_EQ(Afina::CounterStatus::NotFound, storage->Increment("KEY1", Afina::Hash("KEY1"), 1, counter));
+        EXPECT_FALSE(storage->Delete("KEY1"));
+
+        EXPECT_TRUE(storage->Put("KEY1", "v7"));
+        EXPECT_TRUE(storage->Get("KEY1", value));
+        EXPECT_EQ("v7", value);
+    }
+
+    // Delayed flush takes keys written before its time
+    uint32_t soon = TimingWheel::Now() + 2;
+    for (Afina::Storage *storage : storages) {
+        storage->FlushAll(soon);
+        EXPECT_TRUE(storage->Put("KEY2", "v8"));
+        std::string value;
+        EXPECT_TRUE(storage->Get("KEY1", value));
+    }
+
+    std::this_thread::sleep_for(std::chrono::milliseconds(2100));
+    for (Afina::Storage *storage : storages) {
+        std::string value;
+        EXPECT_FALSE(storage->Get("KEY1", value));
+        EXPECT_FALSE(storage->Get("KEY2", value));
+        EXPECT_TRUE(storage->Put("KEY2", "v9"));
+        EXPECT_TRUE(storage->Get("KEY2", value));
+    }
+}